@@ -14,16 +14,21 @@ if not exist build mkdir build
 
 :: Compile the library
 echo Compiling library...
-g++ -std=c++17 -O2 -Iinclude -c src/parser.cpp -o build/parser.o
-if errorlevel 1 (
-    echo Compilation failed!
-    pause
-    exit /b 1
+for %%f in (src\*.cpp) do (
+    g++ -std=c++17 -O2 -Iinclude -c %%f -o build\%%~nf.o || goto compile_failed
 )
+goto compile_done
+
+:compile_failed
+echo Compilation failed!
+pause
+exit /b 1
+
+:compile_done
 
 :: Create static library
 echo Creating library...
-ar rcs build/libpgn.a build/parser.o
+ar rcs build/libpgn.a build/*.o
 
 :: Build examples
 echo Building examples...
@@ -0,0 +1,116 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <fstream>
+#include <cstdio>
+#include <cstdint>
+#include <thread>
+#include <functional>
+#include <pgn/parser.hpp>
+
+// Builds a synthetic database with many players and tournaments, so the
+// per-player maps dominate the analysis.
+void write_synthetic_file(const std::string& filename, int games, int players, int tournaments) {
+    std::ofstream out(filename, std::ios::binary);
+    static const char* results[] = {"1-0", "0-1", "1/2-1/2", "*"};
+    
+    uint64_t state = 42;
+    auto next = [&state](int bound) {
+        state = state * 6364136223846793005ull + 1442695040888963407ull;
+        return static_cast<int>((state >> 33) % static_cast<uint64_t>(bound));
+    };
+    
+    for (int i = 0; i < games; ++i) {
+        int white = next(players);
+        int black = (white + 1 + next(players - 1)) % players;
+        const char* result = results[next(4)];
+        out << "[Event \"Event " << next(tournaments) << "\"]\n"
+            << "[Site \"Online\"]\n"
+            << "[Date \"2024.01.01\"]\n"
+            << "[Round \"" << (i % 9 + 1) << "\"]\n"
+            << "[White \"Player " << white << "\"]\n"
+            << "[Black \"Player " << black << "\"]\n"
+            << "[Result \"" << result << "\"]\n"
+            << "[ECO \"B" << (10 + next(90)) << "\"]\n\n"
+            << "1. e4 c5 2. Nf3 d6 3. d4 cxd4 " << result << "\n\n";
+    }
+}
+
+// Order-sensitive digest of everything analyze_data produces, used to check
+// that every thread count gives the serial result.
+uint64_t fingerprint(const pgn::DatabaseStats& stats) {
+    uint64_t hash = 14695981039346656037ull;
+    auto mix = [&hash](uint64_t value) {
+        hash = (hash ^ value) * 1099511628211ull;
+    };
+    
+    mix(stats.white_wins);
+    mix(stats.black_wins);
+    mix(stats.draws);
+    mix(stats.unknown_results);
+    mix(stats.most_active_player.id());
+    mix(stats.largest_tournament.id());
+    for (pgn::Symbol name : stats.player_names) {
+        const pgn::PlayerStats& player = stats.player_stats.at(name);
+        mix(player.total_games);
+        mix(player.wins);
+        mix(player.losses);
+        mix(player.draws);
+        for (pgn::Symbol opponent : player.opponents) mix(opponent.id());
+        // Map iteration order is unspecified, so fold the openings commutatively.
+        uint64_t openings = 0;
+        for (const auto& [eco, count] : player.opening_frequency) openings += eco.id() * 31ull + count;
+        mix(openings);
+    }
+    for (pgn::Symbol name : stats.tournament_names) {
+        const pgn::Tournament& tournament = stats.tournaments.at(name);
+        mix(tournament.total_games);
+        for (pgn::Symbol player : tournament.players) mix(player.id());
+    }
+    return hash;
+}
+
+int main(int argc, char* argv[]) {
+    std::string filename = argc > 1 ? argv[1] : "";
+    unsigned max_threads = argc > 2 ? std::atoi(argv[2]) : std::max(1u, std::thread::hardware_concurrency());
+    
+    bool synthetic = filename.empty();
+    if (synthetic) {
+        filename = "analysis_benchmark.pgn";
+        write_synthetic_file(filename, 200000, 50000, 10000);
+    }
+    
+    std::cout << "=== libpgn Analysis Scaling Benchmark ===\n";
+    std::cout << "File: " << filename << "\n\n";
+    std::cout << std::setw(8) << "Threads" << std::setw(14) << "Analysis (s)"
+              << std::setw(10) << "Speedup" << std::setw(12) << "Matches" << "\n";
+    
+    double serial_seconds = 0;
+    uint64_t serial_fingerprint = 0;
+    for (unsigned threads = 1; threads <= max_threads; ++threads) {
+        pgn::ParserOptions options;
+        options.threads = threads;
+        pgn::Parser parser(options);
+        
+        // Best of three loads.
+        double best = 0;
+        for (int run = 0; run < 3; ++run) {
+            if (!parser.load_file(filename)) return 1;
+            double seconds = parser.get_stats().analysis_time_seconds;
+            if (run == 0 || seconds < best) best = seconds;
+        }
+        
+        uint64_t digest = fingerprint(parser.get_stats());
+        if (threads == 1) {
+            serial_seconds = best;
+            serial_fingerprint = digest;
+        }
+        
+        std::cout << std::setw(8) << threads << std::setw(14) << std::fixed << std::setprecision(4) << best
+                  << std::setw(9) << std::setprecision(2) << (best > 0 ? serial_seconds / best : 0.0) << "x"
+                  << std::setw(12) << (digest == serial_fingerprint ? "yes" : "NO") << "\n";
+    }
+    
+    if (synthetic) std::remove(filename.c_str());
+    return 0;
+}
@@ -0,0 +1,79 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <fstream>
+#include <string>
+#include <cstdio>
+#include <cstdint>
+#include <pgn/parser.hpp>
+
+// Appends `games` synthetic games to `filename`, as a broadcast feed would.
+void append_games(const std::string& filename, int first, int games) {
+    std::ofstream out(filename, std::ios::binary | std::ios::app);
+    static const char* results[] = {"1-0", "0-1", "1/2-1/2"};
+    for (int i = first; i < first + games; ++i) {
+        out << "[Event \"Broadcast " << i / 500 << "\"]\n"
+            << "[White \"Player " << i * 7 % 3000 << "\"]\n"
+            << "[Black \"Player " << (i * 13 + 1) % 3000 << "\"]\n"
+            << "[Result \"" << results[i % 3] << "\"]\n"
+            << "[ECO \"B" << 10 + i % 90 << "\"]\n\n"
+            << "1. e4 c5 2. Nf3 d6 3. d4 cxd4 4. Nxd4 Nf6 5. Nc3 a6 6. Be3 e5 7. Nb3 Be6 "
+            << "8. f3 Be7 9. Qd2 O-O 10. O-O-O Nbd7 " << results[i % 3] << "\n\n";
+    }
+}
+
+double seconds_since(std::chrono::high_resolution_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+int main(int argc, char* argv[]) {
+    int base_games = argc > 1 ? std::atoi(argv[1]) : 500000;
+    int batch = argc > 2 ? std::atoi(argv[2]) : 100;
+    int refreshes = 20;
+    const std::string filename = "append_benchmark.pgn";
+    
+    std::remove(filename.c_str());
+    append_games(filename, 0, base_games);
+    
+    std::cout << "=== Refreshing a growing file: " << base_games << " games, then "
+              << refreshes << " batches of " << batch << " ===\n";
+    
+    pgn::Parser live;
+    auto start = std::chrono::high_resolution_clock::now();
+    live.load_appended(filename);
+    std::cout << "Initial load:      " << std::fixed << std::setprecision(3)
+              << seconds_since(start) << "s\n";
+    
+    double appended_time = 0;
+    double reload_time = 0;
+    pgn::Parser reloaded;
+    for (int i = 0; i < refreshes; ++i) {
+        append_games(filename, base_games + i * batch, batch);
+        
+        start = std::chrono::high_resolution_clock::now();
+        live.load_appended(filename);
+        appended_time += seconds_since(start);
+        
+        start = std::chrono::high_resolution_clock::now();
+        reloaded.load_file(filename);
+        reload_time += seconds_since(start);
+    }
+    
+    const pgn::DatabaseStats& a = live.get_stats();
+    const pgn::DatabaseStats& b = reloaded.get_stats();
+    bool same = a.total_games == b.total_games && a.unique_players == b.unique_players &&
+                a.unique_tournaments == b.unique_tournaments && a.white_wins == b.white_wins &&
+                a.draws == b.draws && a.most_active_player == b.most_active_player &&
+                a.max_games_by_player == b.max_games_by_player &&
+                a.tournament_names == b.tournament_names && a.player_names == b.player_names;
+    
+    std::cout << "load_appended():   " << std::setprecision(3) << appended_time * 1000 / refreshes
+              << " ms per refresh\n"
+              << "load_file():       " << reload_time * 1000 / refreshes << " ms per refresh\n"
+              << "Speedup:           " << std::setprecision(1) << reload_time / appended_time << "x\n"
+              << "Statistics " << (same ? "match" : "DIFFER") << " (" << a.total_games
+              << " games)\n";
+    
+    std::remove(filename.c_str());
+    return same ? 0 : 1;
+}
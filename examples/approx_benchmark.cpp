@@ -0,0 +1,87 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <pgn/generator.hpp>
+#include <pgn/parser.hpp>
+
+double relative_error(double estimate, double exact) {
+    return exact > 0 ? std::abs(estimate - exact) / exact : 0.0;
+}
+
+int main(int argc, char* argv[]) {
+    int games = argc > 1 ? std::atoi(argv[1]) : 500000;
+    unsigned threads = argc > 2 ? std::atoi(argv[2]) : std::thread::hardware_concurrency();
+    const std::string filename = "approx_benchmark.pgn";
+    
+    pgn::GeneratorOptions generator;
+    generator.games = games;
+    generator.players = games / 4;
+    pgn::GameGenerator(generator).write_file(filename);
+    
+    pgn::ParserOptions options;
+    options.threads = threads;
+    std::cout << "=== Approximate statistics: " << games << " games, " << threads << " threads ===\n";
+    
+    auto start = std::chrono::high_resolution_clock::now();
+    pgn::DatabaseStats exact = pgn::Parser::analyze_file(filename, nullptr, options);
+    auto end = std::chrono::high_resolution_clock::now();
+    double exact_seconds = std::chrono::duration<double>(end - start).count();
+    
+    options.approximate_stats = true;
+    start = std::chrono::high_resolution_clock::now();
+    pgn::DatabaseStats approx = pgn::Parser::analyze_file(filename, nullptr, options);
+    end = std::chrono::high_resolution_clock::now();
+    double approx_seconds = std::chrono::duration<double>(end - start).count();
+    
+    // Sketches of the two halves, merged, against a sketch of the whole.
+    pgn::Parser whole(options);
+    whole.for_each_game(filename, nullptr);
+    pgn::ApproximateStats halves[2];
+    int seen = 0;
+    pgn::Parser splitter;
+    splitter.for_each_game(filename, [&](const pgn::GameView& game) {
+        halves[seen++ < games / 2 ? 0 : 1].add(game);
+    });
+    halves[0].merge(halves[1]);
+    
+    double player_error = relative_error(approx.unique_players, exact.unique_players);
+    double tournament_error = relative_error(approx.unique_tournaments, exact.unique_tournaments);
+    // Count-Min bound with width 32768: e * N / width, per name.
+    double slack = 2.72 * 2 * games / 32768.0;
+    
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << "Exact:       " << exact_seconds << " s, " << exact.unique_players << " players, "
+              << exact.unique_tournaments << " tournaments, most active " << exact.most_active_player
+              << " (" << exact.max_games_by_player << ")\n";
+    std::cout << "Approximate: " << approx_seconds << " s, " << approx.unique_players << " players, "
+              << approx.unique_tournaments << " tournaments, most active " << approx.most_active_player
+              << " (" << approx.max_games_by_player << ")\n";
+    std::cout << "Errors: players " << std::setprecision(2) << player_error * 100 << "%, tournaments "
+              << tournament_error * 100 << "%; sketch memory "
+              << whole.get_approximate_stats().memory_usage() / 1024 << " KB\n";
+    
+    std::cout << "Top players (estimate / exact):\n";
+    for (const auto& item : whole.get_approximate_stats().top_players(5)) {
+        const pgn::PlayerStats* player = exact.find_player(item.name);
+        std::cout << "  " << std::left << std::setw(24) << item.name << std::right << std::setw(8)
+                  << item.count << " / " << (player ? player->total_games : 0) << "\n";
+    }
+    
+    // HyperLogLog is 0.81% standard error; allow four of them.
+    bool ok = approx.total_games == exact.total_games && approx.white_wins == exact.white_wins &&
+              approx.draws == exact.draws && player_error < 0.033 && tournament_error < 0.033 &&
+              approx.max_games_by_player >= exact.max_games_by_player &&
+              approx.max_games_by_player <= exact.max_games_by_player + slack &&
+              approx.max_games_in_tournament >= exact.max_games_in_tournament &&
+              halves[0].estimated_players() == whole.get_approximate_stats().estimated_players() &&
+              halves[0].total_games() == whole.get_approximate_stats().total_games() &&
+              whole.get_approximate_stats().memory_usage() < (4 << 20);
+    
+    std::remove(filename.c_str());
+    std::cout << (ok ? "Approximation checks passed\n" : "Approximation checks FAILED\n");
+    return ok ? 0 : 1;
+}
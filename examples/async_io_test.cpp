@@ -0,0 +1,112 @@
+#include <iostream>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+#include "../src/async_io.hpp"
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+// Byte `offset` of the test file, so a read that lands in the wrong
+// buffer or at the wrong offset shows up as a mismatch.
+char byte_at(uint64_t offset) {
+    uint64_t x = offset * 0x9E3779B97F4A7C15ull;
+    return static_cast<char>(x >> 56);
+}
+
+bool matches(const char* data, size_t size, uint64_t offset) {
+    for (size_t i = 0; i < size; ++i) {
+        if (data[i] != byte_at(offset + i)) return false;
+    }
+    return true;
+}
+
+// Reads a file through AsyncFile while the ring refuses some of the reads,
+// which then take the pread() fallback. Every buffer is reused as soon as
+// its read completes, except those of refused reads: they are filled with
+// a marker and set aside, so that a refused read the kernel still carried
+// out later would overwrite it.
+int main(int argc, char* argv[]) {
+    const std::string filename = "async_io_test.bin";
+    const size_t block = 256 << 10;
+    const size_t blocks = argc > 1 ? std::atoi(argv[1]) : 96;
+    const unsigned depth = 4;
+    {
+        std::ofstream out(filename, std::ios::binary);
+        std::string chunk(block, '\0');
+        for (size_t b = 0; b < blocks; ++b) {
+            for (size_t i = 0; i < block; ++i) chunk[i] = byte_at(b * block + i);
+            out.write(chunk.data(), static_cast<std::streamsize>(chunk.size()));
+        }
+    }
+
+#ifndef _WIN32
+    // A read that is lost instead of falling back would leave wait()
+    // blocked for good; fail rather than hang.
+    alarm(60);
+#endif
+    bool ok = true;
+    size_t refused = 0;
+    std::vector<std::unique_ptr<char[]>> set_aside;
+    try {
+        pgn::AsyncFile file(filename, depth, true);
+        std::cout << "=== AsyncFile fallback: " << blocks << " blocks, "
+                  << (file.uses_io_uring() ? "io_uring" : "io_uring unavailable, pread only")
+                  << " ===\n";
+        
+        // Tags are block numbers. A buffer goes back to the pool once its
+        // block has been checked, and the next read takes it.
+        std::vector<std::unique_ptr<char[]>> pool;
+        std::vector<std::unique_ptr<char[]>> owner(blocks);
+        std::vector<bool> was_refused(blocks, false);
+        size_t next = 0;
+        auto submit_next = [&] {
+            if (pool.empty()) pool.emplace_back(new char[block]);
+            owner[next] = std::move(pool.back());
+            pool.pop_back();
+            // Every third read is refused, and a run of three once.
+            if (next % 3 == 1 || (next >= 40 && next < 43)) {
+                file.refuse_ring_reads(1);
+                was_refused[next] = true;
+                refused++;
+            }
+            file.submit(owner[next].get(), block, next * block, next);
+            next++;
+        };
+        while (next < blocks && file.in_flight() < depth) submit_next();
+        while (file.in_flight() > 0) {
+            pgn::AsyncFile::Completion completion = file.wait();
+            auto& buffer = owner[completion.tag];
+            ok = ok && completion.bytes == block &&
+                 matches(buffer.get(), block, completion.tag * block);
+            if (was_refused[completion.tag]) {
+                std::memset(buffer.get(), 0x5A, block);
+                set_aside.push_back(std::move(buffer));
+            } else {
+                pool.push_back(std::move(buffer));
+            }
+            if (next < blocks) submit_next();
+        }
+        
+        // One more read after the rest, which enters the ring again.
+        std::unique_ptr<char[]> last(new char[block]);
+        file.submit(last.get(), block, 0, 0);
+        ok = ok && file.wait().bytes == block && matches(last.get(), block, 0);
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        ok = false;
+    }
+    
+    for (const auto& buffer : set_aside) {
+        for (size_t i = 0; ok && i < block; ++i) ok = buffer[i] == 0x5A;
+    }
+    std::remove(filename.c_str());
+    std::cout << refused << " reads refused by the ring\n"
+              << (ok ? "AsyncFile checks passed" : "ASYNCFILE CHECKS FAILED") << std::endl;
+    return ok ? 0 : 1;
+}
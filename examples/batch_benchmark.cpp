@@ -0,0 +1,98 @@
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstdint>
+#include <pgn/parser.hpp>
+
+// Writes an archive of uneven files: a couple of large ones and many
+// small ones, as a month of tournament downloads tends to look.
+std::vector<std::string> write_archive(const std::string& directory, int files) {
+    std::filesystem::create_directories(directory);
+    static const char* results[] = {"1-0", "0-1", "1/2-1/2"};
+    
+    uint64_t state = 3;
+    auto next = [&state](int bound) {
+        state = state * 6364136223846793005ull + 1442695040888963407ull;
+        return static_cast<int>((state >> 33) % static_cast<uint64_t>(bound));
+    };
+    
+    std::vector<std::string> filenames;
+    for (int f = 0; f < files; ++f) {
+        std::string filename = directory + "/event_" + std::to_string(1000 + f) + ".pgn";
+        std::ofstream out(filename, std::ios::binary);
+        int games = f < 2 ? 100000 : 200 + next(2000);
+        for (int i = 0; i < games; ++i) {
+            out << "[Event \"Event " << f << "\"]\n"
+                << "[White \"Player " << next(20000) << "\"]\n"
+                << "[Black \"Player " << next(20000) << "\"]\n"
+                << "[Result \"" << results[next(3)] << "\"]\n"
+                << "[ECO \"C" << 10 + next(90) << "\"]\n\n"
+                << "1. e4 e5 2. Nf3 Nc6 3. Bb5 a6 4. Ba4 Nf6 5. O-O Be7 6. Re1 b5 7. Bb3 d6 "
+                << "8. c3 O-O 9. h3 Nb8 10. d4 Nbd7 " << results[next(3)] << "\n\n";
+        }
+        filenames.push_back(filename);
+    }
+    return filenames;
+}
+
+int main(int argc, char* argv[]) {
+    int files = argc > 1 ? std::atoi(argv[1]) : 200;
+    unsigned threads = argc > 2 ? std::atoi(argv[2]) : std::thread::hardware_concurrency();
+    const std::string directory = "batch_benchmark_files";
+    
+    std::cout << "=== Batch ingestion: " << files << " files, " << threads << " threads ===\n";
+    std::vector<std::string> filenames = write_archive(directory, files);
+    
+    // One parser per file, as callers had to do before load_files().
+    auto start = std::chrono::high_resolution_clock::now();
+    int serial_games = 0;
+    for (const auto& filename : filenames) {
+        serial_games += pgn::Parser::analyze_file(filename).total_games;
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    double serial_seconds = std::chrono::duration<double>(end - start).count();
+    
+    pgn::ParserOptions options;
+    options.threads = threads;
+    pgn::Parser parser(options);
+    start = std::chrono::high_resolution_clock::now();
+    bool ok = parser.load_directory(directory);
+    end = std::chrono::high_resolution_clock::now();
+    double batch_seconds = std::chrono::duration<double>(end - start).count();
+    
+    const pgn::DatabaseStats& stats = parser.get_stats();
+    ok = ok && stats.total_games == serial_games;
+    
+    std::cout << "File by file:     " << std::fixed << std::setprecision(3) << serial_seconds
+              << "s, " << serial_games << " games\n"
+              << "load_directory(): " << batch_seconds << "s, " << stats.total_games
+              << " games, " << stats.unique_players << " players, " << stats.unique_tournaments
+              << " tournaments\n"
+              << "  parse " << stats.parsing_time_seconds << "s, analysis "
+              << stats.analysis_time_seconds << "s\n"
+              << "Speedup:          " << std::setprecision(1) << serial_seconds / batch_seconds
+              << "x\n\n";
+    
+    std::cout << "Slowest files:\n";
+    std::vector<pgn::FileTiming> timings = parser.get_file_timings();
+    std::sort(timings.begin(), timings.end(), [](const auto& a, const auto& b) {
+        return a.parse_seconds > b.parse_seconds;
+    });
+    for (size_t i = 0; i < timings.size() && i < 5; ++i) {
+        const auto& timing = timings[i];
+        std::cout << "  " << std::left << std::setw(40) << timing.filename << std::right
+                  << std::setw(8) << timing.games << " games " << std::setw(10)
+                  << timing.bytes / 1024 << " KB " << std::setprecision(3)
+                  << timing.parse_seconds * 1000 << " ms\n";
+    }
+    
+    std::filesystem::remove_all(directory);
+    std::cout << (ok ? "\nTotals match\n" : "\nTotals DIFFER\n");
+    return ok ? 0 : 1;
+}
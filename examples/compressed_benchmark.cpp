@@ -0,0 +1,61 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <pgn/parser.hpp>
+
+// Compares loading a plain PGN with loading compressed copies of it
+// (.gz, .bz2, .zst), which are decompressed on a background thread while
+// the parser consumes them.
+//
+//     compressed_benchmark games.pgn games.pgn.gz games.pgn.bz2 games.pgn.zst
+
+double file_megabytes(const std::string& filename) {
+    std::ifstream file(filename, std::ios::binary | std::ios::ate);
+    return file ? static_cast<double>(file.tellg()) / (1024.0 * 1024.0) : 0.0;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cout << "Usage: " << argv[0] << " plain.pgn [compressed.pgn.gz ...]\n";
+        return 1;
+    }
+    
+    std::vector<std::string> files(argv + 1, argv + argc);
+    double text_megabytes = file_megabytes(files[0]);
+    
+    std::cout << "=== libpgn Compressed Input Benchmark ===\n";
+    std::cout << "Uncompressed size: " << std::fixed << std::setprecision(1)
+              << text_megabytes << " MB\n\n";
+    std::cout << std::left << std::setw(32) << "File" << std::right
+              << std::setw(10) << "Size MB" << std::setw(10) << "Games"
+              << std::setw(12) << "Load (s)" << std::setw(14) << "Text MB/s"
+              << std::setw(12) << "vs plain" << "\n";
+    
+    double plain_seconds = 0;
+    for (size_t i = 0; i < files.size(); ++i) {
+        pgn::Parser parser;
+        
+        // Best of three loads.
+        double best = 0;
+        for (int run = 0; run < 3; ++run) {
+            auto start = std::chrono::high_resolution_clock::now();
+            if (!parser.load_file(files[i])) return 1;
+            auto end = std::chrono::high_resolution_clock::now();
+            double seconds = std::chrono::duration<double>(end - start).count();
+            if (run == 0 || seconds < best) best = seconds;
+        }
+        if (i == 0) plain_seconds = best;
+        
+        std::cout << std::left << std::setw(32) << files[i] << std::right
+                  << std::setw(10) << std::setprecision(1) << file_megabytes(files[i])
+                  << std::setw(10) << parser.get_stats().total_games
+                  << std::setw(12) << std::setprecision(3) << best
+                  << std::setw(14) << std::setprecision(1) << (best > 0 ? text_megabytes / best : 0.0)
+                  << std::setw(11) << std::setprecision(2) << (plain_seconds > 0 ? best / plain_seconds : 0.0)
+                  << "x\n";
+    }
+    return 0;
+}
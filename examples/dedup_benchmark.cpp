@@ -0,0 +1,124 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <pgn/generator.hpp>
+#include <pgn/metrics.hpp>
+#include <pgn/parser.hpp>
+
+// The same game as another source might publish it: event renamed, names
+// spaced differently, a comment, a clock and a variation in the
+// movetext, and Windows line ends.
+std::string republish(const std::string& game) {
+    std::string out = game;
+    size_t event = out.find("[Event \"");
+    if (event != std::string::npos) out.insert(event + 8, "Broadcast: ");
+    for (const char* tag : {"[White \"", "[Black \""}) {
+        size_t name = out.find(tag);
+        size_t comma = out.find(", ", name);
+        if (name != std::string::npos && comma != std::string::npos) out.erase(comma + 1, 1);
+    }
+    size_t movetext = out.find("\n\n");
+    if (movetext != std::string::npos) {
+        size_t first_move = out.find(' ', movetext + 2);
+        size_t after = out.find(' ', first_move + 1);
+        if (after != std::string::npos) out.insert(after, " { [%clk 1:30:00] } (1. Nf3 Nf6)");
+        out.insert(movetext + 2, "{ Imported } ");
+    }
+    std::string crlf;
+    for (char c : out) {
+        if (c == '\n') crlf += '\r';
+        crlf += c;
+    }
+    return crlf;
+}
+
+template <typename Fn>
+double seconds_of(Fn&& fn) {
+    auto start = std::chrono::high_resolution_clock::now();
+    fn();
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double>(end - start).count();
+}
+
+// Loads a database together with a second one that republishes every
+// other game of it, with and without dropping duplicates.
+int main(int argc, char* argv[]) {
+    int games = argc > 1 ? std::atoi(argv[1]) : 500000;
+    unsigned threads = argc > 2 ? std::atoi(argv[2]) : std::thread::hardware_concurrency();
+    const std::string original = "dedup_original.pgn";
+    const std::string copies = "dedup_copies.pgn";
+    
+    pgn::GeneratorOptions generator;
+    generator.games = games;
+    pgn::GameGenerator source(generator);
+    std::ofstream first(original, std::ios::binary);
+    std::ofstream second(copies, std::ios::binary);
+    std::string game;
+    int republished = 0;
+    for (int i = 0; source.next(game); ++i) {
+        first << game;
+        if (i % 2 == 0) {
+            second << republish(game);
+            republished++;
+        }
+        game.clear();
+    }
+    first.close();
+    second.close();
+    
+    pgn::ParserOptions options;
+    options.threads = threads;
+    std::cout << "=== Deduplication: " << games << " games + " << republished << " republished, "
+              << threads << " threads ===\n";
+    
+    pgn::Parser plain(options);
+    double plain_seconds = seconds_of([&] { plain.load_files({original, copies}); });
+    
+    options.deduplicate = true;
+    pgn::Parser alone(options);
+    alone.load_file(original);
+    pgn::Parser merged(options);
+    pgn::enable_metrics(true);
+    double dedup_seconds = seconds_of([&] { merged.load_files({original, copies}); });
+    pgn::MetricsSnapshot metrics = pgn::metrics_snapshot();
+    
+    options.threads = 1;
+    pgn::Parser serial(options);
+    serial.load_files({original, copies});
+    pgn::DatabaseStats streamed = pgn::Parser::analyze_file(copies, nullptr, options);
+    
+    const pgn::DatabaseStats& a = alone.get_stats();
+    const pgn::DatabaseStats& m = merged.get_stats();
+    const pgn::DatabaseStats& s = serial.get_stats();
+    int plain_games = plain.get_stats().total_games;
+    std::cout << std::fixed << std::setprecision(3)
+              << "Without deduplication: " << plain_seconds << " s, " << plain_games << " games\n"
+              << "With deduplication:    " << dedup_seconds << " s, " << m.total_games << " games, "
+              << m.duplicate_games << " duplicates dropped ("
+              << a.duplicate_games << " within the original)\n"
+              << "Overhead: " << std::setprecision(1)
+              << (dedup_seconds - plain_seconds) * 1e9 / plain_games << " ns per game; fingerprint "
+              << "table load factor " << std::setprecision(2)
+              << metrics.load_factor(pgn::HashTable::fingerprints) << "\n";
+    
+    // Every republished copy goes, and with it nothing else: the merged
+    // statistics are those of the original alone, on any thread count.
+    bool ok = m.total_games + m.duplicate_games == plain_games &&
+              m.duplicate_games == a.duplicate_games + republished &&
+              m.total_games == a.total_games && m.unique_players == a.unique_players &&
+              m.unique_tournaments == a.unique_tournaments && m.white_wins == a.white_wins &&
+              m.draws == a.draws && m.most_active_player == a.most_active_player &&
+              m.max_games_by_player == a.max_games_by_player &&
+              s.total_games == m.total_games && s.duplicate_games == m.duplicate_games &&
+              s.unique_tournaments == m.unique_tournaments &&
+              streamed.total_games + streamed.duplicate_games == republished;
+    
+    std::remove(original.c_str());
+    std::remove(copies.c_str());
+    std::cout << (ok ? "Deduplication checks passed\n" : "Deduplication checks FAILED\n");
+    return ok ? 0 : 1;
+}
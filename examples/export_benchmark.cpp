@@ -0,0 +1,113 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <cstdio>
+#include <cstdint>
+#include <thread>
+#include <pgn/parser.hpp>
+
+// Builds a synthetic database with many distinct players, so the export
+// has many rows.
+void write_synthetic_file(const std::string& filename, int games, int players, int tournaments) {
+    std::ofstream out(filename, std::ios::binary);
+    static const char* results[] = {"1-0", "0-1", "1/2-1/2", "*"};
+    
+    uint64_t state = 7;
+    auto next = [&state](int bound) {
+        state = state * 6364136223846793005ull + 1442695040888963407ull;
+        return static_cast<int>((state >> 33) % static_cast<uint64_t>(bound));
+    };
+    
+    for (int i = 0; i < games; ++i) {
+        int white = next(players);
+        int black = (white + 1 + next(players - 1)) % players;
+        const char* result = results[next(4)];
+        out << "[Event \"Event " << next(tournaments) << "\"]\n"
+            << "[White \"Player " << white << ", Test\"]\n"
+            << "[Black \"Player " << black << ", Test\"]\n"
+            << "[Result \"" << result << "\"]\n\n"
+            << "1. e4 e5 " << result << "\n\n";
+    }
+}
+
+// Reference: the same player CSV written with iostream formatting.
+void iostream_export(const pgn::DatabaseStats& stats, const std::string& filename) {
+    std::ofstream out(filename);
+    out << "name,total_games,games_as_white,games_as_black,wins,losses,draws,"
+           "win_percentage,draw_percentage,unique_opponents\n";
+    for (pgn::Symbol name : stats.player_names) {
+        const pgn::PlayerStats& p = stats.player_stats.at(name);
+        out << '"' << p.name << "\"," << p.total_games << ',' << p.games_as_white << ','
+            << p.games_as_black << ',' << p.wins << ',' << p.losses << ',' << p.draws << ','
+            << std::fixed << std::setprecision(2) << p.win_percentage << ',' << p.draw_percentage
+            << ',' << p.opponents.size() << '\n';
+    }
+}
+
+double file_megabytes(const std::string& filename) {
+    std::ifstream file(filename, std::ios::binary | std::ios::ate);
+    return file ? static_cast<double>(file.tellg()) / (1024.0 * 1024.0) : 0.0;
+}
+
+void report(const std::string& label, const std::string& filename, const std::function<void()>& run) {
+    // Best of three.
+    double best = 0;
+    for (int i = 0; i < 3; ++i) {
+        auto start = std::chrono::high_resolution_clock::now();
+        run();
+        auto end = std::chrono::high_resolution_clock::now();
+        double seconds = std::chrono::duration<double>(end - start).count();
+        if (i == 0 || seconds < best) best = seconds;
+    }
+    double megabytes = file_megabytes(filename);
+    std::cout << std::left << std::setw(28) << label << std::right << std::fixed
+              << std::setw(10) << std::setprecision(1) << megabytes
+              << std::setw(12) << std::setprecision(4) << best
+              << std::setw(12) << std::setprecision(1) << (best > 0 ? megabytes / best : 0.0) << "\n";
+    std::remove(filename.c_str());
+}
+
+int main(int argc, char* argv[]) {
+    std::string filename = argc > 1 ? argv[1] : "";
+    unsigned max_threads = argc > 2 ? std::atoi(argv[2]) : std::max(1u, std::thread::hardware_concurrency());
+    
+    bool synthetic = filename.empty();
+    if (synthetic) {
+        filename = "export_benchmark.pgn";
+        write_synthetic_file(filename, 500000, 400000, 20000);
+    }
+    
+    pgn::Parser parser;
+    bool loaded = parser.load_file(filename);
+    if (synthetic) std::remove(filename.c_str());
+    if (!loaded) return 1;
+    const auto& stats = parser.get_stats();
+    
+    std::cout << "=== libpgn Export Benchmark ===\n";
+    std::cout << "Players: " << stats.player_stats.size()
+              << ", tournaments: " << stats.tournaments.size() << "\n\n";
+    std::cout << std::left << std::setw(28) << "Export" << std::right << std::setw(10) << "MB"
+              << std::setw(12) << "Time (s)" << std::setw(12) << "MB/s" << "\n";
+    
+    report("players.csv (iostream)", "export_players.csv", [&] {
+        iostream_export(stats, "export_players.csv");
+    });
+    for (unsigned threads = 1; threads <= max_threads; ++threads) {
+        pgn::ParserOptions options;
+        options.threads = threads;
+        parser.set_options(options);
+        std::string suffix = " (" + std::to_string(threads) + " thread" + (threads > 1 ? "s)" : ")");
+        report("players.csv" + suffix, "export_players.csv", [&] {
+            parser.export_player_stats_csv("export_players.csv");
+        });
+        report("tournaments.csv" + suffix, "export_tournaments.csv", [&] {
+            parser.export_tournaments_csv("export_tournaments.csv");
+        });
+    }
+    report("stats.bin", "export_stats.bin", [&] {
+        parser.export_stats_binary("export_stats.bin");
+    });
+    return 0;
+}
@@ -0,0 +1,79 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <pgn/generator.hpp>
+#include <pgn/parser.hpp>
+
+template <typename Fn>
+double seconds_of(Fn&& fn) {
+    auto start = std::chrono::high_resolution_clock::now();
+    fn();
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double>(end - start).count();
+}
+
+constexpr pgn::Fields pairing = pgn::Fields::white | pgn::Fields::black | pgn::Fields::result;
+
+// Loads the same file in full and with only the fields a pairing table
+// needs, and checks that every record agrees with the full load.
+int main(int argc, char* argv[]) {
+    int games = argc > 1 ? std::atoi(argv[1]) : 500000;
+    unsigned threads = argc > 2 ? std::atoi(argv[2]) : std::thread::hardware_concurrency();
+    const std::string filename = "field_benchmark.pgn";
+    
+    pgn::GeneratorOptions generator;
+    generator.games = games;
+    pgn::GameGenerator(generator).write_file(filename);
+    double megabytes = std::filesystem::file_size(filename) / 1e6;
+    
+    pgn::ParserOptions options;
+    options.threads = threads;
+    std::cout << "=== Field selection: " << games << " games, " << std::fixed << std::setprecision(1)
+              << megabytes << " MB, " << threads << " threads ===\n";
+    
+    pgn::Parser parser(options);
+    std::vector<pgn::GameRecord<pgn::Fields::all>> everything;
+    std::vector<pgn::GameRecord<pgn::Fields::none>> boundaries;
+    std::vector<pgn::GameRecord<pairing>> pairings;
+    double full_seconds = seconds_of([&] { parser.load_file(filename); });
+    double all_seconds = seconds_of([&] { everything = pgn::Parser::load<pgn::Fields::all>(filename, options); });
+    double none_seconds = seconds_of([&] { boundaries = pgn::Parser::load<pgn::Fields::none>(filename, options); });
+    double pairing_seconds = seconds_of([&] { pairings = pgn::Parser::load<pairing>(filename, options); });
+    
+    auto report = [&](const char* label, double seconds, size_t record_size) {
+        std::cout << std::left << std::setw(32) << label << std::right << std::setprecision(3)
+                  << std::setw(7) << seconds << " s " << std::setprecision(0) << std::setw(6)
+                  << megabytes / seconds << " MB/s " << std::setw(5) << record_size
+                  << " bytes a game\n";
+    };
+    report("load_file() with statistics", full_seconds, sizeof(pgn::Game));
+    report("load<Fields::all>()", all_seconds, sizeof(everything[0]));
+    report("load<white | black | result>()", pairing_seconds, sizeof(pairings[0]));
+    report("load<Fields::none>()", none_seconds, sizeof(boundaries[0]));
+    std::cout << std::setprecision(2) << "Speed-up of the pairing load: " << full_seconds / pairing_seconds
+              << "x over load_file(), " << all_seconds / pairing_seconds << "x over load<Fields::all>()\n";
+    
+    const std::vector<pgn::Game>& loaded = parser.get_games();
+    bool ok = everything.size() == loaded.size() && pairings.size() == loaded.size() &&
+              boundaries.size() == loaded.size();
+    for (size_t i = 0; ok && i < loaded.size(); ++i) {
+        const pgn::Game& game = loaded[i];
+        const auto& all = everything[i];
+        ok = all.event == game.event && all.site == game.site && all.date == game.date &&
+             all.round == game.round && all.white == game.white && all.black == game.black &&
+             all.result == game.result && all.white_elo == game.white_elo &&
+             all.black_elo == game.black_elo && all.eco == game.eco && all.opening == game.opening &&
+             all.move_count == game.move_count && pairings[i].white == game.white &&
+             pairings[i].black == game.black && pairings[i].result == game.result;
+    }
+    options.threads = 1;
+    ok = ok && pgn::Parser::load<pairing>(filename, options).size() == pairings.size();
+    
+    std::remove(filename.c_str());
+    std::cout << (ok ? "Field checks passed" : "FIELD CHECKS FAILED") << std::endl;
+    return ok ? 0 : 1;
+}
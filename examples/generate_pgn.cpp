@@ -0,0 +1,40 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <string>
+#include <cstdlib>
+#include <pgn/generator.hpp>
+
+// Writes a synthetic PGN file; "-" writes to standard output.
+//
+//     generate_pgn.exe games.pgn 1000000 42
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <output.pgn|-> [games] [seed] [players] [events]\n";
+        return 1;
+    }
+    std::string filename = argv[1];
+    pgn::GeneratorOptions options;
+    if (argc > 2) options.games = std::strtoull(argv[2], nullptr, 10);
+    if (argc > 3) options.seed = std::strtoull(argv[3], nullptr, 10);
+    if (argc > 4) options.players = static_cast<uint32_t>(std::strtoul(argv[4], nullptr, 10));
+    if (argc > 5) options.events = static_cast<uint32_t>(std::strtoul(argv[5], nullptr, 10));
+    
+    try {
+        auto start = std::chrono::high_resolution_clock::now();
+        pgn::GameGenerator generator(options);
+        if (filename == "-") {
+            generator.write(std::cout);
+        } else {
+            generator.write_file(filename);
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        std::cerr << "Generated " << options.games << " games (seed " << options.seed << ") in "
+                  << std::fixed << std::setprecision(2)
+                  << std::chrono::duration<double>(end - start).count() << "s\n";
+    } catch (const std::exception& e) {
+        std::cerr << "Error generating file: " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
@@ -3,8 +3,123 @@
 #include <chrono>
 #include <vector>
 #include <algorithm>
+#include <fstream>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <pgn/generator.hpp>
 #include <pgn/parser.hpp>
 
+// Counts heap allocations made through operator new, so the load below
+// can report how many it needed.
+std::atomic<size_t> allocation_count{0};
+
+void* operator new(std::size_t size) {
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    if (void* memory = std::malloc(size ? size : 1)) return memory;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept {
+    std::free(memory);
+}
+
+void compare_ingestion(const std::string& filename) {
+    std::ifstream file(filename, std::ios::binary | std::ios::ate);
+    double megabytes = file ? static_cast<double>(file.tellg()) / (1024.0 * 1024.0) : 0.0;
+    
+    std::cout << "=== INGESTION COMPARISON ===\n";
+    std::cout << "File size: " << std::fixed << std::setprecision(1) << megabytes << " MB\n";
+    
+    for (bool use_mmap : {false, true}) {
+        pgn::ParserOptions options;
+        options.use_mmap = use_mmap;
+        pgn::Parser parser(options);
+        
+        auto start = std::chrono::high_resolution_clock::now();
+        bool ok = parser.load_file(filename);
+        auto end = std::chrono::high_resolution_clock::now();
+        double seconds = std::chrono::duration<double>(end - start).count();
+        
+        if (!ok) return;
+        
+        double parse_seconds = parser.get_stats().parsing_time_seconds;
+        std::cout << std::setw(16) << std::left << (use_mmap ? "mmap:" : "buffered read:")
+                  << std::right << std::setprecision(3) << parse_seconds << " s parse, "
+                  << seconds << " s total";
+        if (parse_seconds > 0) {
+            std::cout << ", " << std::setprecision(1) << (megabytes / parse_seconds) << " MB/s";
+        }
+        std::cout << "\n";
+    }
+    std::cout << "\n";
+}
+
+// Statistics live in a per-parser arena, so destroying a loaded parser is
+// mostly a bulk release rather than one free() per map node.
+void measure_allocations(const std::string& filename) {
+    std::cout << "=== ALLOCATIONS AND TEARDOWN ===\n";
+    
+    for (int pass = 0; pass < 2; ++pass) {
+        size_t before = allocation_count.load();
+        auto start = std::chrono::high_resolution_clock::now();
+        auto parser = std::make_unique<pgn::Parser>();
+        if (!parser->load_file(filename)) return;
+        auto loaded = std::chrono::high_resolution_clock::now();
+        size_t allocations = allocation_count.load() - before;
+        
+        const pgn::DatabaseStats& stats = parser->get_stats();
+        double parse_seconds = stats.parsing_time_seconds;
+        double analysis_seconds = stats.analysis_time_seconds;
+        parser.reset();
+        auto destroyed = std::chrono::high_resolution_clock::now();
+        
+        // The first pass also interns every name; the second shows the
+        // steady state of a reload.
+        std::cout << (pass == 0 ? "first load:  " : "second load: ") << allocations
+                  << " allocations, " << std::setprecision(3) << parse_seconds << " s parse, "
+                  << analysis_seconds << " s analysis, "
+                  << std::chrono::duration<double>(loaded - start).count() << " s load, "
+                  << std::chrono::duration<double>(destroyed - loaded).count()
+                  << " s teardown\n";
+    }
+    std::cout << "\n";
+}
+
+void compare_index_reload(const std::string& filename) {
+    std::cout << "=== INDEX RELOAD ===\n";
+    
+    pgn::ParserOptions options;
+    options.use_index = true;
+    
+    // The first load builds (or refreshes) <file>.pgnidx; the second is
+    // served from it.
+    for (int pass = 0; pass < 2; ++pass) {
+        pgn::Parser parser(options);
+        
+        auto start = std::chrono::high_resolution_clock::now();
+        bool ok = parser.load_file(filename);
+        auto end = std::chrono::high_resolution_clock::now();
+        double seconds = std::chrono::duration<double>(end - start).count();
+        
+        if (!ok) return;
+        
+        std::cout << std::setw(16) << std::left
+                  << (parser.loaded_from_index() ? "from index:" : "full parse:")
+                  << std::right << std::setprecision(3)
+                  << parser.get_stats().parsing_time_seconds << " s load, "
+                  << seconds << " s total, "
+                  << parser.get_stats().total_games << " games\n";
+    }
+    std::cout << "\n";
+}
+
 void test_huge_file(const std::string& filename) {
     std::cout << "=== HUGE FILE STRESS TEST ===\n";
     std::cout << "File: " << filename << "\n";
@@ -47,6 +162,9 @@ void test_huge_file(const std::string& filename) {
     }
     std::cout << "Memory efficiency: " << (stats.unique_players + stats.unique_tournaments) 
               << " unique entities tracked\n";
+    const auto& symbols = pgn::SymbolTable::global();
+    std::cout << "Interned names: " << symbols.size() << " strings in "
+              << std::setprecision(2) << (symbols.memory_usage() / (1024.0 * 1024.0)) << " MB\n";
     
     // Show top players
     if (!stats.player_stats.empty()) {
@@ -72,15 +190,27 @@ void test_huge_file(const std::string& filename) {
     }
 }
 
-int main() {
+int main(int argc, char* argv[]) {
     std::cout << "=== libpgn HUGE FILE TEST ===\n\n";
     
-    std::string huge_file = "tests/huge_file_test.pgn";
-    
-    std::cout << "Testing with: " << huge_file << "\n";
-    std::cout << "This may take a while for large files...\n\n";
+    std::string huge_file = argc > 1 ? argv[1] : "tests/huge_file_test.pgn";
+    bool synthetic = argc <= 1 && !std::ifstream(huge_file).good();
     
     try {
+        if (synthetic) {
+            huge_file = "huge_file_test.pgn";
+            pgn::GeneratorOptions options;
+            options.games = 1000000;
+            std::cout << "Generating " << options.games << " games...\n";
+            pgn::GameGenerator(options).write_file(huge_file);
+        }
+        
+        std::cout << "Testing with: " << huge_file << "\n";
+        std::cout << "This may take a while for large files...\n\n";
+        
+        compare_ingestion(huge_file);
+        measure_allocations(huge_file);
+        compare_index_reload(huge_file);
         test_huge_file(huge_file);
     } catch (const std::exception& e) {
         std::cout << "ERROR: " << e.what() << "\n";
@@ -90,6 +220,7 @@ int main() {
         std::cout << "3. File too large for current implementation\n";
     }
     
+    if (synthetic) std::remove(huge_file.c_str());
     std::cout << "\n=== Test completed ===\n";
     return 0;
 }
\ No newline at end of file
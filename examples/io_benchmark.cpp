@@ -0,0 +1,108 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <pgn/generator.hpp>
+#include <pgn/metrics.hpp>
+#include <pgn/parser.hpp>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// Evicts the file from the page cache where the system allows it, so
+// each run reads from the device. Best effort: without it, runs measure
+// copies out of the cache.
+bool drop_cache(const std::string& filename) {
+#ifdef _WIN32
+    (void)filename;
+    return false;
+#else
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    fdatasync(fd);
+    bool dropped = posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED) == 0;
+    close(fd);
+    return dropped;
+#endif
+}
+
+struct Mode {
+    const char* name;
+    bool use_mmap;
+    bool use_io_uring;
+};
+
+// Streams and loads a file through each read path, reporting throughput
+// and the time parsing waited for input.
+int main(int argc, char* argv[]) {
+    std::string filename = argc > 1 ? argv[1] : "io_benchmark.pgn";
+    bool synthetic = argc <= 1;
+    int runs = argc > 2 ? std::atoi(argv[2]) : 3;
+    if (synthetic) {
+        pgn::GeneratorOptions generator;
+        generator.games = 500000;
+        pgn::GameGenerator(generator).write_file(filename);
+    }
+    
+    const Mode modes[] = {
+        {"mmap", true, false},
+        {"pread", false, false},
+        {"io_uring", false, true},
+    };
+    pgn::enable_metrics(true);
+    bool cold = drop_cache(filename);
+    std::cout << "=== Read paths: " << filename << (cold ? " (cold cache)" : " (warm cache)")
+              << ", best of " << runs << " ===\n";
+    std::cout << std::left << std::setw(22) << "mode" << std::right << std::setw(10) << "games"
+              << std::setw(10) << "MB/s" << std::setw(12) << "read wait" << "\n";
+    
+    bool ok = true;
+    size_t expected = 0;
+    for (const char* task : {"for_each_game", "load_file"}) {
+        for (const Mode& mode : modes) {
+            pgn::ParserOptions options;
+            options.use_mmap = mode.use_mmap;
+            options.use_io_uring = mode.use_io_uring;
+            pgn::Parser parser(options);
+            
+            double best = 1e30;
+            double stall = 0.0;
+            double megabytes = 0.0;
+            size_t games = 0;
+            for (int run = 0; run < runs; ++run) {
+                drop_cache(filename);
+                pgn::reset_metrics();
+                games = 0;
+                auto start = std::chrono::high_resolution_clock::now();
+                if (task[0] == 'f') {
+                    ok = parser.for_each_game(filename, [&games](const pgn::GameView&) { games++; }) && ok;
+                } else {
+                    ok = parser.load_file(filename) && ok;
+                    games = parser.get_stats().total_games;
+                }
+                auto end = std::chrono::high_resolution_clock::now();
+                double seconds = std::chrono::duration<double>(end - start).count();
+                if (seconds < best) {
+                    pgn::MetricsSnapshot metrics = pgn::metrics_snapshot();
+                    best = seconds;
+                    stall = metrics.stage(pgn::Stage::read).seconds;
+                    megabytes = metrics.bytes_read / (1024.0 * 1024.0);
+                }
+            }
+            if (expected == 0) expected = games;
+            ok = ok && games == expected;
+            
+            std::string label = std::string(task) + " " + mode.name;
+            std::cout << std::left << std::setw(22) << label << std::right << std::setw(10) << games
+                      << std::fixed << std::setprecision(1) << std::setw(10) << megabytes / best
+                      << std::setprecision(3) << std::setw(11) << stall << "s\n";
+        }
+    }
+    
+    if (synthetic) std::remove(filename.c_str());
+    std::cout << (ok ? "All read paths agree\n" : "Read paths DISAGREE\n");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,116 @@
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <pgn/generator.hpp>
+#include <pgn/metrics.hpp>
+#include <pgn/parser.hpp>
+
+double best_load_seconds(const std::string& filename, const pgn::ParserOptions& options, int runs) {
+    double best = 1e30;
+    for (int i = 0; i < runs; ++i) {
+        pgn::Parser parser(options);
+        auto start = std::chrono::high_resolution_clock::now();
+        parser.load_file(filename);
+        auto end = std::chrono::high_resolution_clock::now();
+        best = std::min(best, std::chrono::duration<double>(end - start).count());
+    }
+    return best;
+}
+
+void print_report(const pgn::MetricsSnapshot& metrics) {
+    static const char* stages[] = {"load", "read", "scan", "replay", "merge", "analysis", "index", "save"};
+    static const char* tags[] = {"Event", "Site", "Date", "Round", "White", "Black", "Result",
+                                 "WhiteElo", "BlackElo", "ECO", "FEN", "Opening", "other"};
+    static const char* tables[] = {"symbols", "chunk names", "statistics", "id sets", "opening tree",
+                                   "fingerprints"};
+    
+    std::cout << std::fixed << std::setprecision(3)
+              << "Games: " << metrics.games << ", " << metrics.bytes_read / (1024 * 1024) << " MB, "
+              << std::setprecision(0) << metrics.games_per_second() << " games/s, "
+              << std::setprecision(1) << metrics.megabytes_per_second() << " MB/s\n";
+    std::cout << "Stages (seconds summed over threads):\n";
+    for (size_t i = 0; i < pgn::stage_count; ++i) {
+        if (metrics.stages[i].calls == 0) continue;
+        std::cout << "  " << std::left << std::setw(10) << stages[i] << std::right << std::setw(10)
+                  << std::setprecision(4) << metrics.stages[i].seconds << " s " << std::setw(10)
+                  << metrics.stages[i].calls << " calls\n";
+    }
+    std::cout << "Tag lines:";
+    for (size_t i = 0; i < pgn::tag_kind_count; ++i) {
+        if (metrics.tag_lines[i]) std::cout << " " << tags[i] << "=" << metrics.tag_lines[i];
+    }
+    std::cout << "\nArena: " << metrics.arena_allocations << " blocks, "
+              << metrics.arena_bytes / 1024 << " KB\n";
+    std::cout << "Hash tables:\n";
+    for (size_t i = 0; i < pgn::hash_table_count; ++i) {
+        std::cout << "  " << std::left << std::setw(14) << tables[i] << std::right << std::setw(8)
+                  << metrics.rehashes[i] << " rehashes, load factor " << std::setprecision(2)
+                  << metrics.load_factors[i] << "\n";
+    }
+}
+
+int main(int argc, char* argv[]) {
+    std::string filename = argc > 1 ? argv[1] : "metrics_monitor.pgn";
+    unsigned threads = argc > 2 ? std::atoi(argv[2]) : 0;
+    bool synthetic = argc <= 1;
+    if (synthetic) {
+        pgn::GeneratorOptions generator;
+        generator.games = 300000;
+        pgn::GameGenerator(generator).write_file(filename);
+    }
+    
+    pgn::ParserOptions options;
+    options.threads = threads;
+    options.opening_tree_plies = 8;
+    
+    std::cout << "=== Metrics: " << filename << " ===\n";
+    
+    // Watch a load from another thread while it runs.
+    pgn::enable_metrics(true);
+    pgn::reset_metrics();
+    std::atomic<bool> done{false};
+    std::thread monitor([&done] {
+        uint64_t reported = 0;
+        while (!done.load()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            pgn::MetricsSnapshot metrics = pgn::metrics_snapshot();
+            if (metrics.games == reported) continue;
+            reported = metrics.games;
+            std::cout << "  ... " << metrics.games << " games scanned, "
+                      << metrics.bytes_read / (1024 * 1024) << " MB\n";
+        }
+    });
+    pgn::Parser parser(options);
+    bool ok = parser.load_file(filename);
+    parser.export_player_stats_csv("metrics_monitor_players.csv");
+    done = true;
+    monitor.join();
+    
+    pgn::MetricsSnapshot metrics = pgn::metrics_snapshot();
+    print_report(metrics);
+    ok = ok && metrics.games == static_cast<uint64_t>(parser.get_stats().total_games) &&
+         metrics.stage(pgn::Stage::load).calls == 1;
+    
+    // Alternate so both settings see the same cache state.
+    double enabled_seconds = 1e30;
+    double disabled_seconds = 1e30;
+    for (int i = 0; i < 3; ++i) {
+        pgn::enable_metrics(true);
+        enabled_seconds = std::min(enabled_seconds, best_load_seconds(filename, options, 1));
+        pgn::enable_metrics(false);
+        disabled_seconds = std::min(disabled_seconds, best_load_seconds(filename, options, 1));
+    }
+    std::cout << "Load with metrics off: " << std::setprecision(3) << disabled_seconds
+              << " s, on: " << enabled_seconds << " s (" << std::showpos << std::setprecision(1)
+              << (enabled_seconds / disabled_seconds - 1) * 100 << std::noshowpos << "%)\n";
+    
+    std::remove("metrics_monitor_players.csv");
+    if (synthetic) std::remove(filename.c_str());
+    std::cout << (ok ? "Metrics checks passed\n" : "Metrics checks FAILED\n");
+    return ok ? 0 : 1;
+}
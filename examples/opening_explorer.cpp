@@ -0,0 +1,165 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdint>
+#include <thread>
+#include <pgn/movetext.hpp>
+#include <pgn/parser.hpp>
+
+// Plays seeded games that pick among the first few legal moves, so the
+// openings branch a little at every ply and transpose now and then.
+void write_synthetic_file(const std::string& filename, int games) {
+    std::ofstream out(filename, std::ios::binary);
+    static const char* results[] = {"1-0", "0-1", "1/2-1/2"};
+    
+    uint64_t state = 7;
+    auto next = [&state](size_t bound) {
+        state = state * 6364136223846793005ull + 1442695040888963407ull;
+        return static_cast<size_t>((state >> 33) % bound);
+    };
+    
+    for (int i = 0; i < games; ++i) {
+        out << "[Event \"Synthetic\"]\n[White \"Player " << next(500) << "\"]\n[Black \"Player "
+            << next(500) << "\"]\n[Result \"" << results[next(3)] << "\"]\n\n";
+        pgn::Position position;
+        for (int ply = 0; ply < 40; ++ply) {
+            pgn::MoveList moves;
+            position.legal_moves(moves);
+            if (moves.size() == 0) break;
+            size_t choices = ply < 8 ? 3 : moves.size();
+            const pgn::Move& move = moves.moves[next(std::min(choices, moves.size()))];
+            if (position.side_to_move() == pgn::Color::white) {
+                out << position.fullmove_number() << ". ";
+            }
+            out << position.san(move) << " ";
+            position.play(move);
+        }
+        out << "*\n\n";
+    }
+}
+
+std::string read_file(const std::string& filename) {
+    std::ifstream in(filename, std::ios::binary);
+    std::ostringstream text;
+    text << in.rdbuf();
+    return text.str();
+}
+
+double score(const pgn::OpeningTree::Counts& counts) {
+    return counts.games ? (counts.white_wins + 0.5 * counts.draws) * 100.0 / counts.games : 0.0;
+}
+
+// Follows the most played move from the start position.
+void print_main_line(const pgn::OpeningTree& tree, int plies) {
+    std::cout << "Main line:\n";
+    pgn::Position position;
+    for (int ply = 0; ply < plies; ++ply) {
+        auto moves = tree.next_moves(position.hash());
+        pgn::Move move;
+        if (moves.empty() || !pgn::OpeningTree::decode_move(position, moves[0].move, move)) break;
+        
+        std::cout << "  " << std::left << std::setw(8) << position.san(move) << std::right
+                  << std::setw(8) << moves[0].counts.games << " games  " << std::fixed
+                  << std::setprecision(1) << std::setw(5) << score(moves[0].counts)
+                  << "% for white  (" << moves.size() << " moves seen)\n";
+        position.play(move);
+    }
+}
+
+// Times find() on every position the tree records along the main lines of
+// the loaded games.
+void time_lookups(const pgn::OpeningTree& tree, const pgn::Parser& parser) {
+    std::vector<uint64_t> keys;
+    for (const auto& game : parser.get_game_views()) {
+        pgn::Position position;
+        pgn::MovetextTokenizer tokens(game.movetext);
+        std::string_view san;
+        pgn::Move move;
+        for (int ply = 0; ply < tree.max_plies() && tokens.next(san); ++ply) {
+            if (!position.parse_san(san, move)) break;
+            position.play(move);
+            keys.push_back(position.hash());
+        }
+        if (keys.size() >= 1000000) break;
+    }
+    
+    size_t found = 0;
+    auto start = std::chrono::high_resolution_clock::now();
+    for (uint64_t key : keys) found += tree.find(key) != nullptr;
+    auto end = std::chrono::high_resolution_clock::now();
+    double seconds = std::chrono::duration<double>(end - start).count();
+    
+    std::cout << "Lookups: " << keys.size() << " positions, " << found << " found, "
+              << std::fixed << std::setprecision(3)
+              << (keys.empty() ? 0.0 : seconds * 1e6 / keys.size()) << " us each\n";
+}
+
+int main(int argc, char* argv[]) {
+    std::string filename = argc > 1 ? argv[1] : "opening_explorer.pgn";
+    unsigned threads = argc > 2 ? std::atoi(argv[2])
+                                : std::max(2u, std::thread::hardware_concurrency());
+    int plies = argc > 3 ? std::atoi(argv[3]) : 16;
+    bool synthetic = argc <= 1;
+    if (synthetic) write_synthetic_file(filename, 50000);
+    
+    std::cout << "=== Opening tree: " << filename << ", " << plies << " plies ===\n";
+    
+    bool ok = true;
+    pgn::ParserOptions options;
+    options.opening_tree_plies = plies;
+    
+    std::vector<std::string> saved;
+    for (unsigned count : {1u, threads}) {
+        options.threads = count;
+        pgn::Parser parser(options);
+        auto start = std::chrono::high_resolution_clock::now();
+        if (!parser.load_file(filename)) return 1;
+        auto end = std::chrono::high_resolution_clock::now();
+        double seconds = std::chrono::duration<double>(end - start).count();
+        
+        const pgn::OpeningTree& tree = parser.get_opening_tree();
+        std::cout << count << " thread(s): " << parser.get_stats().total_games << " games, "
+                  << tree.size() << " positions, " << tree.move_count() << " moves, "
+                  << tree.memory_usage() / 1024 << " KB, " << std::fixed << std::setprecision(3)
+                  << seconds << "s\n";
+        
+        std::string tree_file = "opening_explorer_" + std::to_string(count) + ".tree";
+        ok &= parser.export_opening_tree(tree_file);
+        saved.push_back(read_file(tree_file));
+        
+        if (count == 1) {
+            // The start position heads every game without a FEN tag.
+            const auto* root = tree.find(pgn::Position().hash());
+            uint32_t total = static_cast<uint32_t>(parser.get_stats().total_games);
+            if (synthetic && (!root || root->games != total)) {
+                std::cout << "Start position count is wrong\n";
+                ok = false;
+            }
+            
+            pgn::OpeningTree loaded = pgn::OpeningTree::load(tree_file);
+            loaded.save(tree_file);
+            if (read_file(tree_file) != saved[0]) {
+                std::cout << "Loaded tree does not save back to the same file\n";
+                ok = false;
+            }
+            
+            print_main_line(loaded, 10);
+            time_lookups(loaded, parser);
+        }
+        std::remove(tree_file.c_str());
+    }
+    
+    if (saved[0] != saved[1]) {
+        std::cout << "Trees built with 1 and " << threads << " threads differ\n";
+        ok = false;
+    }
+    if (synthetic) std::remove(filename.c_str());
+    
+    std::cout << (ok ? "Opening tree checks passed\n" : "Opening tree checks FAILED\n");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,63 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <fstream>
+#include <cstdio>
+#include <pgn/parser.hpp>
+
+// Builds a synthetic database in which one player meets every opponent
+// exactly once in a single open tournament, the worst case for opponent
+// and tournament-player tracking.
+void write_synthetic_file(const std::string& filename, int opponents) {
+    std::ofstream out(filename, std::ios::binary);
+    static const char* results[] = {"1-0", "0-1", "1/2-1/2"};
+    
+    for (int i = 0; i < opponents; ++i) {
+        const char* result = results[i % 3];
+        out << "[Event \"Giant Open\"]\n"
+            << "[Site \"Online\"]\n"
+            << "[Date \"2024.01.01\"]\n"
+            << "[Round \"" << (i + 1) << "\"]\n";
+        if (i % 2 == 0) {
+            out << "[White \"Hub, Player\"]\n[Black \"Opponent " << i << "\"]\n";
+        } else {
+            out << "[White \"Opponent " << i << "\"]\n[Black \"Hub, Player\"]\n";
+        }
+        out << "[Result \"" << result << "\"]\n"
+            << "[ECO \"B90\"]\n\n"
+            << "1. e4 c5 2. Nf3 d6 3. d4 cxd4 4. Nxd4 Nf6 5. Nc3 a6 " << result << "\n\n";
+    }
+}
+
+int main(int argc, char* argv[]) {
+    int opponents = argc > 1 ? std::atoi(argv[1]) : 50000;
+    std::string filename = "opponent_benchmark.pgn";
+    
+    std::cout << "=== libpgn Opponent Tracking Benchmark ===\n";
+    std::cout << "Opponents of the hub player: " << opponents << "\n\n";
+    
+    write_synthetic_file(filename, opponents);
+    
+    auto start = std::chrono::high_resolution_clock::now();
+    auto stats = pgn::Parser::analyze_file(filename);
+    auto end = std::chrono::high_resolution_clock::now();
+    double seconds = std::chrono::duration<double>(end - start).count();
+    
+    std::remove(filename.c_str());
+    
+    const pgn::PlayerStats* hub = stats.find_player("Hub, Player");
+    const pgn::Tournament* open = stats.find_tournament("Giant Open");
+    if (!hub || !open) {
+        std::cout << "Benchmark data was not parsed\n";
+        return 1;
+    }
+    
+    std::cout << "Hub distinct opponents: " << hub->opponents.size() << "\n";
+    std::cout << "Tournament unique players: " << open->unique_players << "\n";
+    std::cout << "Analysis time: " << std::fixed << std::setprecision(3) << seconds << " seconds\n";
+    if (seconds > 0) {
+        std::cout << "Games per second: " << std::setprecision(1)
+                  << (stats.total_games / seconds) << "\n";
+    }
+    return 0;
+}
@@ -1,7 +1,11 @@
 #include <iostream>
 #include <iomanip>
 #include <chrono>
+#include <cctype>
+#include <string>
 #include <fstream>
+#include <cstdio>
+#include <pgn/generator.hpp>
 #include <pgn/parser.hpp>
 
 void performance_test(const std::string& filename) {
@@ -36,11 +40,68 @@ void performance_test(const std::string& filename) {
               << stats.parsing_time_seconds << " seconds (internal)\n";
 }
 
+// Same aggregation (result counts and average rating) over materialized
+// rows and over the columnar table.
+void layout_test(const std::string& filename) {
+    pgn::Parser parser;
+    if (!parser.load_file(filename)) return;
+    
+    std::cout << "Row vs column scan for: " << filename << "\n";
+    std::cout << "================================\n";
+    
+    const auto& games = parser.get_games();
+    auto start_time = std::chrono::high_resolution_clock::now();
+    size_t white_wins = 0, draws = 0, rated = 0;
+    double elo_sum = 0;
+    for (const auto& game : games) {
+        if (game.is_white_win()) white_wins++;
+        else if (game.is_draw()) draws++;
+        if (!game.white_elo.empty() && std::isdigit(static_cast<unsigned char>(game.white_elo[0]))) {
+            elo_sum += std::stoi(game.white_elo);
+            rated++;
+        }
+    }
+    auto end_time = std::chrono::high_resolution_clock::now();
+    double row_seconds = std::chrono::duration<double>(end_time - start_time).count();
+    std::cout << "  Rows:    " << white_wins << " white wins, " << draws << " draws, avg Elo "
+              << std::fixed << std::setprecision(1) << (rated ? elo_sum / rated : 0.0)
+              << " in " << std::setprecision(6) << row_seconds << " s\n";
+    
+    const auto& table = parser.get_game_table();
+    start_time = std::chrono::high_resolution_clock::now();
+    auto counts = table.count_results();
+    uint64_t elo_total = 0;
+    size_t elo_count = 0;
+    for (uint16_t elo : table.white_elos()) {
+        bool valid = elo != 0 && elo != pgn::raw_elo;
+        elo_total += valid ? elo : 0;
+        elo_count += valid;
+    }
+    end_time = std::chrono::high_resolution_clock::now();
+    double column_seconds = std::chrono::duration<double>(end_time - start_time).count();
+    std::cout << "  Columns: " << counts.white_wins << " white wins, " << counts.draws << " draws, avg Elo "
+              << std::setprecision(1) << (elo_count ? double(elo_total) / elo_count : 0.0)
+              << " in " << std::setprecision(6) << column_seconds << " s\n";
+    std::cout << "  Table memory: " << table.memory_usage() / 1024 << " KiB for "
+              << table.size() << " games\n";
+}
+
 int main() {
     std::cout << "=== libpgn Performance Tests ===\n\n";
     
-    // Test with different files
-    performance_test("tests/test_comprehensive.pgn");
+    // Test with different files; generate one when the test data is absent.
+    std::string filename = "tests/test_comprehensive.pgn";
+    bool synthetic = !std::ifstream(filename).good();
+    if (synthetic) {
+        filename = "performance_test.pgn";
+        pgn::GeneratorOptions options;
+        options.games = 100000;
+        pgn::GameGenerator(options).write_file(filename);
+    }
+    performance_test(filename);
+    std::cout << "\n";
+    layout_test(filename);
+    if (synthetic) std::remove(filename.c_str());
     
     // Try with the original test file if it exists
     std::ifstream test_file("tests/test.pgn");
@@ -0,0 +1,197 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <pgn/movetext.hpp>
+#include <pgn/parser.hpp>
+#include <fstream>
+#include <cstdio>
+
+// Published perft counts for positions that exercise castling, en passant,
+// promotions and discovered checks.
+struct PerftCase {
+    const char* name;
+    const char* fen;
+    std::vector<uint64_t> nodes;
+};
+
+const PerftCase perft_cases[] = {
+    {"start", "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+     {20, 400, 8902, 197281, 4865609}},
+    {"kiwipete", "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+     {48, 2039, 97862, 4085603}},
+    {"endgame", "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+     {14, 191, 2812, 43238, 674624}},
+    {"promotions", "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+     {6, 264, 9467, 422333}},
+    {"talkchess", "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+     {44, 1486, 62379, 2103487}},
+    {"middlegame", "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+     {46, 2079, 89890, 3894594}},
+};
+
+bool run_perft() {
+    std::cout << "=== Perft ===\n";
+    bool ok = true;
+    uint64_t total_nodes = 0;
+    auto start = std::chrono::high_resolution_clock::now();
+    
+    for (const auto& test : perft_cases) {
+        pgn::Position position;
+        if (!position.set_fen(test.fen)) {
+            std::cout << test.name << ": cannot parse FEN\n";
+            ok = false;
+            continue;
+        }
+        for (size_t depth = 1; depth <= test.nodes.size(); ++depth) {
+            uint64_t nodes = pgn::perft(position, static_cast<int>(depth));
+            total_nodes += nodes;
+            bool match = nodes == test.nodes[depth - 1];
+            ok &= match;
+            std::cout << std::left << std::setw(12) << test.name << " depth " << depth
+                      << std::right << std::setw(12) << nodes << (match ? "  ok" : "  FAILED, expected ")
+                      << (match ? std::string() : std::to_string(test.nodes[depth - 1])) << "\n";
+        }
+    }
+    
+    auto end = std::chrono::high_resolution_clock::now();
+    double seconds = std::chrono::duration<double>(end - start).count();
+    std::cout << "Perft: " << total_nodes << " nodes in " << std::fixed << std::setprecision(2)
+              << seconds << "s (" << std::setprecision(1) << total_nodes / seconds / 1e6
+              << "M nodes/s)\n\n";
+    return ok;
+}
+
+// Plays seeded random games, writes them as SAN movetext with move numbers,
+// comments and a variation, and checks that replaying the text reaches the
+// same final position.
+bool run_replay(int games) {
+    std::cout << "=== SAN round trip and replay ===\n";
+    uint64_t state = 2024;
+    auto next = [&state](size_t bound) {
+        state = state * 6364136223846793005ull + 1442695040888963407ull;
+        return static_cast<size_t>((state >> 33) % bound);
+    };
+    
+    std::vector<std::string> texts;
+    std::vector<std::string> final_fens;
+    uint64_t total_plies = 0;
+    for (int g = 0; g < games; ++g) {
+        pgn::Position position;
+        std::string text;
+        int plies = 0;
+        for (; plies < 160; ++plies) {
+            pgn::MoveList moves;
+            position.legal_moves(moves);
+            if (moves.size() == 0) break;
+            const pgn::Move& move = moves.moves[next(moves.size())];
+            if (position.side_to_move() == pgn::Color::white) {
+                text += std::to_string(position.fullmove_number()) + ". ";
+            }
+            text += position.san(move) + " ";
+            if (plies == 10) text += "{a comment} (1... Nf6 2. c4 $1) ";
+            position.play(move);
+        }
+        text += "*\n";
+        total_plies += plies;
+        texts.push_back(std::move(text));
+        final_fens.push_back(position.fen());
+    }
+    
+    bool ok = true;
+    auto start = std::chrono::high_resolution_clock::now();
+    uint64_t replayed = 0;
+    for (int g = 0; g < games; ++g) {
+        pgn::Position position;
+        pgn::ReplayResult result = pgn::replay_movetext(texts[g], position);
+        replayed += result.plies;
+        if (!result.valid || position.fen() != final_fens[g]) {
+            if (ok) {
+                std::cout << "Mismatch in game " << g << " at offset " << result.error_offset << ":\n"
+                          << texts[g] << "\n";
+            }
+            ok = false;
+        }
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    double seconds = std::chrono::duration<double>(end - start).count();
+    
+    std::cout << games << " games, " << total_plies << " plies generated, " << replayed
+              << " replayed in " << std::fixed << std::setprecision(3) << seconds << "s ("
+              << std::setprecision(2) << replayed / seconds / 1e6 << "M moves/s)\n";
+    std::cout << (ok ? "All games replayed to the expected position\n\n" : "Replay FAILED\n\n");
+    return ok;
+}
+
+// Loads a file with ParserOptions::replay_moves and reports the replay
+// stage's cost next to a plain load.
+void load_with_replay(const std::string& filename, unsigned threads) {
+    pgn::ParserOptions options;
+    options.threads = threads;
+    
+    pgn::Parser plain(options);
+    plain.load_file(filename);
+    
+    options.replay_moves = true;
+    pgn::Parser replayed(options);
+    replayed.load_file(filename);
+    
+    const pgn::DatabaseStats& stats = replayed.get_stats();
+    uint64_t moves = 0;
+    for (int count : replayed.get_game_table().move_counts()) moves += count;
+    double extra = stats.parsing_time_seconds - plain.get_stats().parsing_time_seconds;
+    std::cout << filename << ": " << stats.total_games << " games, " << moves << " moves, "
+              << stats.invalid_move_games << " games with invalid moves\n"
+              << "  plain parse:  " << std::fixed << std::setprecision(3)
+              << plain.get_stats().parsing_time_seconds << "s\n"
+              << "  with replay:  " << stats.parsing_time_seconds << "s\n"
+              << "  replay stage: " << std::setprecision(2)
+              << (extra > 0 ? moves / extra / 1e6 : 0.0) << "M moves/s\n\n";
+}
+
+// Writes the generated games to a PGN file, one with an illegal move, and
+// checks that load_file() with replay_moves counts and flags them.
+bool run_load_stage() {
+    std::cout << "=== load_file() replay stage ===\n";
+    const std::string filename = "perft_test_replay.pgn";
+    {
+        std::ofstream out(filename, std::ios::binary);
+        out << "[Event \"Replay\"]\n[White \"A\"]\n[Black \"B\"]\n[Result \"1-0\"]\n\n"
+            << "1. e4 e5 2. Nf3 Nc6 3. Bb5 a6 {Morphy} 4. Ba4 Nf6 5. O-O Be7 (5... b5 6. Bb3) 1-0\n\n"
+            << "[Event \"Replay\"]\n[White \"A\"]\n[Black \"B\"]\n[Result \"0-1\"]\n\n"
+            << "1. f3 e5 2. g4 Qh4# 0-1\n\n"
+            << "[Event \"Replay\"]\n[White \"A\"]\n[Black \"B\"]\n[Result \"*\"]\n\n"
+            << "1. d4 d5 2. Bf4 Bf5 3. Bxd5 Bxc2 *\n\n"
+            << "[Event \"Replay\"]\n[White \"A\"]\n[Black \"B\"]\n[Result \"1-0\"]\n"
+            << "[FEN \"4k3/P7/8/8/8/8/8/4K3 w - - 0 1\"]\n\n"
+            << "1. a8=Q+ Kd7 2. Qb7+ 1-0\n\n";
+    }
+    
+    pgn::ParserOptions options;
+    options.replay_moves = true;
+    pgn::Parser parser(options);
+    bool ok = parser.load_file(filename);
+    std::remove(filename.c_str());
+    
+    const auto& views = parser.get_game_views();
+    ok = ok && views.size() == 4 && parser.get_stats().invalid_move_games == 1 &&
+         views[0].moves_valid && views[0].move_count == 5 &&
+         views[1].moves_valid && views[1].move_count == 2 &&
+         !views[2].moves_valid && views[2].move_count == 2 &&
+         views[3].moves_valid && views[3].move_count == 2;
+    std::cout << (ok ? "Move counts and invalid games as expected\n\n" : "Replay stage FAILED\n\n");
+    return ok;
+}
+
+int main(int argc, char* argv[]) {
+    int games = argc > 1 ? std::atoi(argv[1]) : 20000;
+    
+    bool ok = run_perft();
+    ok &= run_replay(games);
+    ok &= run_load_stage();
+    if (argc > 2) load_with_replay(argv[2], argc > 3 ? std::atoi(argv[3]) : 1);
+    std::cout << (ok ? "All tests passed\n" : "Some tests FAILED\n");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,198 @@
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+#include <pgn/generator.hpp>
+#include <pgn/movetext.hpp>
+#include <pgn/parser.hpp>
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+// Peak resident set size of the whole run, in KB.
+long process_peak_rss_kb() {
+#ifndef _WIN32
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+#else
+    return 0;
+#endif
+}
+
+// On Linux the peak can be reset, so each stage reports its own; elsewhere
+// stages report the peak so far.
+void reset_peak_rss() {
+#ifdef __linux__
+    std::ofstream("/proc/self/clear_refs") << "5";
+#endif
+}
+
+long stage_peak_rss_kb() {
+#ifdef __linux__
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.compare(0, 6, "VmHWM:") == 0) return std::atol(line.c_str() + 6);
+    }
+#endif
+    return process_peak_rss_kb();
+}
+
+struct Stage {
+    std::string name;
+    double seconds = 1e30;
+    long peak_rss_kb = 0;
+    uint64_t output_bytes = 0;
+    
+    void record(double elapsed) {
+        seconds = std::min(seconds, elapsed);
+        peak_rss_kb = std::max(peak_rss_kb, stage_peak_rss_kb());
+    }
+};
+
+double seconds_since(std::chrono::high_resolution_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+uint64_t file_size(const std::string& filename) {
+    std::ifstream file(filename, std::ios::binary | std::ios::ate);
+    return file ? static_cast<uint64_t>(file.tellg()) : 0;
+}
+
+// Replays every game's main line, split across `threads` like the parser
+// splits its input.
+uint64_t replay_all(const std::vector<pgn::GameView>& games, unsigned threads) {
+    std::vector<uint64_t> plies(threads, 0);
+    std::vector<std::thread> workers;
+    for (unsigned t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t] {
+            size_t begin = games.size() * t / threads;
+            size_t end = games.size() * (t + 1) / threads;
+            for (size_t i = begin; i < end; ++i) {
+                pgn::Position position;
+                plies[t] += pgn::replay_movetext(games[i].movetext, position).plies;
+            }
+        });
+    }
+    for (auto& worker : workers) worker.join();
+    uint64_t total = 0;
+    for (uint64_t count : plies) total += count;
+    return total;
+}
+
+// Runs each stage of the pipeline on its own over a generated file and
+// prints the timings as JSON, best of `runs`:
+//
+//     pipeline_benchmark.exe [games] [seed] [threads] [runs]
+int main(int argc, char* argv[]) {
+    pgn::GeneratorOptions generator_options;
+    generator_options.games = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 200000;
+    generator_options.seed = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 1;
+    // 0 threads means one per core.
+    unsigned threads = argc > 3 ? std::atoi(argv[3]) : 0;
+    int runs = argc > 4 ? std::max(std::atoi(argv[4]), 1) : 3;
+    if (threads == 0) threads = std::max(std::thread::hardware_concurrency(), 1u);
+    const std::string filename = "pipeline_benchmark.pgn";
+    const std::string export_prefix = "pipeline_benchmark_export";
+    
+    auto start = std::chrono::high_resolution_clock::now();
+    try {
+        pgn::GameGenerator(generator_options).write_file(filename);
+    } catch (const std::exception& e) {
+        std::cerr << "Error generating file: " << e.what() << "\n";
+        return 1;
+    }
+    double generate_seconds = seconds_since(start);
+    long generate_peak_rss_kb = stage_peak_rss_kb();
+    uint64_t bytes = file_size(filename);
+    
+    Stage io{"io"}, tag_scan{"tag_scan"}, movetext{"movetext"}, aggregation{"aggregation"},
+        export_stage{"export"};
+    pgn::ParserOptions options;
+    options.threads = threads;
+    pgn::Parser parser(options);
+    int games = 0;
+    uint64_t plies = 0;
+    
+    for (int run = 0; run < runs; ++run) {
+        reset_peak_rss();
+        start = std::chrono::high_resolution_clock::now();
+        {
+            std::ifstream file(filename, std::ios::binary);
+            std::ostringstream contents;
+            contents << file.rdbuf();
+            if (contents.str().size() != bytes) return 1;
+        }
+        io.record(seconds_since(start));
+        
+        // Parsing and aggregation are timed by the parser itself.
+        reset_peak_rss();
+        if (!parser.load_file(filename)) return 1;
+        const pgn::DatabaseStats& stats = parser.get_stats();
+        tag_scan.record(stats.parsing_time_seconds);
+        aggregation.record(stats.analysis_time_seconds);
+        games = stats.total_games;
+        
+        reset_peak_rss();
+        start = std::chrono::high_resolution_clock::now();
+        plies = replay_all(parser.get_game_views(), threads);
+        movetext.record(seconds_since(start));
+        
+        reset_peak_rss();
+        start = std::chrono::high_resolution_clock::now();
+        bool exported = parser.export_player_stats_csv(export_prefix + "_players.csv") &&
+                        parser.export_tournaments_csv(export_prefix + "_tournaments.csv") &&
+                        parser.export_stats_binary(export_prefix + ".bin");
+        export_stage.record(seconds_since(start));
+        if (!exported) return 1;
+        export_stage.output_bytes = file_size(export_prefix + "_players.csv") +
+                                    file_size(export_prefix + "_tournaments.csv") +
+                                    file_size(export_prefix + ".bin");
+    }
+    
+    const pgn::DatabaseStats& stats = parser.get_stats();
+    std::cout << std::fixed << "{\n"
+              << "  \"benchmark\": \"pipeline\",\n"
+              << "  \"games\": " << games << ",\n"
+              << "  \"seed\": " << generator_options.seed << ",\n"
+              << "  \"threads\": " << threads << ",\n"
+              << "  \"runs\": " << runs << ",\n"
+              << "  \"input_bytes\": " << bytes << ",\n"
+              << "  \"players\": " << stats.unique_players << ",\n"
+              << "  \"tournaments\": " << stats.unique_tournaments << ",\n"
+              << "  \"plies\": " << plies << ",\n"
+              << "  \"generate_seconds\": " << std::setprecision(6) << generate_seconds << ",\n"
+              << "  \"stages\": [\n";
+    const Stage* stages[] = {&io, &tag_scan, &movetext, &aggregation, &export_stage};
+    for (size_t i = 0; i < 5; ++i) {
+        const Stage& stage = *stages[i];
+        double seconds = std::max(stage.seconds, 1e-9);
+        std::cout << "    {\"stage\": \"" << stage.name << "\", \"seconds\": " << std::setprecision(6)
+                  << stage.seconds << ", \"games_per_second\": " << std::setprecision(0)
+                  << games / seconds << ", \"mb_per_second\": " << std::setprecision(1)
+                  << bytes / (1024.0 * 1024.0) / seconds << ", \"peak_rss_kb\": " << stage.peak_rss_kb;
+        if (stage.output_bytes) std::cout << ", \"output_bytes\": " << stage.output_bytes;
+        std::cout << "}" << (i + 1 < 5 ? "," : "") << "\n";
+    }
+    // Resetting the per-stage peak resets the process peak too.
+    long peak = generate_peak_rss_kb;
+    for (const Stage* stage : stages) peak = std::max(peak, stage->peak_rss_kb);
+    std::cout << "  ],\n"
+              << "  \"peak_rss_kb\": " << peak << "\n"
+              << "}\n";
+    
+    std::remove(filename.c_str());
+    std::remove((export_prefix + "_players.csv").c_str());
+    std::remove((export_prefix + "_tournaments.csv").c_str());
+    std::remove((export_prefix + ".bin").c_str());
+    return 0;
+}
@@ -0,0 +1,151 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <cstdio>
+#include <cstdint>
+#include <pgn/parser.hpp>
+
+// Builds a synthetic database with ratings, dates and ECO codes spread
+// widely enough that narrow queries select a small fraction of it.
+void write_synthetic_file(const std::string& filename, int games) {
+    std::ofstream out(filename, std::ios::binary);
+    static const char* results[] = {"1-0", "0-1", "1/2-1/2", "*"};
+    static const char* moves =
+        "1. e4 c5 2. Nf3 d6 3. d4 cxd4 4. Nxd4 Nf6 5. Nc3 a6 6. Be3 e5 7. Nb3 Be6 "
+        "8. f3 Be7 9. Qd2 O-O 10. O-O-O Nbd7 11. g4 b5 12. g5 b4 13. Ne2 Ne8 "
+        "14. f4 a5 15. f5 a4 16. Nbd4 exd4 17. Nxd4 b3 18. Kb1 bxc2+ 19. Nxc2 Bb3 "
+        "20. axb3 axb3 21. Na3 Ne5 22. h4 Ra4";
+    
+    uint64_t state = 11;
+    auto next = [&state](int bound) {
+        state = state * 6364136223846793005ull + 1442695040888963407ull;
+        return static_cast<int>((state >> 33) % static_cast<uint64_t>(bound));
+    };
+    
+    for (int i = 0; i < games; ++i) {
+        int white = next(5000);
+        int black = (white + 1 + next(4999)) % 5000;
+        const char* result = results[next(4)];
+        out << "[Event \"Event " << next(2000) << "\"]\n"
+            << "[Site \"City " << next(300) << "\"]\n"
+            << "[Date \"" << 1990 + next(35) << "." << std::setw(2) << std::setfill('0')
+            << 1 + next(12) << "." << std::setw(2) << 1 + next(28) << std::setfill(' ') << "\"]\n"
+            << "[Round \"" << 1 + next(11) << "\"]\n"
+            << "[White \"Player " << white << "\"]\n"
+            << "[Black \"Player " << black << "\"]\n"
+            << "[Result \"" << result << "\"]\n"
+            << "[WhiteElo \"" << 1800 + next(1000) << "\"]\n"
+            << "[BlackElo \"" << 1800 + next(1000) << "\"]\n"
+            << "[ECO \"" << static_cast<char>('A' + next(5)) << std::setw(2) << std::setfill('0')
+            << next(100) << std::setfill(' ') << "\"]\n\n"
+            << moves << " " << result << "\n\n";
+    }
+}
+
+double best_of_three(const std::function<void()>& run) {
+    double best = 0;
+    for (int i = 0; i < 3; ++i) {
+        auto start = std::chrono::high_resolution_clock::now();
+        run();
+        auto end = std::chrono::high_resolution_clock::now();
+        double seconds = std::chrono::duration<double>(end - start).count();
+        if (i == 0 || seconds < best) best = seconds;
+    }
+    return best;
+}
+
+void print_time(const std::string& label, double seconds, size_t matches, double baseline) {
+    std::cout << "  " << std::left << std::setw(24) << label << std::right << std::fixed
+              << std::setw(10) << std::setprecision(4) << seconds
+              << std::setw(10) << matches
+              << std::setw(9) << std::setprecision(2) << (seconds > 0 ? baseline / seconds : 0.0)
+              << "x\n";
+}
+
+// Times one query four ways and checks that they agree:
+//   load + filter  - load every game, then test each view;
+//   pushdown       - load_file() with the query, skipping games while scanning;
+//   streamed       - for_each_game() with the query;
+//   table select   - Query::select() over an already loaded table.
+bool run_query(const std::string& label, const std::string& filename, const pgn::Query& query,
+               const pgn::ParserOptions& options, const pgn::Parser& loaded) {
+    std::cout << label << "\n";
+    
+    size_t filtered = 0;
+    double baseline = best_of_three([&] {
+        pgn::Parser parser(options);
+        parser.load_file(filename);
+        filtered = 0;
+        for (const auto& game : parser.get_game_views()) {
+            if (query.matches(game)) filtered++;
+        }
+    });
+    print_time("load + filter", baseline, filtered, baseline);
+    
+    size_t pushed = 0;
+    double pushdown = best_of_three([&] {
+        pgn::Parser parser(options);
+        parser.load_file(filename, query);
+        pushed = parser.get_game_views().size();
+    });
+    print_time("pushdown", pushdown, pushed, baseline);
+    
+    size_t streamed_count = 0;
+    double streamed = best_of_three([&] {
+        pgn::Parser parser(options);
+        streamed_count = 0;
+        parser.for_each_game(filename, query, [&](const pgn::GameView&) { streamed_count++; });
+    });
+    print_time("streamed", streamed, streamed_count, baseline);
+    
+    size_t selected = 0;
+    double select = best_of_three([&] { selected = query.select(loaded.get_game_table()).size(); });
+    print_time("table select", select, selected, baseline);
+    
+    bool agree = filtered == pushed && pushed == streamed_count && streamed_count == selected;
+    if (!agree) std::cout << "  MISMATCH\n";
+    return agree;
+}
+
+int main(int argc, char* argv[]) {
+    std::string filename = argc > 1 ? argv[1] : "";
+    unsigned threads = argc > 2 ? std::atoi(argv[2]) : 1;
+    
+    bool synthetic = filename.empty();
+    if (synthetic) {
+        filename = "query_benchmark.pgn";
+        write_synthetic_file(filename, 300000);
+    }
+    
+    pgn::ParserOptions options;
+    options.threads = threads;
+    
+    pgn::Parser loaded(options);
+    if (!loaded.load_file(filename)) return 1;
+    std::cout << "Games: " << loaded.get_stats().total_games << ", threads: " << threads << "\n";
+    std::cout << "  " << std::left << std::setw(24) << "method" << std::right
+              << std::setw(10) << "seconds" << std::setw(10) << "games" << std::setw(10) << "speedup"
+              << "\n";
+    
+    bool ok = true;
+    ok &= run_query("Both players 2700+, Sicilian Najdorf (B90-B99)", filename,
+                    pgn::Query().min_elo(2700).eco("B90", "B99"), options, loaded);
+    ok &= run_query("White wins in 2015", filename,
+                    pgn::Query().year(2015, 2015).result(pgn::GameResult::white_win), options, loaded);
+    ok &= run_query("Games of one player", filename,
+                    pgn::Query().player(loaded.get_stats().player_names.empty()
+                                            ? std::string_view("Player 1")
+                                            : loaded.get_stats().player_names[0].str()),
+                    options, loaded);
+    ok &= run_query("Decisive games, first half of 2000", filename,
+                    pgn::Query().date("2000.01.01", "2000.06.30")
+                                .result(pgn::GameResult::white_win)
+                                .result(pgn::GameResult::black_win),
+                    options, loaded);
+    
+    if (synthetic) std::remove(filename.c_str());
+    std::cout << (ok ? "All methods agree\n" : "Methods disagree\n");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,143 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <pgn/generator.hpp>
+#include <pgn/parser.hpp>
+
+std::string date_string(uint32_t date) {
+    char text[16];
+    std::snprintf(text, sizeof(text), "%04d.%02d.%02d", pgn::date_year(date), pgn::date_month(date),
+                  pgn::date_day(date));
+    return text;
+}
+
+// Rating histories, tournament performance ratings and results by rating
+// over a generated database, checked against the game table.
+int main(int argc, char* argv[]) {
+    int games = argc > 1 ? std::atoi(argv[1]) : 500000;
+    unsigned threads = argc > 2 ? std::atoi(argv[2]) : std::thread::hardware_concurrency();
+    const std::string filename = "rating_analytics.pgn";
+    
+    pgn::GeneratorOptions generator;
+    generator.games = games;
+    pgn::GameGenerator(generator).write_file(filename);
+    {
+        // "????.??.??" is no date: the game counts, its ratings do not.
+        std::ofstream out(filename, std::ios::app);
+        out << "\n[Event \"Undated\"]\n[Site \"?\"]\n[Date \"????.??.??\"]\n[Round \"?\"]\n"
+               "[White \"Undated, Player\"]\n[Black \"Undated, Opponent\"]\n[Result \"1-0\"]\n"
+               "[WhiteElo \"2100\"]\n[BlackElo \"2000\"]\n\n1. e4 e5 2. Qh5 Nc6 3. Bc4 Nf6 4. Qxf7# 1-0\n";
+    }
+    
+    pgn::ParserOptions options;
+    options.threads = threads;
+    pgn::Parser plain(options);
+    auto start = std::chrono::high_resolution_clock::now();
+    plain.load_file(filename);
+    double plain_seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+    
+    options.rating_stats = true;
+    pgn::Parser parser(options);
+    start = std::chrono::high_resolution_clock::now();
+    parser.load_file(filename);
+    double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+    const pgn::DatabaseStats& stats = parser.get_stats();
+    const pgn::GameTable& table = parser.get_game_table();
+    
+    size_t points = 0;
+    size_t bytes = 0;
+    for (const auto& [name, player] : stats.player_stats) {
+        points += player.ratings.size();
+        bytes += player.ratings.memory_usage();
+    }
+    std::cout << "=== Rating analytics: " << stats.total_games << " games, " << stats.unique_players
+              << " players, " << threads << " threads ===\n"
+              << std::fixed << std::setprecision(3) << "Load: " << plain_seconds << " s plain, " << seconds
+              << " s with ratings\n"
+              << "Histories: " << points << " points in " << bytes / 1024 << " KB ("
+              << std::setprecision(2) << double(bytes) / std::max<size_t>(points, 1) << " bytes a point)\n";
+    
+    const pgn::PlayerStats* active = stats.find_player(stats.most_active_player.str());
+    std::vector<pgn::RatingPoint> history = active->ratings.points();
+    std::cout << "Most active, " << stats.most_active_player << ": " << history.size() << " points, peak "
+              << active->ratings.peak() << "\n";
+    for (size_t i = 0; i < history.size(); i += std::max<size_t>(1, history.size() / 5)) {
+        std::cout << "  " << date_string(history[i].date) << "  " << history[i].elo << "\n";
+    }
+    
+    const pgn::Tournament* largest = stats.find_tournament(stats.largest_tournament.str());
+    const pgn::TournamentScore* best = nullptr;
+    pgn::Symbol best_name;
+    // A single lucky game says little; count players with a few rated games.
+    int most_games = 0;
+    for (const auto& entry : largest->scores) most_games = std::max(most_games, entry.second.rated_games);
+    for (const auto& [name, score] : largest->scores) {
+        if (score.rated_games < std::min(most_games, 3)) continue;
+        if (!best || score.performance() > best->performance() ||
+            (score.performance() == best->performance() && name < best_name)) {
+            best = &score;
+            best_name = name;
+        }
+    }
+    std::cout << "Best performance in " << stats.largest_tournament << ": " << best_name << ", "
+              << std::setprecision(1) << best->points() << "/" << best->games << " against "
+              << best->average_opponent() << " = " << best->performance() << "\n";
+    
+    std::cout << "White's score by rating difference (actual / Elo expectation):\n";
+    for (size_t i = 0; i < pgn::EloHistogram::difference_buckets; i += 4) {
+        const auto& bucket = stats.elo_histogram.by_difference[i];
+        if (bucket.games() == 0) continue;
+        int difference = pgn::EloHistogram::difference_center(i);
+        double expected = 1.0 / (1.0 + std::pow(10.0, -difference / 400.0));
+        std::cout << "  " << std::setw(6) << difference << std::setw(9) << bucket.games()
+                  << std::setprecision(3) << std::setw(8) << bucket.white_score() << " / " << expected << "\n";
+    }
+    
+    // Counted again from the table's columns.
+    bool ok = true;
+    int rated = 0;
+    for (size_t i = 0; i < table.size(); ++i) {
+        bool decided = table.result(i) != pgn::GameResult::unknown;
+        rated += decided && pgn::elo_known(table.white_elos()[i]) && pgn::elo_known(table.black_elos()[i]);
+    }
+    int by_difference = 0;
+    int by_rating = 0;
+    for (const auto& bucket : stats.elo_histogram.by_difference) by_difference += bucket.games();
+    for (const auto& bucket : stats.elo_histogram.by_rating) by_rating += bucket.games();
+    ok = ok && by_difference == rated && by_rating == rated;
+    
+    int tournament_games = 0;
+    for (const auto& [name, score] : largest->scores) tournament_games += score.games;
+    ok = ok && tournament_games == 2 * largest->total_games &&
+         largest->scores.size() == static_cast<size_t>(largest->unique_players);
+    for (size_t i = 1; i < history.size(); ++i) {
+        ok = ok && (history[i - 1].date < history[i].date ||
+                    (history[i - 1].date == history[i].date && history[i - 1].elo < history[i].elo));
+    }
+    
+    const pgn::PlayerStats* undated = stats.find_player("Undated, Player");
+    ok = ok && undated && undated->total_games == 1 && undated->ratings.empty();
+    for (const auto& [name, player] : stats.player_stats) {
+        for (const auto& point : player.ratings.points()) ok = ok && pgn::date_known(point.date);
+    }
+    
+    // The same analytics from one thread.
+    options.threads = 1;
+    pgn::Parser serial(options);
+    serial.load_file(filename);
+    const pgn::PlayerStats* serial_active = serial.get_stats().find_player(stats.most_active_player.str());
+    const pgn::Tournament* serial_largest = serial.get_stats().find_tournament(stats.largest_tournament.str());
+    ok = ok && serial_active && serial_active->ratings.size() == history.size() &&
+         serial_active->ratings.latest().elo == active->ratings.latest().elo &&
+         serial_largest->scores.at(best_name).performance() == best->performance() &&
+         serial.get_stats().elo_histogram.by_difference[16].draws == stats.elo_histogram.by_difference[16].draws;
+    
+    std::remove(filename.c_str());
+    std::cout << (ok ? "Rating checks passed\n" : "Rating checks FAILED\n");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,111 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+#include <pgn/reader.hpp>
+#include <pgn/simd.hpp>
+
+// Writes a synthetic database of fully tagged games for when no input
+// file is given.
+void write_synthetic_file(const std::string& filename, int games) {
+    std::ofstream out(filename, std::ios::binary);
+    static const char* results[] = {"1-0", "0-1", "1/2-1/2", "*"};
+    
+    for (int i = 0; i < games; ++i) {
+        const char* result = results[i % 4];
+        out << "[Event \"Open " << (i % 97) << "\"]\n"
+            << "[Site \"City " << (i % 13) << "\"]\n"
+            << "[Date \"2023.05." << (10 + i % 18) << "\"]\n"
+            << "[Round \"" << (1 + i % 9) << "\"]\n"
+            << "[White \"Player " << (i * 7 % 5003) << ", A\"]\n"
+            << "[Black \"Player " << (i * 13 % 5003) << ", B\"]\n"
+            << "[Result \"" << result << "\"]\n"
+            << "[WhiteElo \"" << (1500 + i % 1200) << "\"]\n"
+            << "[BlackElo \"" << (1500 + i * 3 % 1200) << "\"]\n"
+            << "[ECO \"B" << (10 + i % 90) << "\"]\n"
+            << "[Opening \"Sicilian Defense\"]\n\n"
+            << "1. e4 c5 2. Nf3 d6 3. d4 cxd4 4. Nxd4 Nf6 5. Nc3 a6 6. Be3 e5 7. Nb3 Be6\n"
+            << "8. f3 Be7 9. Qd2 O-O 10. O-O-O Nbd7 11. g4 b5 12. g5 b4 " << result << "\n\n";
+    }
+}
+
+template <typename Fn>
+double best_of(int runs, Fn&& fn) {
+    double best = 1e30;
+    for (int i = 0; i < runs; ++i) {
+        auto start = std::chrono::high_resolution_clock::now();
+        fn();
+        auto end = std::chrono::high_resolution_clock::now();
+        best = std::min(best, std::chrono::duration<double>(end - start).count());
+    }
+    return best;
+}
+
+int main(int argc, char* argv[]) {
+    std::string filename = argc > 1 ? argv[1] : "scan_benchmark.pgn";
+    bool synthetic = argc <= 1;
+    if (synthetic) write_synthetic_file(filename, 200000);
+    
+    std::ifstream file(filename, std::ios::binary);
+    std::stringstream contents;
+    contents << file.rdbuf();
+    std::string text = contents.str();
+    double megabytes = text.size() / (1024.0 * 1024.0);
+    
+    std::cout << "=== libpgn Scanner Microbenchmark ===\n";
+    std::cout << "Input: " << filename << " (" << std::fixed << std::setprecision(1)
+              << megabytes << " MB)\n";
+    std::cout << "Detected SIMD level: " << pgn::simd_level_name(pgn::detected_simd_level()) << "\n\n";
+    
+    // Reference: the cost of just streaming the bytes through the CPU.
+    volatile uint64_t sink = 0;
+    double read_seconds = best_of(5, [&] {
+        uint64_t sum = 0;
+        for (size_t i = 0; i + 8 <= text.size(); i += 8) {
+            uint64_t word;
+            std::memcpy(&word, text.data() + i, 8);
+            sum += word;
+        }
+        sink = sum;
+    });
+    double memchr_seconds = best_of(5, [&] {
+        size_t lines = 0;
+        const char* p = text.data();
+        const char* end = p + text.size();
+        while ((p = static_cast<const char*>(std::memchr(p, '\n', end - p))) != nullptr) {
+            ++lines;
+            ++p;
+        }
+        sink = lines;
+    });
+    
+    std::cout << std::setw(22) << std::left << "memory read:" << std::right
+              << std::setprecision(0) << std::setw(8) << (megabytes / read_seconds) << " MB/s\n";
+    std::cout << std::setw(22) << std::left << "memchr newlines:" << std::right
+              << std::setw(8) << (megabytes / memchr_seconds) << " MB/s\n";
+    
+    for (pgn::SimdLevel level : {pgn::SimdLevel::scalar, pgn::SimdLevel::sse2, pgn::SimdLevel::avx2}) {
+        if (pgn::set_simd_level(level) != level) continue;
+        
+        size_t games = 0;
+        double seconds = best_of(3, [&] {
+            pgn::GameReader reader(filename);
+            pgn::GameView game;
+            games = 0;
+            while (reader.next(game)) ++games;
+        });
+        
+        std::string label = std::string("tag scan (") + pgn::simd_level_name(level) + "):";
+        std::cout << std::setw(22) << std::left << label << std::right
+                  << std::setw(8) << (megabytes / seconds) << " MB/s, "
+                  << std::setprecision(0) << (games / seconds) << " games/s\n";
+    }
+    pgn::set_simd_level(pgn::detected_simd_level());
+    
+    if (synthetic) std::remove(filename.c_str());
+    return 0;
+}
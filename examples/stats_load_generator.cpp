@@ -0,0 +1,163 @@
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+#include <pgn/generator.hpp>
+#include <pgn/server.hpp>
+
+// Point lookups, top-k and head-to-head queries from many connections at
+// once against a StatsServer, reporting latency percentiles. Without a
+// socket argument, serves a generated database in-process and checks the
+// answers against a local parse.
+int main(int argc, char* argv[]) {
+    std::string socket_path = argc > 1 ? argv[1] : "";
+    int clients = argc > 2 ? std::atoi(argv[2]) : 16;
+    int requests = argc > 3 ? std::atoi(argv[3]) : 20000;
+    const std::string filename = "stats_load_generator.pgn";
+    
+    bool in_process = socket_path.empty();
+    std::unique_ptr<pgn::StatsServer> server;
+    pgn::Parser local;
+    try {
+        if (in_process) {
+            pgn::GeneratorOptions generator;
+            generator.games = 200000;
+            pgn::GameGenerator(generator).write_file(filename);
+            local.load_file(filename);
+            
+            socket_path = "stats_load_generator.sock";
+            pgn::ParserOptions options;
+            options.threads = 0;
+            server = std::make_unique<pgn::StatsServer>(std::vector<std::string>{filename}, options);
+            if (!server->reload()) return 1;
+            server->start(socket_path);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
+    
+    bool ok = true;
+    std::vector<pgn::RankedName> names;
+    try {
+        pgn::StatsClient client(socket_path);
+        pgn::DatabaseSummary summary = client.summary();
+        names = client.top_players(1000);
+        std::cout << "=== Query server: " << summary.total_games << " games, " << clients
+                  << " clients x " << requests << " requests ===\n";
+        
+        if (in_process) {
+            const pgn::DatabaseStats& stats = local.get_stats();
+            auto player = client.player(names[0].name);
+            const pgn::PlayerStats* expected = stats.find_player(names[0].name);
+            ok = summary.total_games == stats.total_games && player && expected &&
+                 player->total_games == expected->total_games && player->wins == expected->wins &&
+                 names[0].games == stats.max_games_by_player &&
+                 !client.player("No Such Player") && !client.tournament("No Such Event");
+            
+            // Head-to-head of the two most active players, counted directly.
+            const pgn::GameTable& table = local.get_game_table();
+            pgn::HeadToHead expected_pair;
+            for (size_t i = 0; i < table.size(); ++i) {
+                std::string_view white = table.whites()[i].str();
+                std::string_view black = table.blacks()[i].str();
+                bool first_white = white == names[0].name && black == names[1].name;
+                if (!first_white && !(white == names[1].name && black == names[0].name)) continue;
+                expected_pair.games++;
+                pgn::GameResult result = table.result(i);
+                bool first_won = result == (first_white ? pgn::GameResult::white_win
+                                                        : pgn::GameResult::black_win);
+                if (result == pgn::GameResult::draw) {
+                    expected_pair.draws++;
+                } else if (first_won) {
+                    expected_pair.first_wins++;
+                } else if (result != pgn::GameResult::unknown) {
+                    expected_pair.second_wins++;
+                }
+            }
+            pgn::HeadToHead pair = client.head_to_head(names[0].name, names[1].name);
+            ok = ok && pair.games == expected_pair.games && pair.first_wins == expected_pair.first_wins &&
+                 pair.second_wins == expected_pair.second_wins && pair.draws == expected_pair.draws;
+        }
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
+    
+    std::vector<std::vector<double>> latencies(clients);
+    std::atomic<int> errors{0};
+    auto start = std::chrono::high_resolution_clock::now();
+    std::vector<std::thread> threads;
+    for (int c = 0; c < clients; ++c) {
+        threads.emplace_back([&, c] {
+            try {
+                pgn::StatsClient client(socket_path);
+                uint64_t state = 0x9e3779b97f4a7c15ull * (c + 1);
+                auto next = [&state](size_t bound) {
+                    state = state * 6364136223846793005ull + 1442695040888963407ull;
+                    return static_cast<size_t>((state >> 33) % bound);
+                };
+                latencies[c].reserve(requests);
+                for (int i = 0; i < requests; ++i) {
+                    size_t kind = next(10);
+                    const std::string& name = names[next(names.size())].name;
+                    auto begin = std::chrono::high_resolution_clock::now();
+                    if (kind < 7) {
+                        if (!client.player(name)) errors++;
+                    } else if (kind == 7) {
+                        client.top_players(10);
+                    } else if (kind == 8) {
+                        client.top_tournaments(10);
+                    } else {
+                        client.head_to_head(name, names[next(names.size())].name);
+                    }
+                    auto end = std::chrono::high_resolution_clock::now();
+                    latencies[c].push_back(std::chrono::duration<double, std::micro>(end - begin).count());
+                }
+            } catch (const std::exception& e) {
+                std::cerr << e.what() << "\n";
+                errors++;
+            }
+        });
+    }
+    
+    // Swap the data in under load; no request may fail across the swap.
+    uint64_t generation = 0;
+    if (in_process) {
+        try {
+            pgn::StatsClient client(socket_path);
+            generation = client.reload();
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << "\n";
+            errors++;
+        }
+    }
+    for (auto& thread : threads) thread.join();
+    auto end = std::chrono::high_resolution_clock::now();
+    double seconds = std::chrono::duration<double>(end - start).count();
+    
+    std::vector<double> all;
+    for (const auto& client : latencies) all.insert(all.end(), client.begin(), client.end());
+    std::sort(all.begin(), all.end());
+    auto percentile = [&all](double p) {
+        return all.empty() ? 0.0 : all[std::min(all.size() - 1, static_cast<size_t>(p * all.size()))];
+    };
+    
+    std::cout << std::fixed << std::setprecision(0) << all.size() / seconds << " requests/s; latency us: p50 "
+              << std::setprecision(1) << percentile(0.50) << ", p99 " << percentile(0.99) << ", p99.9 "
+              << percentile(0.999) << ", max " << (all.empty() ? 0.0 : all.back()) << "\n";
+    if (in_process) std::cout << "Reloaded under load, generation " << generation << "\n";
+    
+    ok = ok && errors == 0 && (!in_process || generation == 2);
+    if (in_process) {
+        server->stop();
+        std::remove(filename.c_str());
+    }
+    std::cout << (ok ? "Server checks passed\n" : "Server checks FAILED\n");
+    return ok ? 0 : 1;
+}
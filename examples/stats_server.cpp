@@ -0,0 +1,51 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <pgn/server.hpp>
+
+#ifndef _WIN32
+#include <csignal>
+#include <pthread.h>
+#endif
+
+// Serves the statistics of the given files until interrupted; SIGHUP
+// reloads them.
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        std::cerr << "Usage: " << argv[0] << " <socket> <file.pgn>... \n";
+        return 1;
+    }
+#ifdef _WIN32
+    std::cerr << "stats_server needs Unix-domain sockets\n";
+    return 1;
+#else
+    // Signals are taken by sigwait() below, never by the serving threads.
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGHUP);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+    
+    pgn::ParserOptions options;
+    options.threads = 0;
+    pgn::StatsServer server(std::vector<std::string>(argv + 2, argv + argc), options);
+    if (!server.reload()) return 1;
+    try {
+        server.start(argv[1]);
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
+    std::cout << "Serving " << argc - 2 << " file(s) on " << argv[1] << "\n";
+    
+    for (;;) {
+        int signal = 0;
+        sigwait(&signals, &signal);
+        if (signal != SIGHUP) break;
+        if (server.reload()) std::cout << "Reloaded, generation " << server.generation() << "\n";
+    }
+    server.stop();
+    return 0;
+#endif
+}
@@ -0,0 +1,108 @@
+#pragma once
+#include "symbol_table.hpp"
+#include "types.hpp"
+#include <cstdint>
+#include <string>
+#include <type_traits>
+
+namespace pgn {
+
+// The fields of a Game, as a bit set for Parser::load<>(). Tag bits follow
+// TagKind in metrics.hpp; bit 10, FEN, is not a Game field.
+enum class Fields : uint32_t {
+    none = 0,
+    event = 1u << 0,
+    site = 1u << 1,
+    date = 1u << 2,
+    round = 1u << 3,
+    white = 1u << 4,
+    black = 1u << 5,
+    result = 1u << 6,
+    white_elo = 1u << 7,
+    black_elo = 1u << 8,
+    eco = 1u << 9,
+    opening = 1u << 11,
+    move_count = 1u << 12,
+    all = 0x1BFF,
+};
+
+constexpr Fields operator|(Fields a, Fields b) {
+    return static_cast<Fields>(static_cast<uint32_t>(a) | static_cast<uint32_t>(b));
+}
+
+constexpr Fields operator&(Fields a, Fields b) {
+    return static_cast<Fields>(static_cast<uint32_t>(a) & static_cast<uint32_t>(b));
+}
+
+constexpr bool has_field(Fields set, Fields field) {
+    return (set & field) == field;
+}
+
+namespace detail {
+
+// A field's member, or an empty base that takes no space.
+template <Fields F>
+struct NoField {};
+
+template <Fields Set, Fields F, typename Member>
+using FieldBase = std::conditional_t<has_field(Set, F), Member, NoField<F>>;
+
+struct EventField { Symbol event; };
+struct SiteField { Symbol site; };
+struct DateField { std::string date; };
+struct RoundField { std::string round; };
+struct WhiteField { Symbol white; };
+struct BlackField { Symbol black; };
+struct ResultField {
+    std::string result;
+    
+    bool is_white_win() const { return result == "1-0"; }
+    bool is_black_win() const { return result == "0-1"; }
+    bool is_draw() const { return result == "1/2-1/2"; }
+    bool is_unknown_result() const { return result == "*"; }
+};
+struct WhiteEloField { std::string white_elo; };
+struct BlackEloField { std::string black_elo; };
+struct EcoField { Symbol eco; };
+struct OpeningField { Symbol opening; };
+struct MoveCountField { int move_count = 0; };
+
+} // namespace detail
+
+// A Game with only the members selected by `F`, of the same names and
+// types; GameRecord<Fields::all> holds what Game does. Members that are
+// not selected do not exist, so naming one fails to compile.
+template <Fields F>
+struct GameRecord : detail::FieldBase<F, Fields::event, detail::EventField>,
+                    detail::FieldBase<F, Fields::site, detail::SiteField>,
+                    detail::FieldBase<F, Fields::date, detail::DateField>,
+                    detail::FieldBase<F, Fields::round, detail::RoundField>,
+                    detail::FieldBase<F, Fields::white, detail::WhiteField>,
+                    detail::FieldBase<F, Fields::black, detail::BlackField>,
+                    detail::FieldBase<F, Fields::result, detail::ResultField>,
+                    detail::FieldBase<F, Fields::white_elo, detail::WhiteEloField>,
+                    detail::FieldBase<F, Fields::black_elo, detail::BlackEloField>,
+                    detail::FieldBase<F, Fields::eco, detail::EcoField>,
+                    detail::FieldBase<F, Fields::opening, detail::OpeningField>,
+                    detail::FieldBase<F, Fields::move_count, detail::MoveCountField> {
+    static constexpr Fields fields = F;
+    
+    GameRecord() = default;
+    
+    explicit GameRecord(const GameView& game) {
+        if constexpr (has_field(F, Fields::event)) this->event = intern(game.event);
+        if constexpr (has_field(F, Fields::site)) this->site = intern(game.site);
+        if constexpr (has_field(F, Fields::date)) this->date = std::string(game.date);
+        if constexpr (has_field(F, Fields::round)) this->round = std::string(game.round);
+        if constexpr (has_field(F, Fields::white)) this->white = intern(game.white);
+        if constexpr (has_field(F, Fields::black)) this->black = intern(game.black);
+        if constexpr (has_field(F, Fields::result)) this->result = std::string(game.result);
+        if constexpr (has_field(F, Fields::white_elo)) this->white_elo = std::string(game.white_elo);
+        if constexpr (has_field(F, Fields::black_elo)) this->black_elo = std::string(game.black_elo);
+        if constexpr (has_field(F, Fields::eco)) this->eco = intern(game.eco);
+        if constexpr (has_field(F, Fields::opening)) this->opening = intern(game.opening);
+        if constexpr (has_field(F, Fields::move_count)) this->move_count = game.move_count;
+    }
+};
+
+} // namespace pgn
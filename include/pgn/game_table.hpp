@@ -0,0 +1,162 @@
+#pragma once
+#include "types.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace pgn {
+
+enum class GameResult : uint8_t {
+    unknown = 0,
+    white_win = 1,
+    black_win = 2,
+    draw = 3,
+};
+
+GameResult parse_result(std::string_view text);
+std::string_view result_text(GameResult result);
+
+// Compact encodings used by GameTable. Each reserves 0 for an empty tag and
+// an all-ones value for text that does not fit the encoding; such text is
+// kept verbatim by the table so rows round-trip exactly.
+//
+// Elo:  the rating as written, 1..65534.
+// Date: 1 << 31 | (year + 1) << 9 | month << 5 | day, with 0 for each "??"
+//       part, so packed dates order chronologically.
+// ECO:  1 + 100 * (letter - 'A') + number, for A00..E99.
+constexpr uint16_t raw_elo = 0xFFFF;
+constexpr uint32_t raw_date = 0xFFFFFFFF;
+constexpr uint16_t raw_eco = 0xFFFF;
+
+uint16_t encode_elo(std::string_view text);
+uint32_t encode_date(std::string_view text);
+uint16_t encode_eco(std::string_view text);
+
+// Text of a packed date, as "YYYY.MM.DD" with "??" for unknown parts.
+std::string date_text(uint32_t date);
+
+constexpr bool elo_known(uint16_t elo) { return elo != 0 && elo != raw_elo; }
+// A date is known when its year is: "????.??.??", the usual placeholder,
+// packs to 1 << 31 but says no more than an empty tag. The parts of a
+// packed date read as -1 (year) or 0 (month, day) when unknown.
+constexpr bool date_packed(uint32_t date) { return date != 0 && date != raw_date; }
+constexpr bool date_known(uint32_t date) { return date_packed(date) && ((date >> 9) & 0x3FFF) != 0; }
+constexpr int date_year(uint32_t date) { return date_packed(date) ? int((date >> 9) & 0x3FFF) - 1 : -1; }
+constexpr int date_month(uint32_t date) { return date_packed(date) ? int((date >> 5) & 0xF) : 0; }
+constexpr int date_day(uint32_t date) { return date_packed(date) ? int(date & 0x1F) : 0; }
+
+// Interned name of an ECO code ("" for 0 or raw_eco).
+Symbol eco_symbol(uint16_t code);
+
+// Games stored column by column: one contiguous array per field, with
+// names as symbols and results, ratings, dates and ECO codes in fixed-width
+// encodings. Scans over a single field touch only that field's memory.
+class GameTable {
+public:
+    struct ResultCounts {
+        size_t white_wins = 0;
+        size_t black_wins = 0;
+        size_t draws = 0;
+        size_t unknown = 0;
+    };
+    
+    size_t size() const { return move_counts_.size(); }
+    bool empty() const { return move_counts_.empty(); }
+    
+    // Every column of a table, moved in whole so that a saved table (the
+    // .pgnidx sidecar) is restored without re-encoding any value. `raw`
+    // holds the verbatim text of values the encodings cannot hold, keyed
+    // by row * 5 + field, the fields being result, date, white Elo, black
+    // Elo and ECO.
+    struct Columns {
+        std::vector<Symbol> events;
+        std::vector<Symbol> sites;
+        std::vector<Symbol> rounds;
+        std::vector<Symbol> whites;
+        std::vector<Symbol> blacks;
+        std::vector<Symbol> openings;
+        std::vector<uint32_t> dates;
+        std::vector<uint16_t> white_elos;
+        std::vector<uint16_t> black_elos;
+        std::vector<uint16_t> eco_codes;
+        std::vector<int> move_counts;
+        std::vector<uint64_t> offsets;
+        std::vector<uint64_t> results;
+        std::unordered_map<uint64_t, Symbol> raw;
+    };
+    
+    void clear();
+    void reserve(size_t games);
+    void append(const GameView& game);
+    void append(const GameTable& other);
+    // Replaces the contents. Every column must have the same number of
+    // rows, and `results` one word for each 32 of them.
+    void assign(Columns&& columns);
+    
+    // Materializes one row as an owning Game.
+    Game row(size_t index) const;
+    
+    // One row as a GameView with no movetext. Names, ECO codes, results
+    // and verbatim text point into the symbol table or static storage;
+    // dates and ratings are formatted into `formatted`, once per distinct
+    // value, which must outlive the view.
+    GameView view(size_t index, std::unordered_map<uint32_t, std::string>& formatted) const;
+    
+    const std::vector<Symbol>& events() const { return events_; }
+    const std::vector<Symbol>& sites() const { return sites_; }
+    const std::vector<Symbol>& rounds() const { return rounds_; }
+    const std::vector<Symbol>& whites() const { return whites_; }
+    const std::vector<Symbol>& blacks() const { return blacks_; }
+    const std::vector<Symbol>& openings() const { return openings_; }
+    const std::vector<uint32_t>& dates() const { return dates_; }
+    const std::vector<uint16_t>& white_elos() const { return white_elos_; }
+    const std::vector<uint16_t>& black_elos() const { return black_elos_; }
+    const std::vector<uint16_t>& eco_codes() const { return eco_codes_; }
+    const std::vector<int>& move_counts() const { return move_counts_; }
+    const std::vector<uint64_t>& offsets() const { return offsets_; }
+    // The `raw` column of Columns.
+    const std::unordered_map<uint64_t, Symbol>& raw_values() const { return raw_; }
+    
+    // Results are packed 32 to a 64-bit word, two bits per game.
+    const std::vector<uint64_t>& result_words() const { return results_; }
+    GameResult result(size_t index) const {
+        return static_cast<GameResult>((results_[index / 32] >> (index % 32 * 2)) & 3);
+    }
+    
+    // ECO as an interned name, including text that has no code.
+    Symbol eco(size_t index) const;
+    
+    ResultCounts count_results() const { return count_results(0, size()); }
+    ResultCounts count_results(size_t begin, size_t end) const;
+    
+    // Bytes held by the columns and the verbatim-text side table.
+    size_t memory_usage() const;
+    
+private:
+    enum Field : uint8_t { result_field, date_field, white_elo_field, black_elo_field, eco_field, field_count };
+    
+    static uint64_t raw_key(size_t row, Field field) { return uint64_t(row) * field_count + field; }
+    Symbol raw_symbol(size_t row, Field field) const;
+    std::string raw_text(size_t row, Field field) const;
+    
+    std::vector<Symbol> events_;
+    std::vector<Symbol> sites_;
+    std::vector<Symbol> rounds_;
+    std::vector<Symbol> whites_;
+    std::vector<Symbol> blacks_;
+    std::vector<Symbol> openings_;
+    std::vector<uint32_t> dates_;
+    std::vector<uint16_t> white_elos_;
+    std::vector<uint16_t> black_elos_;
+    std::vector<uint16_t> eco_codes_;
+    std::vector<int> move_counts_;
+    std::vector<uint64_t> offsets_;
+    std::vector<uint64_t> results_;
+    // Text that the encodings above cannot reproduce, keyed by row and field.
+    std::unordered_map<uint64_t, Symbol> raw_;
+};
+
+} // namespace pgn
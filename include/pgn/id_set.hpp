@@ -0,0 +1,79 @@
+#pragma once
+#include "metrics.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory_resource>
+#include <vector>
+
+namespace pgn {
+
+// Set of small integer-like IDs (anything std::hash maps to a dense value,
+// such as uint32_t or Symbol) that remembers insertion order. Membership is
+// an open-addressing probe into a power-of-two slot table, so inserts and
+// lookups stay constant time on average however large the set grows. The
+// read accessors mirror std::vector so the set can stand in for a list.
+template <typename Id>
+class IdSet {
+public:
+    using value_type = Id;
+    using const_iterator = typename std::pmr::vector<Id>::const_iterator;
+    
+    IdSet() = default;
+    // Allocates from `resource` instead of the default heap. Copies of
+    // the set use the default heap again.
+    explicit IdSet(std::pmr::memory_resource* resource) : items_(resource), slots_(resource) {}
+    
+    bool insert(Id id) {
+        if ((items_.size() + 1) * 4 > slots_.size() * 3) grow();
+        
+        size_t slot = find_slot(id);
+        if (slots_[slot] != 0) return false;
+        
+        items_.push_back(id);
+        slots_[slot] = static_cast<uint32_t>(items_.size());
+        return true;
+    }
+    
+    bool contains(Id id) const {
+        return !slots_.empty() && slots_[find_slot(id)] != 0;
+    }
+    
+    size_t size() const { return items_.size(); }
+    bool empty() const { return items_.empty(); }
+    
+    // IDs in the order they were first inserted.
+    const std::pmr::vector<Id>& items() const { return items_; }
+    const Id& operator[](size_t index) const { return items_[index]; }
+    const_iterator begin() const { return items_.begin(); }
+    const_iterator end() const { return items_.end(); }
+    
+    void clear() {
+        items_.clear();
+        slots_.clear();
+    }
+    
+private:
+    // Slots hold 1-based indices into items_; 0 marks an empty slot.
+    size_t find_slot(Id id) const {
+        size_t mask = slots_.size() - 1;
+        size_t slot = (static_cast<uint32_t>(std::hash<Id>{}(id)) * 0x9E3779B1u) & mask;
+        while (slots_[slot] != 0 && !(items_[slots_[slot] - 1] == id)) {
+            slot = (slot + 1) & mask;
+        }
+        return slot;
+    }
+    
+    void grow() {
+        if (!slots_.empty()) detail::count_rehash(HashTable::id_sets);
+        slots_.assign(slots_.empty() ? 8 : slots_.size() * 2, 0);
+        for (size_t i = 0; i < items_.size(); ++i) {
+            slots_[find_slot(items_[i])] = static_cast<uint32_t>(i + 1);
+        }
+    }
+    
+    std::pmr::vector<Id> items_;
+    std::pmr::vector<uint32_t> slots_;
+};
+
+} // namespace pgn
@@ -0,0 +1,89 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+namespace pgn {
+
+// Process-wide counters for the parsing pipeline. Each thread counts into
+// a block of its own, so the hot paths never contend; metrics_snapshot()
+// sums the blocks and may be called from any thread, including while a
+// load is running. Counting is off until enable_metrics(true); while off,
+// each counting site costs one predictable branch. Building with
+// PGN_NO_METRICS removes the counting sites altogether.
+//
+//     pgn::enable_metrics(true);
+//     parser.load_file("games.pgn");
+//     pgn::MetricsSnapshot metrics = pgn::metrics_snapshot();
+
+// Timed stages. Times are summed over threads, and scan includes the
+// replay of moves when that is enabled. load is the wall-clock time of
+// the Parser calls that load games.
+enum class Stage : uint8_t { load, read, scan, replay, merge, analysis, index, save };
+constexpr size_t stage_count = 8;
+
+enum class TagKind : uint8_t {
+    event, site, date, round, white, black, result, white_elo, black_elo, eco, fen, opening,
+    // Tags the scanner does not keep, and malformed tag lines.
+    other
+};
+constexpr size_t tag_kind_count = 13;
+
+enum class HashTable : uint8_t {
+    // SymbolTable::global().
+    symbols,
+    // Names seen by each parsing worker.
+    chunk_names,
+    // Player and tournament maps of DatabaseStats.
+    statistics,
+    // IdSet, e.g. each player's opponents.
+    id_sets,
+    opening_tree,
+    // Game fingerprints kept by ParserOptions::deduplicate.
+    fingerprints
+};
+constexpr size_t hash_table_count = 6;
+
+struct MetricsSnapshot {
+    struct Timer {
+        uint64_t calls = 0;
+        double seconds = 0.0;
+    };
+    
+    Timer stages[stage_count];
+    // Bytes of PGN text scanned into games, after decompression.
+    uint64_t bytes_read = 0;
+    // Games scanned, including those a query skipped.
+    uint64_t games = 0;
+    uint64_t tag_lines[tag_kind_count] = {};
+    // Blocks the parsers' arenas took from the heap, and their size.
+    uint64_t arena_allocations = 0;
+    uint64_t arena_bytes = 0;
+    uint64_t rehashes[hash_table_count] = {};
+    // Load factor when last measured: the symbol table when the snapshot
+    // is taken, the others at the end of each load. 0 if never measured.
+    double load_factors[hash_table_count] = {};
+    
+    const Timer& stage(Stage which) const { return stages[size_t(which)]; }
+    uint64_t tags(TagKind kind) const { return tag_lines[size_t(kind)]; }
+    uint64_t rehash_count(HashTable table) const { return rehashes[size_t(table)]; }
+    double load_factor(HashTable table) const { return load_factors[size_t(table)]; }
+    
+    // Throughput over the wall-clock time of loads.
+    double games_per_second() const;
+    double megabytes_per_second() const;
+};
+
+void enable_metrics(bool enabled);
+bool metrics_enabled();
+MetricsSnapshot metrics_snapshot();
+// Zeroes every counter.
+void reset_metrics();
+
+namespace detail {
+
+// Lets header-only containers such as IdSet count their rehashes.
+void count_rehash(HashTable table);
+
+} // namespace detail
+
+} // namespace pgn
@@ -0,0 +1,36 @@
+#pragma once
+#include "position.hpp"
+#include <cstddef>
+#include <string_view>
+
+namespace pgn {
+
+// Splits movetext into the SAN tokens of its main line. Move numbers,
+// comments ({...} and ;...), NAGs ($n), variations and the game result
+// are skipped; tokens keep any trailing check marks and annotation glyphs,
+// which Position::parse_san() ignores.
+class MovetextTokenizer {
+public:
+    explicit MovetextTokenizer(std::string_view text) : text_(text) {}
+    
+    bool next(std::string_view& san);
+    
+private:
+    std::string_view text_;
+    size_t pos_ = 0;
+    int depth_ = 0;
+};
+
+struct ReplayResult {
+    // Moves played, up to the end of the main line or the first bad move.
+    int plies = 0;
+    bool valid = true;
+    // Offset in the movetext of the token that could not be played.
+    size_t error_offset = 0;
+};
+
+// Plays the main line of `movetext` from `position`, which is left at the
+// last position reached.
+ReplayResult replay_movetext(std::string_view movetext, Position& position);
+
+} // namespace pgn
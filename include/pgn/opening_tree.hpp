@@ -0,0 +1,101 @@
+#pragma once
+#include "game_table.hpp"
+#include "position.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace pgn {
+
+// Positions from the opening phase of many games, keyed by Zobrist hash,
+// with the results reached from each and the moves played next.
+// Transpositions share an entry. Positions live in an open-addressing
+// table; each one heads a list of its next moves, so a lookup is one
+// probe sequence plus a walk over a few dozen moves at most.
+//
+//     pgn::Position position;
+//     for (const auto& next : tree.next_moves(position.hash())) { ... }
+class OpeningTree {
+public:
+    struct Counts {
+        uint32_t games = 0;
+        uint32_t white_wins = 0;
+        uint32_t draws = 0;
+        uint32_t black_wins = 0;
+        
+        void add(GameResult result);
+        void add(const Counts& other);
+    };
+    
+    struct NextMove {
+        // See encode_move().
+        uint16_t move;
+        Counts counts;
+    };
+    
+    // Records the first `max_plies` plies of each game.
+    explicit OpeningTree(int max_plies = 16);
+    
+    int max_plies() const { return max_plies_; }
+    size_t size() const { return size_; }
+    size_t move_count() const { return edges_.size(); }
+    size_t memory_usage() const;
+    // Positions per slot of the table.
+    double load_factor() const { return nodes_.empty() ? 0.0 : double(size_) / nodes_.size(); }
+    
+    // Replays the main line of `movetext` from `fen` (or the standard start)
+    // and counts every position visited, including the one reached after
+    // the last recorded ply. Stops early at a move that cannot be played.
+    void add_game(std::string_view movetext, GameResult result, std::string_view fen = {});
+    
+    // Adds the counts of `other`, which must record the same number of plies.
+    void merge(const OpeningTree& other);
+    
+    // Null if the position never occurred.
+    const Counts* find(uint64_t key) const;
+    // Moves played from the position, most frequent first.
+    std::vector<NextMove> next_moves(uint64_t key) const;
+    
+    // Little-endian file: the header "PGNTREE1", then positions sorted by
+    // key, each with its next moves in next_moves() order. Both throw
+    // std::runtime_error on I/O or format errors.
+    void save(const std::string& filename) const;
+    static OpeningTree load(const std::string& filename);
+    
+    // 16-bit move codes: from | to << 6 | promotion << 12, where promotion
+    // is 0 or the PieceType of the new piece.
+    static uint16_t encode_move(const Move& move);
+    // The legal move in `position` with `code`; false if there is none.
+    static bool decode_move(const Position& position, uint16_t code, Move& move);
+    
+private:
+    static constexpr uint32_t no_edge = 0xFFFFFFFF;
+    
+    struct Node {
+        uint64_t key = 0;
+        Counts counts;
+        uint32_t first_edge = no_edge;
+    };
+    
+    struct Edge {
+        uint16_t move;
+        uint32_t next;
+        Counts counts;
+    };
+    
+    size_t slot_of(uint64_t key) const;
+    size_t insert(uint64_t key);
+    void add_edge(size_t slot, uint16_t move, const Counts& counts);
+    void grow();
+    
+    int max_plies_;
+    // Power-of-two slots, allocated on first insert; key 0 marks an empty
+    // slot.
+    std::vector<Node> nodes_;
+    std::vector<Edge> edges_;
+    size_t size_ = 0;
+};
+
+} // namespace pgn
@@ -1,33 +1,230 @@
 #pragma once
+#include "fields.hpp"
+#include "game_table.hpp"
+#include "opening_tree.hpp"
+#include "query.hpp"
+#include "sketches.hpp"
 #include "types.hpp"
 #include <functional>
+#include <iterator>
 #include <memory>
 
 namespace pgn {
 
+struct ParserOptions {
+    // Map the input file into memory and scan it in place. When disabled,
+    // or when the input cannot be mapped (pipes, devices), the file is read
+    // into an owned buffer instead.
+    bool use_mmap = true;
+    
+    // When the input is read rather than mapped, read it in large blocks
+    // through io_uring on Linux kernels that allow it, else with blocking
+    // pread(). With io_uring, load_file(), for_each_game() and GameReader
+    // parse each block while the next ones are read; with pread() reading
+    // and parsing take turns. Other loads read the whole input first.
+    bool use_io_uring = true;
+    
+    // Number of worker threads used to parse a single file. The input is
+    // split into byte ranges that each start at an [Event "...] game
+    // boundary; results are identical to a serial parse. 0 selects
+    // std::thread::hardware_concurrency().
+    unsigned threads = 1;
+    
+    // Keep a binary sidecar index (<file>.pgnidx) next to the input. When a
+    // sidecar matching the file's size, modification time and content
+    // sample exists, load_file() restores the game table from it, which
+    // saves tokenizing the PGN but not building the statistics: those are
+    // recomputed from the table as after a parse, and that usually takes
+    // most of the load. Otherwise it parses normally and writes one.
+    bool use_index = false;
+    
+    // Replay each game's main line on a board instead of estimating
+    // move_count from the '.' characters of the movetext. move_count then
+    // counts the moves actually played, games with an undecodable or
+    // illegal move have moves_valid cleared, and the .pgnidx sidecar is
+    // neither read nor written.
+    bool replay_moves = false;
+    
+    // Build an OpeningTree over the first this many plies of every game
+    // loaded or streamed; 0 disables it. Like replay_moves, this needs the
+    // movetext, so the .pgnidx sidecar is neither read nor written.
+    int opening_tree_plies = 0;
+    
+    // Compute the headline statistics from fixed-size sketches instead of
+    // per-player and per-tournament tables; see ApproximateStats for the
+    // error bounds. Game and result counts stay exact, unique_players,
+    // unique_tournaments and the leaders become estimates, and the tables
+    // and name lists are left empty. Memory for the statistics is then
+    // under 2 MB per thread whatever the input; analyze_file() and
+    // for_each_game() keep no games either.
+    bool approximate_stats = false;
+    
+    // Drop games that repeat an earlier game of the same load, as when
+    // merging databases that overlap, before they are kept or counted;
+    // DatabaseStats::duplicate_games reports how many. Games are compared
+    // by a 128-bit fingerprint of the players, date, result, starting
+    // position and main-line moves, normalized so that formatting,
+    // comments, clocks and variations do not matter; games without moves
+    // are always kept. The first copy in input order is the one kept,
+    // whatever the number of threads. Costs 16 bytes per distinct game
+    // while loaded. The .pgnidx sidecar is neither read nor written.
+    bool deduplicate = false;
+    
+    // Also aggregate ratings, from the integer Elo and date columns of the
+    // game table: each player's rating history (PlayerStats::ratings),
+    // each player's score and performance rating per tournament
+    // (Tournament::scores), and results by rating in
+    // DatabaseStats::elo_histogram. Not with approximate_stats.
+    bool rating_stats = false;
+};
+
+// How one input of Parser::load_files() fared.
+struct FileTiming {
+    std::string filename;
+    uint64_t bytes = 0;
+    int games = 0;
+    // Opening plus parsing time, summed over the file's chunks, which may
+    // have been parsed on different threads at once.
+    double parse_seconds = 0.0;
+};
+
 class Parser {
 public:
+    // Called every 1000 games from the loading thread. For progress from
+    // any thread, and per-stage detail, see metrics_snapshot() in metrics.hpp.
     using ProgressCallback = std::function<void(int, const std::string&)>;
+    using GameVisitor = std::function<void(const GameView&)>;
     
     static DatabaseStats analyze_file(const std::string& filename, 
-                                     ProgressCallback callback = nullptr);
+                                     ProgressCallback callback = nullptr,
+                                     const ParserOptions& options = ParserOptions());
+    
+    // Reads just the fields in `F` from every game of the file, in file
+    // order, e.g. load<Fields::white | Fields::black | Fields::result>().
+    // Tags outside `F` are passed over by the scanner and other fields are
+    // never converted, interned or stored, and no statistics are built, so
+    // a narrow load runs well ahead of load_file(). Honors use_mmap,
+    // use_io_uring, threads and replay_moves; returns no games (after
+    // printing the error) if the file cannot be read.
+    template <Fields F>
+    static std::vector<GameRecord<F>> load(const std::string& filename,
+                                          const ParserOptions& options = ParserOptions());
     
     Parser();
+    explicit Parser(const ParserOptions& options);
     ~Parser();
     
+    void set_options(const ParserOptions& options);
+    const ParserOptions& get_options() const;
+    
     bool load_file(const std::string& filename, ProgressCallback callback = nullptr);
+    
+    // Loads only the games matching `query`; statistics cover just those
+    // games. Filters are applied while scanning, so games that fail on
+    // their tags are never copied or interned. A filtered load never
+    // writes a .pgnidx sidecar, but it does read one.
+    bool load_file(const std::string& filename, const Query& query,
+                   ProgressCallback callback = nullptr);
+    
+    // Parses only what was appended to `filename` since the last load of
+    // it and folds the new games into the games, name lists and
+    // statistics already loaded, so a refresh costs time in proportion to
+    // the new data. A trailing game is held back until its result has
+    // been written. The first call, or one after the file was truncated,
+    // rewritten, compressed or streamed, does a full load instead. A
+    // filter given to the last load_file() of the same file still applies.
+    bool load_appended(const std::string& filename, ProgressCallback callback = nullptr);
+    
+    // Loads several files as one database: games keep the order of the
+    // files, each game's offset is relative to its own file, and the
+    // statistics cover them all. Large files are split into chunks and
+    // small ones batched together; the pieces run on options.threads
+    // threads that steal work from each other. Sidecars are not used.
+    bool load_files(const std::vector<std::string>& filenames,
+                    ProgressCallback callback = nullptr);
+    
+    // load_files() on the regular files in `directory` whose names match
+    // `pattern` ('*' and '?' wildcards), in name order.
+    bool load_directory(const std::string& directory, const std::string& pattern = "*.pgn",
+                        ProgressCallback callback = nullptr);
+    
+    // One entry per input of the last load_files() or load_directory().
+    const std::vector<FileTiming>& get_file_timings() const;
+    
+    // True if the last load_file() was served from a .pgnidx sidecar.
+    bool loaded_from_index() const;
+    
+    // Streams the file one game at a time, handing each game to `visitor`
+    // (which may be empty) and folding it into get_stats() before it is
+    // dropped. Games are not retained, so get_games() is empty afterwards
+    // and memory stays bounded regardless of file size.
+    bool for_each_game(const std::string& filename, GameVisitor visitor,
+                       ProgressCallback callback = nullptr);
+    bool for_each_game(const std::string& filename, const Query& query, GameVisitor visitor,
+                       ProgressCallback callback = nullptr);
     const DatabaseStats& get_stats() const;
+    // The sketches behind get_stats() when options.approximate_stats was
+    // set for the last load; empty otherwise.
+    const ApproximateStats& get_approximate_stats() const;
     
+    // Built from the game table on the first call after a load. Like the
+    // other const getters, safe to call from several threads at once, but
+    // not while a load is running.
     const std::vector<Game>& get_games() const;
-    const std::unordered_map<std::string, PlayerStats>& get_player_stats() const;
-    const std::unordered_map<std::string, Tournament>& get_tournaments() const;
+    // After a load from a .pgnidx sidecar the views are made from the game
+    // table on the first call, and their text is the table's rather than
+    // the source file's.
+    const std::vector<GameView>& get_game_views() const;
+    // The loaded games in columnar form; get_games() materializes its rows.
+    const GameTable& get_game_table() const;
+    const std::pmr::unordered_map<Symbol, PlayerStats>& get_player_stats() const;
+    const std::pmr::unordered_map<Symbol, Tournament>& get_tournaments() const;
+    
+    // Write one row per player or tournament, in order of first appearance.
+    // With options.threads > 1, rows are formatted on that many threads.
+    // Return false (after printing the error) if the file cannot be written.
+    bool export_player_stats_csv(const std::string& filename) const;
+    bool export_tournaments_csv(const std::string& filename) const;
+    // Both tables in a little-endian columnar layout; see stats_export.hpp.
+    bool export_stats_binary(const std::string& filename) const;
+    
+    // Empty unless options.opening_tree_plies was set for the last load.
+    const OpeningTree& get_opening_tree() const;
+    bool export_opening_tree(const std::string& filename) const;
     
-    void export_player_stats_csv(const std::string& filename) const;
-    void export_tournaments_csv(const std::string& filename) const;
-
 private:
+    // Behind load<>(): `begin` gets the number of chunks the file is read
+    // in, then `add` each chunk's games in order, in batches, with only the
+    // tags in `fields` set. Chunks may be added on different threads at once.
+    using ChunkVisitor = std::function<void(size_t, const std::vector<GameView>&)>;
+    static bool scan_fields(const std::string& filename, const ParserOptions& options,
+                            Fields fields, const std::function<void(size_t)>& begin,
+                            const ChunkVisitor& add);
+    
     struct Impl;
     std::unique_ptr<Impl> pimpl;
 };
 
-} // namespace pgn
\ No newline at end of file
+template <Fields F>
+std::vector<GameRecord<F>> Parser::load(const std::string& filename, const ParserOptions& options) {
+    std::vector<std::vector<GameRecord<F>>> parts;
+    bool loaded = scan_fields(
+        filename, options, F, [&](size_t chunks) { parts.resize(chunks); },
+        [&](size_t chunk, const std::vector<GameView>& games) {
+            for (const auto& game : games) parts[chunk].emplace_back(game);
+        });
+    if (!loaded) return {};
+    if (parts.size() == 1) return std::move(parts[0]);
+    
+    size_t total = 0;
+    for (const auto& part : parts) total += part.size();
+    std::vector<GameRecord<F>> records;
+    records.reserve(total);
+    for (auto& part : parts) {
+        records.insert(records.end(), std::make_move_iterator(part.begin()),
+                       std::make_move_iterator(part.end()));
+    }
+    return records;
+}
+
+} // namespace pgn
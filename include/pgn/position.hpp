@@ -0,0 +1,113 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace pgn {
+
+// One bit per square, a1 = bit 0, b1 = bit 1, ..., h8 = bit 63.
+using Bitboard = uint64_t;
+
+enum class Color : uint8_t { white, black };
+enum class PieceType : uint8_t { pawn, knight, bishop, rook, queen, king, none };
+
+constexpr Color operator~(Color color) { return Color(int(color) ^ 1); }
+
+struct Move {
+    enum Kind : uint8_t { normal, double_push, en_passant, castling, promotion, null_move };
+    
+    uint8_t from = 0;
+    uint8_t to = 0;
+    Kind kind = normal;
+    // The piece a pawn becomes; only meaningful for promotions.
+    PieceType promoted = PieceType::none;
+    
+    friend bool operator==(const Move& a, const Move& b) {
+        return a.from == b.from && a.to == b.to && a.kind == b.kind && a.promoted == b.promoted;
+    }
+    friend bool operator!=(const Move& a, const Move& b) { return !(a == b); }
+};
+
+// Fixed-capacity list; no legal chess position has more than 218 moves.
+struct MoveList {
+    Move moves[256];
+    size_t count = 0;
+    
+    void push(const Move& move) { moves[count++] = move; }
+    const Move* begin() const { return moves; }
+    const Move* end() const { return moves + count; }
+    size_t size() const { return count; }
+};
+
+// A chess position stored as piece and color bitboards plus a square to
+// piece lookup. Positions are small and cheap to copy; play() updates one
+// in place.
+class Position {
+public:
+    static constexpr std::string_view start_fen =
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+    
+    // The standard starting position.
+    Position();
+    
+    // Returns false, leaving the position unchanged, if `fen` is malformed.
+    // The move counters may be omitted.
+    bool set_fen(std::string_view fen);
+    std::string fen() const;
+    
+    Color side_to_move() const { return side_; }
+    PieceType piece_on(int square) const { return PieceType(board_[square]); }
+    Bitboard pieces(Color color) const { return colors_[int(color)]; }
+    Bitboard pieces(Color color, PieceType type) const {
+        return colors_[int(color)] & types_[int(type)];
+    }
+    Bitboard occupied() const { return colors_[0] | colors_[1]; }
+    // En passant target square, or -1.
+    int en_passant_square() const { return ep_square_; }
+    int fullmove_number() const { return fullmove_; }
+    
+    // Zobrist key of the placement, side to move, castling rights and any
+    // en passant capture that is available. Keys are stable across runs.
+    uint64_t hash() const;
+    
+    bool in_check() const;
+    bool attacked(int square, Color by) const;
+    
+    void legal_moves(MoveList& moves) const;
+    bool is_legal(const Move& move) const;
+    
+    // Plays a legal move (or a null move) in place.
+    void play(const Move& move);
+    
+    // Decodes a SAN move such as "Nbd7", "exd6", "O-O" or "e8=Q+" in this
+    // position. Check marks and annotation glyphs are ignored. Returns false
+    // if the text names no legal move or more than one.
+    bool parse_san(std::string_view san, Move& move) const;
+    std::string san(const Move& move) const;
+    
+private:
+    void clear();
+    void put(int square, Color color, PieceType type);
+    void remove(int square);
+    bool leaves_king_safe(const Move& move) const;
+    Bitboard attackers(int square, Color by, Bitboard occupied) const;
+    bool parse_castling(bool king_side, Move& move) const;
+    void add_castling(MoveList& moves) const;
+    
+    Bitboard colors_[2] = {};
+    Bitboard types_[6] = {};
+    uint8_t board_[64] = {};
+    Color side_ = Color::white;
+    // Bit 0: white king side, 1: white queen side, 2: black king side, 3: black queen side.
+    uint8_t castling_ = 0;
+    int8_t ep_square_ = -1;
+    int halfmove_clock_ = 0;
+    int fullmove_ = 1;
+    uint64_t piece_key_ = 0;
+};
+
+// Number of leaf nodes of the legal move tree `depth` plies deep.
+uint64_t perft(const Position& position, int depth);
+
+} // namespace pgn
@@ -0,0 +1,102 @@
+#pragma once
+#include "game_table.hpp"
+#include "types.hpp"
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace pgn {
+
+// Conjunction of game filters. Each call narrows the query further:
+//
+//     pgn::Query query = pgn::Query()
+//         .min_elo(2500)          // both players
+//         .eco("B90", "B99")
+//         .year(2019, 2019);
+//
+// Filters on tags are checked as soon as a game's tag section has been
+// read. The movetext of a game that fails is still scanned for the next
+// game's start, but the game is neither replayed nor copied; it counts
+// towards MetricsSnapshot::games and bytes_read, which measure scanning.
+// Games whose tag is missing or unparsable fail any range filter on that
+// tag.
+class Query {
+public:
+    using Predicate = std::function<bool(const GameView&)>;
+    
+    // Inclusive rating ranges.
+    Query& white_elo(int min, int max);
+    Query& black_elo(int min, int max);
+    Query& min_elo(int min);
+    
+    // Inclusive date range on YYYY.MM.DD strings. Dates with unknown parts
+    // sort before the known ones, so "2019.??.??" falls outside
+    // 2019.01.01-2019.12.31 but inside year(2019, 2019). Both bounds need
+    // a known year.
+    Query& date(std::string_view from, std::string_view to);
+    Query& year(int from, int to);
+    
+    // Inclusive ECO range, e.g. eco("B90", "B99").
+    Query& eco(std::string_view from, std::string_view to);
+    
+    // Exact names. player() matches either color; calling it twice selects
+    // games between the two players.
+    Query& player(std::string_view name);
+    Query& white(std::string_view name);
+    Query& black(std::string_view name);
+    Query& event(std::string_view name);
+    
+    // Allowed results; repeat to allow several.
+    Query& result(GameResult result);
+    
+    // Inclusive range on the number of moves, checked after the movetext
+    // has been scanned.
+    Query& moves(int min, int max);
+    
+    // Arbitrary check on the complete game, run after the built-in filters.
+    Query& where(Predicate predicate);
+    
+    bool empty() const { return checks_ == 0; }
+    
+    // Tag filters only; `game` needs its tags but not its move count.
+    bool matches_tags(const GameView& game) const;
+    // Move-count range and where() predicates on a fully scanned game.
+    bool matches_rest(const GameView& game) const;
+    bool matches(const GameView& game) const { return matches_tags(game) && matches_rest(game); }
+    
+    // Rows of an already loaded table that match, in order. where()
+    // predicates see a view built from the row.
+    std::vector<size_t> select(const GameTable& table) const;
+    
+private:
+    enum Check : uint32_t {
+        white_elo_check = 1 << 0,
+        black_elo_check = 1 << 1,
+        date_check = 1 << 2,
+        eco_check = 1 << 3,
+        player_check = 1 << 4,
+        white_check = 1 << 5,
+        black_check = 1 << 6,
+        event_check = 1 << 7,
+        result_check = 1 << 8,
+        moves_check = 1 << 9,
+        predicate_check = 1 << 10,
+    };
+    
+    uint32_t checks_ = 0;
+    uint16_t white_elo_min_ = 0, white_elo_max_ = 0;
+    uint16_t black_elo_min_ = 0, black_elo_max_ = 0;
+    uint32_t date_min_ = 0, date_max_ = 0;
+    uint16_t eco_min_ = 0, eco_max_ = 0;
+    int moves_min_ = 0, moves_max_ = 0;
+    uint8_t results_ = 0;
+    std::vector<std::string> players_;
+    std::string white_;
+    std::string black_;
+    std::string event_;
+    std::vector<Predicate> predicates_;
+};
+
+} // namespace pgn
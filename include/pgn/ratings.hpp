@@ -0,0 +1,135 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <vector>
+
+namespace pgn {
+
+// A rating seen on a date. Dates use GameTable's packed encoding (see
+// encode_date() and date_year() in game_table.hpp), which orders them
+// chronologically; ratings are as written.
+struct RatingPoint {
+    uint32_t date = 0;
+    uint16_t elo = 0;
+};
+
+// One player's ratings over time, oldest first, with one point per
+// distinct date and rating. Points may be added in any order; they wait
+// in a short buffer, which add() folds into the series whenever it fills
+// and seal() on demand. The series is kept as varint deltas from point to
+// point, typically 2 to 3 bytes a point.
+class RatingHistory {
+public:
+    RatingHistory() = default;
+    // Allocates from `resource` instead of the default heap. Copies of
+    // the history use the default heap again.
+    explicit RatingHistory(std::pmr::memory_resource* resource) : encoded_(resource), pending_(resource) {}
+    
+    void add(uint32_t date, uint16_t elo) {
+        uint64_t key = uint64_t(date) << 16 | elo;
+        // A player's games on one day usually share a rating.
+        if (!pending_.empty() && pending_.back() == key) return;
+        pending_.push_back(key);
+        if (pending_.size() == pending_limit) fold();
+    }
+    
+    // Takes over the points of `later`, which is left empty, and seals.
+    void merge(RatingHistory&& later);
+    
+    // Folds the points still waiting into the series and trims the
+    // storage to fit. The accessors below see only folded points.
+    void seal();
+    
+    size_t size() const { return count_; }
+    bool empty() const { return count_ == 0; }
+    std::vector<RatingPoint> points() const;
+    // The most recent point, and the highest rating; zero when empty.
+    RatingPoint latest() const { return latest_; }
+    uint16_t peak() const { return peak_; }
+    
+    size_t memory_usage() const {
+        return encoded_.capacity() + pending_.capacity() * sizeof(uint64_t);
+    }
+    
+private:
+    static constexpr size_t pending_limit = 64;
+    
+    template <typename Visit>
+    void decode(Visit visit) const;
+    void fold();
+    
+    std::pmr::vector<uint8_t> encoded_;
+    std::pmr::vector<uint64_t> pending_;
+    uint32_t count_ = 0;
+    RatingPoint latest_;
+    uint16_t peak_ = 0;
+};
+
+// One player's games in one tournament.
+struct TournamentScore {
+    int games = 0;
+    // Points doubled, so draws stay whole.
+    int half_points = 0;
+    // Decided games against a rated opponent, which the performance
+    // rating is computed from.
+    int rated_games = 0;
+    int rated_half_points = 0;
+    int64_t opponent_elo_sum = 0;
+    
+    double points() const { return half_points / 2.0; }
+    int average_opponent() const {
+        return rated_games ? static_cast<int>((opponent_elo_sum + rated_games / 2) / rated_games) : 0;
+    }
+    // The rating whose Elo expectation against these opponents equals
+    // the score: average opponent plus 400 * log10(p / (1 - p)), within
+    // 800 points of it for a perfect or zero score. 0 without rated games.
+    int performance() const;
+    
+    void merge(const TournamentScore& other) {
+        games += other.games;
+        half_points += other.half_points;
+        rated_games += other.rated_games;
+        rated_half_points += other.rated_half_points;
+        opponent_elo_sum += other.opponent_elo_sum;
+    }
+};
+
+// Results of decided games between two rated players, bucketed by rating.
+struct EloHistogram {
+    struct Bucket {
+        int white_wins = 0;
+        int black_wins = 0;
+        int draws = 0;
+        
+        int games() const { return white_wins + black_wins + draws; }
+        // White's score, 0 to 1; 0 for an empty bucket.
+        double white_score() const {
+            return games() ? (white_wins + draws / 2.0) / games() : 0.0;
+        }
+    };
+    
+    static constexpr int bucket_width = 100;
+    // White's rating minus Black's: bucket i is centred on
+    // (i - 16) * 100, and the end buckets take everything beyond.
+    static constexpr size_t difference_buckets = 33;
+    // The mean of the two ratings: bucket i is [i * 100, i * 100 + 100),
+    // and the last takes everything above.
+    static constexpr size_t rating_buckets = 32;
+    
+    std::array<Bucket, difference_buckets> by_difference{};
+    std::array<Bucket, rating_buckets> by_rating{};
+    
+    static size_t difference_bucket(int white_elo, int black_elo);
+    static size_t rating_bucket(int white_elo, int black_elo);
+    static int difference_center(size_t bucket) {
+        return (static_cast<int>(bucket) - int(difference_buckets / 2)) * bucket_width;
+    }
+    
+    // `result` as GameResult: 1 white win, 2 black win, 3 draw.
+    void add(int white_elo, int black_elo, int result);
+    void merge(const EloHistogram& other);
+};
+
+} // namespace pgn
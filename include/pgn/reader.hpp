@@ -0,0 +1,44 @@
+#pragma once
+#include "parser.hpp"
+#include "query.hpp"
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace pgn {
+
+// Pull-style reader that yields one game at a time. Only a bounded window
+// of the input is resident: mapped pages behind the cursor are released and
+// the buffered fallback reuses a fixed-size block buffer, so memory does not
+// grow with the size of the file. gzip, bzip2 and zstd inputs are
+// recognized by their magic bytes and decompressed on a background thread.
+//
+//     pgn::GameReader reader("games.pgn");
+//     pgn::GameView game;
+//     while (reader.next(game)) { ... }
+class GameReader {
+public:
+    explicit GameReader(const std::string& filename,
+                        const ParserOptions& options = ParserOptions());
+    ~GameReader();
+    
+    GameReader(const GameReader&) = delete;
+    GameReader& operator=(const GameReader&) = delete;
+    
+    // Only games matching `query` are returned; the others are skipped
+    // after their tags have been read.
+    void set_query(const Query& query);
+    
+    // The view stays valid until the next call to next().
+    bool next(GameView& game);
+    bool next(Game& game);
+    
+    // Bytes of input consumed up to the end of the last returned game.
+    uint64_t bytes_read() const;
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> pimpl;
+};
+
+} // namespace pgn
@@ -0,0 +1,147 @@
+#pragma once
+#include "parser.hpp"
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace pgn {
+
+// Protocol spoken by StatsServer and StatsClient over a Unix-domain
+// stream socket. Integers are little-endian; strings are a uint16 length
+// followed by the bytes.
+//
+//     request:  uint32 length, uint8 op, arguments        [length bytes]
+//     response: uint32 length, uint8 status, fields       [length bytes]
+//
+// A client may send several requests before reading the responses, which
+// come back in order. Arguments and fields, by op:
+//
+//     summary          -> int32 total_games, unique_players,
+//                         unique_tournaments, white_wins, black_wins,
+//                         draws, unknown_results; uint64 generation
+//     player           string name -> int32 total_games, games_as_white,
+//                         games_as_black, wins, losses, draws,
+//                         unique_opponents
+//     tournament       string name -> int32 total_games, unique_players
+//     top_players      uint32 count -> uint32 n, n x (string, int32 games)
+//     top_tournaments  uint32 count -> as top_players
+//     head_to_head     string first, string second -> int32 games,
+//                         first_wins, second_wins, draws
+//     reload           -> uint64 generation
+//
+// Lookups of unknown names answer not_found with no fields.
+enum class StatsOp : uint8_t {
+    summary = 1, player, tournament, top_players, top_tournaments, head_to_head, reload
+};
+
+enum class StatsStatus : uint8_t { ok = 0, not_found, bad_request, failed };
+
+struct DatabaseSummary {
+    int32_t total_games = 0;
+    int32_t unique_players = 0;
+    int32_t unique_tournaments = 0;
+    int32_t white_wins = 0;
+    int32_t black_wins = 0;
+    int32_t draws = 0;
+    int32_t unknown_results = 0;
+    // Counts the loads served so far; changes when a reload swaps data in.
+    uint64_t generation = 0;
+};
+
+struct PlayerSummary {
+    std::string name;
+    int32_t total_games = 0;
+    int32_t games_as_white = 0;
+    int32_t games_as_black = 0;
+    int32_t wins = 0;
+    int32_t losses = 0;
+    int32_t draws = 0;
+    int32_t unique_opponents = 0;
+};
+
+struct TournamentSummary {
+    std::string name;
+    int32_t total_games = 0;
+    int32_t unique_players = 0;
+};
+
+struct RankedName {
+    std::string name;
+    int32_t games = 0;
+};
+
+// Games between two players, from the first player's side.
+struct HeadToHead {
+    int32_t games = 0;
+    int32_t first_wins = 0;
+    int32_t second_wins = 0;
+    int32_t draws = 0;
+};
+
+// Keeps the statistics of a set of PGN files in memory and answers
+// lookups from other processes. Each connection is served by a thread of
+// its own; lookups read an immutable snapshot of the data, so they never
+// wait for each other, and reload() builds a new snapshot beside the old
+// one and swaps it in, while requests already running finish on the old.
+//
+//     pgn::StatsServer server({"games.pgn"}, options);
+//     server.reload();
+//     server.start("/tmp/pgn.sock");
+//
+// Only available where Unix-domain sockets are (not on Windows); elsewhere
+// start() throws.
+class StatsServer {
+public:
+    explicit StatsServer(std::vector<std::string> filenames,
+                         const ParserOptions& options = ParserOptions());
+    ~StatsServer();
+    
+    StatsServer(const StatsServer&) = delete;
+    StatsServer& operator=(const StatsServer&) = delete;
+    
+    // Parses the files again and swaps the result in. On failure (after
+    // printing the error) the data already served stays in place.
+    bool reload();
+    uint64_t generation() const;
+    
+    // Listens on `socket_path`, replacing a socket file left behind by an
+    // earlier server, and serves on background threads until stop() or
+    // destruction. Throws std::runtime_error if the socket cannot be set up.
+    void start(const std::string& socket_path);
+    void stop();
+    
+private:
+    struct Impl;
+    std::unique_ptr<Impl> pimpl;
+};
+
+// One connection to a StatsServer. Not thread-safe: give each thread a
+// client of its own. Calls throw std::runtime_error if the connection
+// fails or the server reports an error.
+class StatsClient {
+public:
+    explicit StatsClient(const std::string& socket_path);
+    ~StatsClient();
+    
+    StatsClient(const StatsClient&) = delete;
+    StatsClient& operator=(const StatsClient&) = delete;
+    
+    DatabaseSummary summary();
+    std::optional<PlayerSummary> player(std::string_view name);
+    std::optional<TournamentSummary> tournament(std::string_view name);
+    // Most games first; ties go to the alphabetically first name.
+    std::vector<RankedName> top_players(uint32_t count);
+    std::vector<RankedName> top_tournaments(uint32_t count);
+    HeadToHead head_to_head(std::string_view first, std::string_view second);
+    // Has the server reload its files; returns the new generation.
+    uint64_t reload();
+    
+private:
+    struct Impl;
+    std::unique_ptr<Impl> pimpl;
+};
+
+} // namespace pgn
@@ -0,0 +1,23 @@
+#pragma once
+
+namespace pgn {
+
+// Instruction set used by the PGN byte scanner. The best level the CPU
+// supports is picked at startup; it can be lowered for benchmarking or to
+// rule out a kernel when debugging.
+enum class SimdLevel {
+    scalar,
+    sse2,
+    avx2,
+};
+
+SimdLevel detected_simd_level();
+SimdLevel active_simd_level();
+
+// Selects `level`, clamped to what the CPU supports. Returns the level
+// actually in effect. Not safe to call while other threads are parsing.
+SimdLevel set_simd_level(SimdLevel level);
+
+const char* simd_level_name(SimdLevel level);
+
+} // namespace pgn
@@ -0,0 +1,165 @@
+#pragma once
+#include "game_table.hpp"
+#include "types.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace pgn {
+
+// 64-bit hash of a name, stable across runs and platforms, so sketches
+// built by different processes can be merged.
+uint64_t hash_name(std::string_view name);
+
+// Distinct-count estimator with 2^precision one-byte registers. The
+// relative standard error is 1.04 / sqrt(2^precision): 0.81% at the
+// default precision of 14 (16 KB); small counts are corrected by linear
+// counting and are close to exact. Merging takes the register-wise
+// maximum, so the estimate for merged sketches equals the estimate for
+// one sketch over both inputs.
+class HyperLogLog {
+public:
+    explicit HyperLogLog(int precision = 14);
+    
+    void add(uint64_t hash);
+    // Both sketches must have the same precision.
+    void merge(const HyperLogLog& other);
+    double estimate() const;
+    void clear();
+    
+    size_t memory_usage() const { return registers_.size(); }
+    
+private:
+    int precision_;
+    std::vector<uint8_t> registers_;
+};
+
+// Frequency estimator: `depth` rows of `width` counters. Estimates never
+// undercount; with N total additions an estimate exceeds the true count
+// by more than e * N / width with probability at most exp(-depth). The
+// defaults (32768 x 4, 512 KB) give 0.0083% of N with 98% confidence.
+// Merging adds the counters.
+class CountMinSketch {
+public:
+    explicit CountMinSketch(size_t width = 32768, size_t depth = 4);
+    
+    void add(uint64_t hash, uint32_t count = 1);
+    uint32_t estimate(uint64_t hash) const;
+    // Both sketches must have the same dimensions.
+    void merge(const CountMinSketch& other);
+    void clear();
+    
+    uint64_t total() const { return total_; }
+    size_t memory_usage() const { return counters_.size() * sizeof(uint32_t); }
+    
+private:
+    size_t width_;
+    size_t depth_;
+    uint64_t total_ = 0;
+    std::vector<uint32_t> counters_;
+};
+
+// Space-Saving heavy hitters over `capacity` counters. Every item seen more
+// than N / capacity times is kept; each kept item's count overestimates
+// its true count by at most its `error`, which is at most N / capacity.
+// Summaries merge by adding counts, charging an item missing from a full
+// summary that summary's smallest count, and keeping the largest
+// `capacity` results; the bounds hold for the combined input.
+class SpaceSaving {
+public:
+    struct Item {
+        std::string name;
+        uint64_t count = 0;
+        uint64_t error = 0;
+    };
+    
+    explicit SpaceSaving(size_t capacity = 4096);
+    
+    void add(std::string_view name, uint64_t hash, uint64_t count = 1);
+    void merge(const SpaceSaving& other);
+    void clear();
+    
+    // Up to `count` items, most frequent first; ties go to the
+    // alphabetically first name.
+    std::vector<Item> top(size_t count) const;
+    
+    uint64_t total() const { return total_; }
+    size_t size() const { return entries_.size(); }
+    size_t memory_usage() const;
+    
+private:
+    struct Entry {
+        uint64_t hash;
+        Item item;
+    };
+    
+    uint64_t min_count() const;
+    void sift_down(size_t position);
+    void sift_up(size_t position);
+    void swap_heap(size_t a, size_t b);
+    size_t find(uint64_t hash) const;
+    void insert_slot(uint64_t hash, uint32_t entry);
+    void erase_slot(uint64_t hash);
+    
+    size_t capacity_;
+    uint64_t total_ = 0;
+    std::vector<Entry> entries_;
+    // Min-heap of entry indices by count, and each entry's heap position.
+    std::vector<uint32_t> heap_;
+    std::vector<uint32_t> heap_position_;
+    // Open-addressing index from hash to entry + 1; 0 marks a free slot.
+    std::vector<uint32_t> slots_;
+};
+
+// Headline statistics in fixed memory (under 2 MB), for inputs whose
+// player and tournament tables would not fit. Game and result counts are
+// exact; distinct players and tournaments come from HyperLogLog, and the
+// most active players and largest tournaments from Space-Saving, with
+// their counts tightened by a Count-Min sketch. Partial statistics built
+// from different threads or files merge into the statistics of the
+// combined input, within the same bounds.
+class ApproximateStats {
+public:
+    ApproximateStats();
+    
+    void add(const GameView& game);
+    void add(std::string_view event, std::string_view white, std::string_view black,
+             GameResult result);
+    void merge(const ApproximateStats& other);
+    void clear();
+    
+    uint64_t total_games() const { return games_; }
+    double estimated_players() const { return players_.estimate(); }
+    double estimated_tournaments() const { return tournaments_.estimate(); }
+    
+    // Most games first. Counts are upper bounds; see SpaceSaving.
+    std::vector<SpaceSaving::Item> top_players(size_t count) const;
+    std::vector<SpaceSaving::Item> top_tournaments(size_t count) const;
+    // Upper bounds on one name's games; see CountMinSketch.
+    uint64_t player_games(std::string_view name) const;
+    uint64_t tournament_games(std::string_view name) const;
+    
+    // Sets the headline fields of `stats`: totals, result counts, unique
+    // counts, the most active player and the largest tournament. The
+    // per-player and per-tournament tables and name lists are cleared.
+    void fill(DatabaseStats& stats) const;
+    
+    size_t memory_usage() const;
+    
+private:
+    std::vector<SpaceSaving::Item> tightened(const SpaceSaving& top, const CountMinSketch& counts,
+                                             size_t count) const;
+    
+    uint64_t games_ = 0;
+    uint64_t results_[4] = {};
+    HyperLogLog players_;
+    HyperLogLog tournaments_;
+    CountMinSketch player_counts_;
+    CountMinSketch tournament_counts_;
+    SpaceSaving top_players_;
+    SpaceSaving top_tournaments_;
+};
+
+} // namespace pgn
@@ -0,0 +1,82 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iosfwd>
+#include <memory>
+#include <optional>
+#include <string_view>
+
+namespace pgn {
+
+// Interned string handle. Equal symbols always have equal ids, so
+// comparisons and hashing never touch the characters; str() resolves the
+// text through the global SymbolTable. The default symbol is "".
+class Symbol {
+public:
+    constexpr Symbol() = default;
+    constexpr explicit Symbol(uint32_t id) : id_(id) {}
+    
+    constexpr uint32_t id() const { return id_; }
+    constexpr bool empty() const { return id_ == 0; }
+    
+    std::string_view str() const;
+    operator std::string_view() const { return str(); }
+    
+    friend constexpr bool operator==(Symbol a, Symbol b) { return a.id_ == b.id_; }
+    friend constexpr bool operator!=(Symbol a, Symbol b) { return a.id_ != b.id_; }
+    friend bool operator<(Symbol a, Symbol b) { return a.str() < b.str(); }
+    
+private:
+    uint32_t id_ = 0;
+};
+
+std::ostream& operator<<(std::ostream& os, Symbol symbol);
+
+// Process-wide pool of interned strings. Interning is thread-safe and
+// sharded by hash so parallel parsers rarely contend; resolving a symbol
+// is a lock-free array lookup. Strings are never released.
+class SymbolTable {
+public:
+    static SymbolTable& global();
+    
+    SymbolTable();
+    ~SymbolTable();
+    
+    SymbolTable(const SymbolTable&) = delete;
+    SymbolTable& operator=(const SymbolTable&) = delete;
+    
+    Symbol intern(std::string_view text);
+    std::optional<Symbol> find(std::string_view text) const;
+    std::string_view str(Symbol symbol) const;
+    
+    // Number of distinct strings, including "".
+    size_t size() const;
+    // Approximate bytes held by the pool: characters, index and id table.
+    size_t memory_usage() const;
+    // Strings per bucket of the index, over all shards.
+    double load_factor() const;
+    
+private:
+    struct Impl;
+    std::unique_ptr<Impl> pimpl;
+};
+
+inline Symbol intern(std::string_view text) {
+    return SymbolTable::global().intern(text);
+}
+
+inline std::string_view Symbol::str() const {
+    return SymbolTable::global().str(*this);
+}
+
+} // namespace pgn
+
+namespace std {
+
+template <>
+struct hash<pgn::Symbol> {
+    size_t operator()(pgn::Symbol symbol) const noexcept { return symbol.id(); }
+};
+
+} // namespace std
@@ -1,33 +1,81 @@
 #pragma once
+#include "id_set.hpp"
+#include "ratings.hpp"
+#include "symbol_table.hpp"
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <vector>
+#include <memory_resource>
 #include <unordered_map>
 #include <chrono>
 
 namespace pgn {
 
+using SymbolSet = IdSet<Symbol>;
+
+// Names (event, site, players, ECO code and opening) are interned in the
+// global SymbolTable; print them directly or call str() for the text.
 struct Game {
-    std::string event;
-    std::string site;
+    Symbol event;
+    Symbol site;
     std::string date;
     std::string round;
-    std::string white;
-    std::string black;
+    Symbol white;
+    Symbol black;
     std::string result;
     std::string white_elo;
     std::string black_elo;
-    std::string eco;
-    std::string opening;
+    Symbol eco;
+    Symbol opening;
+    int move_count = 0;
+    
+    bool is_white_win() const { return result == "1-0"; }
+    bool is_black_win() const { return result == "0-1"; }
+    bool is_draw() const { return result == "1/2-1/2"; }
+    bool is_unknown_result() const { return result == "*"; }
+};
+
+// Non-owning view of a game; the slices point into the parser's input
+// buffer and stay valid until the next load.
+struct GameView {
+    std::string_view event;
+    std::string_view site;
+    std::string_view date;
+    std::string_view round;
+    std::string_view white;
+    std::string_view black;
+    std::string_view result;
+    std::string_view white_elo;
+    std::string_view black_elo;
+    std::string_view eco;
+    std::string_view opening;
+    // Starting position from a FEN tag; empty for the standard start.
+    std::string_view fen;
+    // Everything after the tag section, up to the next game. Empty for
+    // games read from a .pgnidx sidecar.
+    std::string_view movetext;
     int move_count = 0;
+    // Byte offset of the game's first tag line in the input file.
+    uint64_t offset = 0;
+    // Cleared by ParserOptions::replay_moves when a move cannot be played.
+    bool moves_valid = true;
     
     bool is_white_win() const { return result == "1-0"; }
     bool is_black_win() const { return result == "0-1"; }
     bool is_draw() const { return result == "1/2-1/2"; }
     bool is_unknown_result() const { return result == "*"; }
+    
+    Game to_game() const {
+        return Game{intern(event), intern(site), std::string(date),
+                    std::string(round), intern(white), intern(black),
+                    std::string(result), std::string(white_elo), std::string(black_elo),
+                    intern(eco), intern(opening), move_count};
+    }
 };
 
 struct PlayerStats {
-    std::string name;
+    Symbol name;
     int total_games = 0;
     int games_as_white = 0;
     int games_as_black = 0;
@@ -36,8 +84,15 @@ struct PlayerStats {
     int draws = 0;
     double win_percentage = 0.0;
     double draw_percentage = 0.0;
-    std::vector<std::string> opponents;
-    std::unordered_map<std::string, int> opening_frequency;
+    // Distinct opponents in the order they were first met.
+    SymbolSet opponents;
+    std::pmr::unordered_map<Symbol, int> opening_frequency;
+    // With ParserOptions::rating_stats.
+    RatingHistory ratings;
+    
+    PlayerStats() = default;
+    explicit PlayerStats(std::pmr::memory_resource* resource)
+        : opponents(resource), opening_frequency(resource), ratings(resource) {}
     
     void calculate_percentages() {
         if (total_games > 0) {
@@ -48,11 +103,18 @@ struct PlayerStats {
 };
 
 struct Tournament {
-    std::string name;
+    Symbol name;
     int total_games = 0;
     int unique_players = 0;
-    std::vector<std::string> players;
-    std::unordered_map<std::string, int> player_game_count;
+    // Distinct players in order of first appearance.
+    SymbolSet players;
+    std::pmr::unordered_map<Symbol, int> player_game_count;
+    // Each player's score and performance; with ParserOptions::rating_stats.
+    std::pmr::unordered_map<Symbol, TournamentScore> scores;
+    
+    Tournament() = default;
+    explicit Tournament(std::pmr::memory_resource* resource)
+        : players(resource), player_game_count(resource), scores(resource) {}
 };
 
 struct DatabaseStats {
@@ -63,15 +125,47 @@ struct DatabaseStats {
     int black_wins = 0;
     int draws = 0;
     int unknown_results = 0;
-    std::string most_active_player;
+    Symbol most_active_player;
     int max_games_by_player = 0;
-    std::string largest_tournament;
+    Symbol largest_tournament;
     int max_games_in_tournament = 0;
     double parsing_time_seconds = 0.0;
-    std::vector<std::string> tournament_names;
-    std::vector<std::string> player_names;
-    std::unordered_map<std::string, PlayerStats> player_stats;
-    std::unordered_map<std::string, Tournament> tournaments;
+    // Time load_file() spent aggregating; 0 for streamed analysis, where
+    // parsing and aggregation are interleaved.
+    double analysis_time_seconds = 0.0;
+    // Games whose movetext did not replay; counted only with
+    // ParserOptions::replay_moves.
+    int invalid_move_games = 0;
+    // Games dropped as repeats of earlier ones; counted only with
+    // ParserOptions::deduplicate, and not part of total_games.
+    int duplicate_games = 0;
+    // With ParserOptions::rating_stats.
+    EloHistogram elo_histogram;
+    std::vector<Symbol> tournament_names;
+    std::vector<Symbol> player_names;
+    // A Parser allocates the entries, and everything inside them, from an
+    // arena that it releases in one go. Copies use the default heap.
+    std::pmr::unordered_map<Symbol, PlayerStats> player_stats;
+    std::pmr::unordered_map<Symbol, Tournament> tournaments;
+    
+    DatabaseStats() = default;
+    explicit DatabaseStats(std::pmr::memory_resource* resource)
+        : player_stats(resource), tournaments(resource) {}
+    
+    // Lookups by name; nullptr when the name never occurred.
+    const PlayerStats* find_player(std::string_view name) const {
+        auto symbol = SymbolTable::global().find(name);
+        if (!symbol) return nullptr;
+        auto it = player_stats.find(*symbol);
+        return it != player_stats.end() ? &it->second : nullptr;
+    }
+    
+    const Tournament* find_tournament(std::string_view name) const {
+        auto symbol = SymbolTable::global().find(name);
+        if (!symbol) return nullptr;
+        auto it = tournaments.find(*symbol);
+        return it != tournaments.end() ? &it->second : nullptr;
+    }
 };
 
 } // namespace pgn
\ No newline at end of file
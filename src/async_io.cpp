@@ -0,0 +1,520 @@
+#include "async_io.hpp"
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+#ifdef _WIN32
+#include <fstream>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#if defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter)
+#define PGN_HAVE_IO_URING 1
+#endif
+#endif
+
+namespace pgn {
+
+namespace {
+
+#ifdef PGN_HAVE_IO_URING
+
+// The submission and completion rings of one io_uring, driven from a
+// single thread. Only reads are issued.
+class Uring {
+public:
+    Uring() = default;
+    Uring(const Uring&) = delete;
+    Uring& operator=(const Uring&) = delete;
+    
+    ~Uring() {
+        if (sqes_) munmap(sqes_, sqes_size_);
+        if (cq_ && cq_ != sq_) munmap(cq_, cq_size_);
+        if (sq_) munmap(sq_, sq_size_);
+        if (fd_ >= 0) close(fd_);
+    }
+    
+    // False if the kernel does not offer io_uring or refuses it (seccomp,
+    // sysctl, memory limits); the caller then reads with pread().
+    bool setup(unsigned entries) {
+        io_uring_params params;
+        std::memset(&params, 0, sizeof(params));
+        int fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+        if (fd < 0) return false;
+        fd_ = fd;
+        
+        sq_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cq_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+        if (single_mmap) sq_size_ = cq_size_ = std::max(sq_size_, cq_size_);
+        
+        sq_ = map(sq_size_, IORING_OFF_SQ_RING);
+        if (!sq_) return false;
+        cq_ = single_mmap ? sq_ : map(cq_size_, IORING_OFF_CQ_RING);
+        if (!cq_) return false;
+        sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+        sqes_ = static_cast<io_uring_sqe*>(map(sqes_size_, IORING_OFF_SQES));
+        if (!sqes_) return false;
+        
+        char* sq = static_cast<char*>(sq_);
+        char* cq = static_cast<char*>(cq_);
+        sq_head_ = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+        sq_tail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        sq_mask_ = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        sq_array_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+        cq_head_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        cq_tail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        cq_mask_ = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        cqes_ = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+        return true;
+    }
+    
+    // Queues a read and hands it to the kernel. False if the kernel would
+    // not take it, in which case the entry is withdrawn again: left queued,
+    // the next enter() would submit it into a buffer the caller has since
+    // filled some other way.
+    bool read(int file, char* into, unsigned size, uint64_t offset, uint64_t user_data) {
+        unsigned tail = *sq_tail_;
+        unsigned index = tail & sq_mask_;
+        io_uring_sqe& sqe = sqes_[index];
+        std::memset(&sqe, 0, sizeof(sqe));
+        sqe.opcode = IORING_OP_READ;
+        sqe.fd = file;
+        sqe.addr = reinterpret_cast<uint64_t>(into);
+        sqe.len = size;
+        sqe.off = offset;
+        sqe.user_data = user_data;
+        sq_array_[index] = index;
+        __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+        
+        int submitted = -1;
+        if (refused_ > 0) {
+            refused_--;
+        } else {
+            submitted = enter(1, 0);
+        }
+        if (submitted == 1) return true;
+        // Entries are consumed only inside enter(); one that was consumed
+        // despite the error posts a completion like any other.
+        if (__atomic_load_n(sq_head_, __ATOMIC_ACQUIRE) != tail) return true;
+        __atomic_store_n(sq_tail_, tail, __ATOMIC_RELEASE);
+        return false;
+    }
+    
+    // For tests: the next `count` reads are queued and then refused, as
+    // when io_uring_enter() fails with EAGAIN.
+    void refuse(unsigned count) { refused_ = count; }
+    
+    // Waits for the next completion. False if waiting failed.
+    bool complete(uint64_t& user_data, int& result) {
+        for (;;) {
+            unsigned head = *cq_head_;
+            if (head != __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE)) {
+                const io_uring_cqe& cqe = cqes_[head & cq_mask_];
+                user_data = cqe.user_data;
+                result = cqe.res;
+                __atomic_store_n(cq_head_, head + 1, __ATOMIC_RELEASE);
+                return true;
+            }
+            if (enter(0, 1) < 0) return false;
+        }
+    }
+    
+private:
+    void* map(size_t size, off_t offset) {
+        void* memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_, offset);
+        return memory == MAP_FAILED ? nullptr : memory;
+    }
+    
+    int enter(unsigned submit, unsigned wait_for) {
+        for (;;) {
+            long result = syscall(__NR_io_uring_enter, fd_, submit, wait_for,
+                                  wait_for ? IORING_ENTER_GETEVENTS : 0, nullptr, 0);
+            if (result < 0 && errno == EINTR) continue;
+            return static_cast<int>(result);
+        }
+    }
+    
+    int fd_ = -1;
+    void* sq_ = nullptr;
+    void* cq_ = nullptr;
+    io_uring_sqe* sqes_ = nullptr;
+    size_t sq_size_ = 0;
+    size_t cq_size_ = 0;
+    size_t sqes_size_ = 0;
+    unsigned* sq_head_ = nullptr;
+    unsigned* sq_tail_ = nullptr;
+    unsigned sq_mask_ = 0;
+    unsigned* sq_array_ = nullptr;
+    unsigned* cq_head_ = nullptr;
+    unsigned* cq_tail_ = nullptr;
+    unsigned cq_mask_ = 0;
+    io_uring_cqe* cqes_ = nullptr;
+    unsigned refused_ = 0;
+};
+
+#endif
+
+// One read per call is capped, so its length fits the kernel's types; the
+// rest of a larger request is read as a continuation.
+constexpr size_t max_read_size = 1 << 30;
+
+} // namespace
+
+struct AsyncFile::Impl {
+    struct Request {
+        char* into = nullptr;
+        size_t size = 0;
+        uint64_t offset = 0;
+        uint64_t tag = 0;
+        size_t done = 0;
+        bool active = false;
+    };
+    
+    std::string filename;
+    uint64_t size = 0;
+    std::vector<Request> requests;
+    // Reads done by pread(), waiting to be handed out by wait().
+    std::deque<Completion> finished;
+    size_t in_flight = 0;
+#ifdef _WIN32
+    std::ifstream stream;
+#else
+    int fd = -1;
+#endif
+#ifdef PGN_HAVE_IO_URING
+    Uring ring;
+    bool use_ring = false;
+    // Reads the kernel still holds a buffer for.
+    size_t ring_reads = 0;
+#endif
+
+    size_t read_sync(char* into, size_t count, uint64_t offset);
+    bool read_async(size_t slot);
+};
+
+size_t AsyncFile::Impl::read_sync(char* into, size_t count, uint64_t offset) {
+#ifdef _WIN32
+    stream.clear();
+    stream.seekg(static_cast<std::streamoff>(offset));
+    stream.read(into, static_cast<std::streamsize>(count));
+    if (stream.bad()) throw std::runtime_error("Cannot read file: " + filename);
+    return static_cast<size_t>(stream.gcount());
+#else
+    size_t done = 0;
+    while (done < count) {
+        size_t chunk = std::min(count - done, max_read_size);
+        ssize_t result = ::pread(fd, into + done, chunk, static_cast<off_t>(offset + done));
+        if (result < 0 && errno == EINTR) continue;
+        if (result < 0) throw std::runtime_error("Cannot read file: " + filename);
+        if (result == 0) break;
+        done += static_cast<size_t>(result);
+    }
+    return done;
+#endif
+}
+
+// Hands the rest of request `slot` to the ring; false if it could not.
+bool AsyncFile::Impl::read_async(size_t slot) {
+#ifdef PGN_HAVE_IO_URING
+    Request& request = requests[slot];
+    size_t chunk = std::min(request.size - request.done, max_read_size);
+    if (!ring.read(fd, request.into + request.done, static_cast<unsigned>(chunk),
+                   request.offset + request.done, slot)) {
+        return false;
+    }
+    ring_reads++;
+    return true;
+#else
+    (void)slot;
+    return false;
+#endif
+}
+
+AsyncFile::AsyncFile(const std::string& filename, unsigned queue_depth, bool use_io_uring)
+    : pimpl(std::make_unique<Impl>()) {
+    pimpl->filename = filename;
+    pimpl->requests.resize(std::max(1u, queue_depth));
+#ifdef _WIN32
+    (void)use_io_uring;
+    pimpl->stream.open(filename, std::ios::binary | std::ios::ate);
+    if (!pimpl->stream.is_open()) throw std::runtime_error("Cannot open file: " + filename);
+    pimpl->size = static_cast<uint64_t>(pimpl->stream.tellg());
+#else
+    pimpl->fd = ::open(filename.c_str(), O_RDONLY);
+    struct stat info;
+    if (pimpl->fd < 0 || fstat(pimpl->fd, &info) != 0) {
+        if (pimpl->fd >= 0) ::close(pimpl->fd);
+        throw std::runtime_error("Cannot open file: " + filename);
+    }
+    pimpl->size = static_cast<uint64_t>(info.st_size);
+    posix_fadvise(pimpl->fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#ifdef PGN_HAVE_IO_URING
+    pimpl->use_ring = use_io_uring && pimpl->ring.setup(static_cast<unsigned>(pimpl->requests.size()));
+#else
+    (void)use_io_uring;
+#endif
+#endif
+}
+
+AsyncFile::~AsyncFile() {
+#ifdef PGN_HAVE_IO_URING
+    // The kernel may still write into the callers' buffers; let it finish.
+    uint64_t slot;
+    int result;
+    while (pimpl->ring_reads > 0 && pimpl->ring.complete(slot, result)) pimpl->ring_reads--;
+#endif
+#ifndef _WIN32
+    ::close(pimpl->fd);
+#endif
+}
+
+uint64_t AsyncFile::size() const {
+    return pimpl->size;
+}
+
+bool AsyncFile::uses_io_uring() const {
+#ifdef PGN_HAVE_IO_URING
+    return pimpl->use_ring;
+#else
+    return false;
+#endif
+}
+
+size_t AsyncFile::in_flight() const {
+    return pimpl->in_flight;
+}
+
+void AsyncFile::refuse_ring_reads(unsigned count) {
+#ifdef PGN_HAVE_IO_URING
+    pimpl->ring.refuse(count);
+#else
+    (void)count;
+#endif
+}
+
+void AsyncFile::submit(char* into, size_t size, uint64_t offset, uint64_t tag) {
+    auto free_slot = std::find_if(pimpl->requests.begin(), pimpl->requests.end(),
+                                  [](const Impl::Request& request) { return !request.active; });
+    if (free_slot == pimpl->requests.end()) {
+        throw std::logic_error("AsyncFile: too many reads in flight");
+    }
+    size = offset < pimpl->size ? static_cast<size_t>(std::min<uint64_t>(size, pimpl->size - offset)) : 0;
+    *free_slot = Impl::Request{into, size, offset, tag, 0, true};
+    pimpl->in_flight++;
+
+#ifdef PGN_HAVE_IO_URING
+    size_t slot = static_cast<size_t>(free_slot - pimpl->requests.begin());
+    if (pimpl->use_ring && size > 0 && pimpl->read_async(slot)) return;
+#endif
+    free_slot->active = false;
+    pimpl->finished.push_back({tag, pimpl->read_sync(into, size, offset)});
+}
+
+AsyncFile::Completion AsyncFile::wait() {
+    if (pimpl->in_flight == 0) throw std::logic_error("AsyncFile: no read in flight");
+    if (!pimpl->finished.empty()) {
+        Completion completion = pimpl->finished.front();
+        pimpl->finished.pop_front();
+        pimpl->in_flight--;
+        return completion;
+    }
+
+#ifdef PGN_HAVE_IO_URING
+    for (;;) {
+        uint64_t slot;
+        int result;
+        if (!pimpl->ring.complete(slot, result)) {
+            throw std::runtime_error("Cannot read file: " + pimpl->filename);
+        }
+        pimpl->ring_reads--;
+        if (slot >= pimpl->requests.size() || !pimpl->requests[slot].active) {
+            throw std::logic_error("AsyncFile: completion for a read not in flight");
+        }
+        Impl::Request& request = pimpl->requests[slot];
+        
+        if (result == -EINTR || result == -EAGAIN) {
+            if (pimpl->read_async(slot)) continue;
+            result = -EINVAL;
+        }
+        if (result == -EINVAL || result == -EOPNOTSUPP) {
+            // A kernel without IORING_OP_READ: read this and all later
+            // requests with pread().
+            pimpl->use_ring = false;
+            request.done += pimpl->read_sync(request.into + request.done, request.size - request.done,
+                                             request.offset + request.done);
+        } else if (result < 0) {
+            throw std::runtime_error("Cannot read file: " + pimpl->filename);
+        } else {
+            request.done += static_cast<size_t>(result);
+            // A short read before the end: ask for the rest.
+            if (result > 0 && request.done < request.size && pimpl->read_async(slot)) continue;
+            if (result > 0 && request.done < request.size) {
+                request.done += pimpl->read_sync(request.into + request.done, request.size - request.done,
+                                                 request.offset + request.done);
+            }
+        }
+        
+        request.active = false;
+        pimpl->in_flight--;
+        return {request.tag, request.done};
+    }
+#else
+    throw std::logic_error("AsyncFile: no read in flight");
+#endif
+}
+
+void read_file(const std::string& filename, std::string& into, bool use_io_uring,
+               size_t block_size, unsigned queue_depth) {
+    AsyncFile file(filename, queue_depth, use_io_uring);
+    into.resize(static_cast<size_t>(file.size()));
+    
+    // Reads are tagged with their offset. A file that shrank while being
+    // read ends at the first short read.
+    size_t next = 0;
+    size_t end = into.size();
+    auto submit_next = [&] {
+        file.submit(&into[0] + next, std::min(block_size, into.size() - next), next, next);
+        next += std::min(block_size, into.size() - next);
+    };
+    while (next < into.size() && file.in_flight() < queue_depth) submit_next();
+    while (file.in_flight() > 0) {
+        AsyncFile::Completion completion = file.wait();
+        if (completion.tag + completion.bytes < std::min<size_t>(completion.tag + block_size, into.size())) {
+            end = std::min<size_t>(end, completion.tag + completion.bytes);
+        }
+        if (next < end) submit_next();
+    }
+    into.resize(end);
+}
+
+struct ReadAhead::Impl {
+    enum class State : uint8_t { idle, reading, ready };
+    
+    // Declared before `file`, so that outstanding reads are drained before
+    // the buffers are freed.
+    std::unique_ptr<char[]> memory;
+    std::vector<char*> data;
+    std::vector<uint64_t> offsets;
+    std::vector<size_t> sizes;
+    std::vector<State> states;
+    size_t block_size;
+    size_t headroom;
+    AsyncFile file;
+    
+    uint64_t next_offset = 0;
+    // The buffer whose block was returned last, or -1 before the first.
+    int current = -1;
+    uint64_t text_offset = 0;
+    bool finished = false;
+    std::string joined;
+    
+    Impl(const std::string& filename, bool use_io_uring, size_t block, unsigned buffers)
+        : block_size(block), headroom(std::min<size_t>(block, 1 << 20)),
+          file(filename, buffers, use_io_uring) {}
+    
+    void start(size_t buffer);
+};
+
+void ReadAhead::Impl::start(size_t buffer) {
+    if (next_offset >= file.size()) {
+        states[buffer] = State::idle;
+        return;
+    }
+    offsets[buffer] = next_offset;
+    states[buffer] = State::reading;
+    file.submit(data[buffer], block_size, next_offset, buffer);
+    next_offset += block_size;
+}
+
+ReadAhead::ReadAhead(const std::string& filename, bool use_io_uring, size_t block_size,
+                     unsigned buffers) {
+    constexpr size_t page = 4096;
+    block_size = (std::max(block_size, page) + page - 1) / page * page;
+    buffers = std::max(2u, buffers);
+    pimpl = std::make_unique<Impl>(filename, use_io_uring, block_size, buffers);
+    
+    // One allocation, page-aligned, holding every buffer's headroom and data.
+    size_t stride = pimpl->headroom + block_size;
+    pimpl->memory.reset(new char[stride * buffers + page]);
+    uintptr_t base = reinterpret_cast<uintptr_t>(pimpl->memory.get());
+    char* aligned = pimpl->memory.get() + ((page - base % page) % page);
+    for (unsigned i = 0; i < buffers; ++i) pimpl->data.push_back(aligned + i * stride + pimpl->headroom);
+    pimpl->offsets.assign(buffers, 0);
+    pimpl->sizes.assign(buffers, 0);
+    pimpl->states.assign(buffers, Impl::State::idle);
+    for (unsigned i = 0; i < buffers; ++i) pimpl->start(i);
+}
+
+ReadAhead::~ReadAhead() = default;
+
+bool ReadAhead::next(std::string_view carry, std::string_view& text) {
+    Impl& r = *pimpl;
+    size_t buffers = r.data.size();
+    uint64_t carry_end = r.current < 0 ? 0 : r.offsets[r.current] + r.sizes[r.current];
+    size_t next = r.current < 0 ? 0 : (static_cast<size_t>(r.current) + 1) % buffers;
+    if (r.states[next] == Impl::State::idle) {
+        r.finished = true;
+        r.text_offset = carry_end - carry.size();
+        text = carry;
+        return false;
+    }
+    
+    while (r.states[next] != Impl::State::ready) {
+        AsyncFile::Completion completion = r.file.wait();
+        r.sizes[completion.tag] = completion.bytes;
+        r.states[completion.tag] = Impl::State::ready;
+    }
+    
+    char* block = r.data[next];
+    size_t size = r.sizes[next];
+    if (carry.size() <= r.headroom) {
+        if (!carry.empty()) std::memcpy(block - carry.size(), carry.data(), carry.size());
+        text = std::string_view(block - carry.size(), carry.size() + size);
+    } else {
+        std::string joined;
+        joined.reserve(carry.size() + size);
+        joined.append(carry);
+        joined.append(block, size);
+        r.joined.swap(joined);
+        text = r.joined;
+    }
+    r.text_offset = r.offsets[next] - carry.size();
+    // A short block means the file ended early.
+    r.finished = r.offsets[next] + size >= r.file.size() || size < r.block_size;
+    
+    // The previous block has been copied from; read ahead into it.
+    if (r.current >= 0) r.start(static_cast<size_t>(r.current));
+    r.current = static_cast<int>(next);
+    if (r.finished) {
+        for (auto& state : r.states) {
+            if (state == Impl::State::reading) state = Impl::State::idle;
+        }
+    }
+    return true;
+}
+
+uint64_t ReadAhead::offset() const {
+    return pimpl->text_offset;
+}
+
+bool ReadAhead::finished() const {
+    return pimpl->finished;
+}
+
+bool ReadAhead::uses_io_uring() const {
+    return pimpl->file.uses_io_uring();
+}
+
+} // namespace pgn
@@ -0,0 +1,85 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace pgn {
+
+// Reads of a regular file that proceed while the caller works. On Linux
+// they go through an io_uring set up with raw system calls, when the
+// kernel allows it and `use_io_uring` is set; otherwise submit() does a
+// blocking pread() and wait() hands back the result. Throws
+// std::runtime_error("Cannot open file: ...") or ("Cannot read file: ...").
+class AsyncFile {
+public:
+    struct Completion {
+        uint64_t tag = 0;
+        // Less than requested only at the end of the file.
+        size_t bytes = 0;
+    };
+    
+    AsyncFile(const std::string& filename, unsigned queue_depth, bool use_io_uring = true);
+    ~AsyncFile();
+    
+    AsyncFile(const AsyncFile&) = delete;
+    AsyncFile& operator=(const AsyncFile&) = delete;
+    
+    // File size when opened.
+    uint64_t size() const;
+    bool uses_io_uring() const;
+    
+    // Starts reading `size` bytes at `offset` into `into`, which must stay
+    // alive until the read completes. At most queue_depth reads may be
+    // outstanding.
+    void submit(char* into, size_t size, uint64_t offset, uint64_t tag);
+    // Waits for one outstanding read, in whatever order they finish.
+    Completion wait();
+    size_t in_flight() const;
+    
+    // For tests: the ring refuses the next `count` reads offered to it, as
+    // a busy kernel would, so that they take the pread() fallback.
+    void refuse_ring_reads(unsigned count);
+    
+private:
+    struct Impl;
+    std::unique_ptr<Impl> pimpl;
+};
+
+// Reads all of `filename` into `into`, keeping `queue_depth` reads of
+// `block_size` bytes in flight.
+void read_file(const std::string& filename, std::string& into, bool use_io_uring = true,
+               size_t block_size = 4 << 20, unsigned queue_depth = 8);
+
+// Sequential read-ahead over a ring of page-aligned buffers: while the
+// caller parses one block, reads into all the others are in flight.
+//
+// Each buffer has headroom in front of its data, so the unparsed end of
+// one block (a game cut off by the block boundary) is copied in front of
+// the next and the two read as one contiguous text. Only that carry is
+// copied; a carry larger than the headroom is joined in a separate buffer.
+class ReadAhead {
+public:
+    ReadAhead(const std::string& filename, bool use_io_uring = true,
+              size_t block_size = 4 << 20, unsigned buffers = 4);
+    ~ReadAhead();
+    
+    // Sets `text` to `carry`, which may point into the previous block,
+    // followed by the next block. The previous block is reused once this
+    // returns. Returns false at the end of the file, with `text` just the
+    // carry.
+    bool next(std::string_view carry, std::string_view& text);
+    
+    // File offset of the last text returned.
+    uint64_t offset() const;
+    // True once the last block of the file has been returned.
+    bool finished() const;
+    bool uses_io_uring() const;
+    
+private:
+    struct Impl;
+    std::unique_ptr<Impl> pimpl;
+};
+
+} // namespace pgn
@@ -0,0 +1,186 @@
+#include "attacks.hpp"
+#include <vector>
+
+namespace pgn {
+namespace attacks {
+
+namespace {
+
+constexpr int bishop_directions[4][2] = {{1, 1}, {1, -1}, {-1, 1}, {-1, -1}};
+constexpr int rook_directions[4][2] = {{1, 0}, {-1, 0}, {0, 1}, {0, -1}};
+
+bool on_board(int file, int rank) {
+    return file >= 0 && file < 8 && rank >= 0 && rank < 8;
+}
+
+Bitboard bit(int file, int rank) {
+    return Bitboard(1) << (rank * 8 + file);
+}
+
+// Attacks along `directions` from `square`, each ray stopping at the
+// first occupied square.
+Bitboard slide(const int (&directions)[4][2], int square, Bitboard occupied) {
+    Bitboard result = 0;
+    for (const auto& d : directions) {
+        int file = square % 8 + d[0];
+        int rank = square / 8 + d[1];
+        while (on_board(file, rank)) {
+            result |= bit(file, rank);
+            if (occupied & bit(file, rank)) break;
+            file += d[0];
+            rank += d[1];
+        }
+    }
+    return result;
+}
+
+// Squares whose occupancy matters: the rays without their last square.
+Bitboard relevant_mask(const int (&directions)[4][2], int square) {
+    Bitboard result = 0;
+    for (const auto& d : directions) {
+        int file = square % 8 + d[0];
+        int rank = square / 8 + d[1];
+        while (on_board(file + d[0], rank + d[1])) {
+            result |= bit(file, rank);
+            file += d[0];
+            rank += d[1];
+        }
+    }
+    return result;
+}
+
+Bitboard step_attacks(int square, const int (*steps)[2], int count) {
+    Bitboard result = 0;
+    for (int i = 0; i < count; ++i) {
+        int file = square % 8 + steps[i][0];
+        int rank = square / 8 + steps[i][1];
+        if (on_board(file, rank)) result |= bit(file, rank);
+    }
+    return result;
+}
+
+// Fixed-seed generator, so magic search is deterministic.
+class Random {
+public:
+    Bitboard next() {
+        state_ ^= state_ >> 12;
+        state_ ^= state_ << 25;
+        state_ ^= state_ >> 27;
+        return state_ * 2685821657736338717ull;
+    }
+    
+    Bitboard sparse() { return next() & next() & next(); }
+    
+private:
+    uint64_t state_ = 1070372;
+};
+
+// Fills one piece's table for every square, appending to `storage`.
+void build_sliders(const int (&directions)[4][2], Magic (&magics)[64], std::vector<Bitboard>& storage,
+                   Random& random) {
+    std::vector<size_t> offsets(64);
+    std::vector<Bitboard> occupancies;
+    std::vector<Bitboard> references;
+    
+    for (int square = 0; square < 64; ++square) {
+        Magic& m = magics[square];
+        m.mask = relevant_mask(directions, square);
+        unsigned bits = static_cast<unsigned>(__builtin_popcountll(m.mask));
+        m.shift = 64 - bits;
+        
+        // Every subset of the mask, by the carry-rippler trick.
+        occupancies.clear();
+        references.clear();
+        Bitboard subset = 0;
+        do {
+            occupancies.push_back(subset);
+            references.push_back(slide(directions, square, subset));
+            subset = (subset - m.mask) & m.mask;
+        } while (subset);
+        
+        size_t size = size_t(1) << bits;
+        offsets[square] = storage.size();
+        storage.resize(storage.size() + size);
+        Bitboard* table = storage.data() + offsets[square];
+
+#ifdef __BMI2__
+        m.magic = 0;
+        for (size_t i = 0; i < occupancies.size(); ++i) {
+            table[_pext_u64(occupancies[i], m.mask)] = references[i];
+        }
+#else
+        std::vector<unsigned> epoch(size, 0);
+        for (unsigned attempt = 1;; ++attempt) {
+            m.magic = random.sparse();
+            if (__builtin_popcountll((m.mask * m.magic) >> 56) < 6) continue;
+            
+            bool ok = true;
+            for (size_t i = 0; i < occupancies.size() && ok; ++i) {
+                size_t index = static_cast<size_t>((occupancies[i] * m.magic) >> m.shift);
+                if (epoch[index] != attempt) {
+                    epoch[index] = attempt;
+                    table[index] = references[i];
+                } else if (table[index] != references[i]) {
+                    ok = false;
+                }
+            }
+            if (ok) break;
+        }
+#endif
+    }
+    (void)random;
+    
+    // Pointers are taken once storage has stopped growing.
+    for (int square = 0; square < 64; ++square) {
+        magics[square].table = storage.data() + offsets[square];
+    }
+}
+
+struct Storage {
+    Tables tables;
+    std::vector<Bitboard> bishop_attacks;
+    std::vector<Bitboard> rook_attacks;
+    
+    Storage() {
+        static const int knight_steps[8][2] = {{1, 2}, {2, 1}, {2, -1}, {1, -2},
+                                               {-1, -2}, {-2, -1}, {-2, 1}, {-1, 2}};
+        static const int king_steps[8][2] = {{1, 0}, {1, 1}, {0, 1}, {-1, 1},
+                                             {-1, 0}, {-1, -1}, {0, -1}, {1, -1}};
+        static const int white_pawn_steps[2][2] = {{-1, 1}, {1, 1}};
+        static const int black_pawn_steps[2][2] = {{-1, -1}, {1, -1}};
+        
+        for (int square = 0; square < 64; ++square) {
+            tables.knight[square] = step_attacks(square, knight_steps, 8);
+            tables.king[square] = step_attacks(square, king_steps, 8);
+            tables.pawn[0][square] = step_attacks(square, white_pawn_steps, 2);
+            tables.pawn[1][square] = step_attacks(square, black_pawn_steps, 2);
+        }
+        
+        Random random;
+        build_sliders(bishop_directions, tables.bishop, bishop_attacks, random);
+        build_sliders(rook_directions, tables.rook, rook_attacks, random);
+        
+        for (int from = 0; from < 64; ++from) {
+            for (int to = 0; to < 64; ++to) {
+                Bitboard target = Bitboard(1) << to;
+                Bitboard line = 0;
+                if (slide(bishop_directions, from, 0) & target) {
+                    line = slide(bishop_directions, from, target) & slide(bishop_directions, to, Bitboard(1) << from);
+                } else if (slide(rook_directions, from, 0) & target) {
+                    line = slide(rook_directions, from, target) & slide(rook_directions, to, Bitboard(1) << from);
+                }
+                tables.between[from][to] = line;
+            }
+        }
+    }
+};
+
+} // namespace
+
+const Tables& tables() {
+    static const Storage storage;
+    return storage.tables;
+}
+
+} // namespace attacks
+} // namespace pgn
@@ -0,0 +1,65 @@
+#pragma once
+#include "pgn/position.hpp"
+#include <cstdint>
+
+#ifdef __BMI2__
+#include <immintrin.h>
+#endif
+
+namespace pgn {
+namespace attacks {
+
+// Sliding attacks come from one shared table per piece, indexed by the
+// relevant occupancy bits of the square: extracted with PEXT when the
+// build targets BMI2, otherwise hashed with a magic multiplier found when
+// the tables are built.
+struct Magic {
+    Bitboard mask;
+    Bitboard magic;
+    const Bitboard* table;
+    unsigned shift;
+    
+    size_t index(Bitboard occupied) const {
+#ifdef __BMI2__
+        return static_cast<size_t>(_pext_u64(occupied, mask));
+#else
+        return static_cast<size_t>(((occupied & mask) * magic) >> shift);
+#endif
+    }
+};
+
+struct Tables {
+    Bitboard pawn[2][64];
+    Bitboard knight[64];
+    Bitboard king[64];
+    Magic bishop[64];
+    Magic rook[64];
+    // Squares strictly between two squares on a line, else 0.
+    Bitboard between[64][64];
+};
+
+// Built on first use; the reference is valid for the life of the program.
+const Tables& tables();
+
+inline Bitboard pawn(Color color, int square) { return tables().pawn[int(color)][square]; }
+inline Bitboard knight(int square) { return tables().knight[square]; }
+inline Bitboard king(int square) { return tables().king[square]; }
+
+inline Bitboard bishop(int square, Bitboard occupied) {
+    const Magic& m = tables().bishop[square];
+    return m.table[m.index(occupied)];
+}
+
+inline Bitboard rook(int square, Bitboard occupied) {
+    const Magic& m = tables().rook[square];
+    return m.table[m.index(occupied)];
+}
+
+inline Bitboard queen(int square, Bitboard occupied) {
+    return bishop(square, occupied) | rook(square, occupied);
+}
+
+inline Bitboard between(int from, int to) { return tables().between[from][to]; }
+
+} // namespace attacks
+} // namespace pgn
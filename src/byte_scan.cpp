@@ -0,0 +1,167 @@
+#include "byte_scan.hpp"
+#include "pgn/simd.hpp"
+#include <cstdint>
+#include <cstring>
+
+#if defined(__GNUC__) && !defined(__clang__) && (defined(__x86_64__) || defined(__i386__))
+#define PGN_X86_KERNELS 1
+#include <immintrin.h>
+#endif
+
+namespace pgn {
+
+namespace {
+
+// One bit per byte of a 64-byte block, set where the byte matches.
+struct BlockMasks {
+    uint64_t newline;
+    uint64_t bracket;
+    uint64_t quote;
+    uint64_t dot;
+};
+
+namespace scalar {
+
+inline BlockMasks classify(const char* block) {
+    BlockMasks masks{0, 0, 0, 0};
+    for (unsigned i = 0; i < 64; ++i) {
+        uint64_t bit = uint64_t(1) << i;
+        switch (block[i]) {
+        case '\n': masks.newline |= bit; break;
+        case '[': masks.bracket |= bit; break;
+        case '"': masks.quote |= bit; break;
+        case '.': masks.dot |= bit; break;
+        default: break;
+        }
+    }
+    return masks;
+}
+
+#include "byte_scan_kernels.inl"
+
+} // namespace scalar
+
+#ifdef PGN_X86_KERNELS
+
+#pragma GCC push_options
+#pragma GCC target("sse2")
+namespace sse2 {
+
+inline uint64_t match(const __m128i chunks[4], char byte) {
+    __m128i needle = _mm_set1_epi8(byte);
+    uint64_t mask = 0;
+    for (unsigned i = 0; i < 4; ++i) {
+        uint32_t bits = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunks[i], needle)));
+        mask |= uint64_t(bits) << (16 * i);
+    }
+    return mask;
+}
+
+inline BlockMasks classify(const char* block) {
+    __m128i chunks[4];
+    for (unsigned i = 0; i < 4; ++i) {
+        chunks[i] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + 16 * i));
+    }
+    return BlockMasks{match(chunks, '\n'), match(chunks, '['), match(chunks, '"'), match(chunks, '.')};
+}
+
+#include "byte_scan_kernels.inl"
+
+} // namespace sse2
+#pragma GCC pop_options
+
+#pragma GCC push_options
+#pragma GCC target("avx2,popcnt,bmi")
+namespace avx2 {
+
+inline uint64_t match(__m256i low, __m256i high, char byte) {
+    __m256i needle = _mm256_set1_epi8(byte);
+    uint32_t low_bits = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(low, needle)));
+    uint32_t high_bits = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(high, needle)));
+    return uint64_t(low_bits) | (uint64_t(high_bits) << 32);
+}
+
+inline BlockMasks classify(const char* block) {
+    __m256i low = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block));
+    __m256i high = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + 32));
+    return BlockMasks{match(low, high, '\n'), match(low, high, '['),
+                      match(low, high, '"'), match(low, high, '.')};
+}
+
+#include "byte_scan_kernels.inl"
+
+} // namespace avx2
+#pragma GCC pop_options
+
+#endif // PGN_X86_KERNELS
+
+SimdLevel detect() {
+#ifdef PGN_X86_KERNELS
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt") &&
+        __builtin_cpu_supports("bmi")) {
+        return SimdLevel::avx2;
+    }
+    if (__builtin_cpu_supports("sse2")) return SimdLevel::sse2;
+#endif
+    return SimdLevel::scalar;
+}
+
+const SimdLevel detected_level = detect();
+SimdLevel active_level = detected_level;
+
+} // namespace
+
+SimdLevel detected_simd_level() {
+    return detected_level;
+}
+
+SimdLevel active_simd_level() {
+    return active_level;
+}
+
+SimdLevel set_simd_level(SimdLevel level) {
+    active_level = static_cast<int>(level) <= static_cast<int>(detected_level) ? level : detected_level;
+    return active_level;
+}
+
+const char* simd_level_name(SimdLevel level) {
+    switch (level) {
+    case SimdLevel::avx2: return "avx2";
+    case SimdLevel::sse2: return "sse2";
+    case SimdLevel::scalar: return "scalar";
+    }
+    return "unknown";
+}
+
+MovetextScan scan_movetext(const char* data, size_t size) {
+    switch (active_level) {
+#ifdef PGN_X86_KERNELS
+    case SimdLevel::avx2: return avx2::scan_movetext(data, size);
+    case SimdLevel::sse2: return sse2::scan_movetext(data, size);
+#endif
+    default: return scalar::scan_movetext(data, size);
+    }
+}
+
+LineScan scan_line(const char* data, size_t size) {
+    switch (active_level) {
+#ifdef PGN_X86_KERNELS
+    case SimdLevel::avx2: return avx2::scan_line(data, size);
+    case SimdLevel::sse2: return sse2::scan_line(data, size);
+#endif
+    default: return scalar::scan_line(data, size);
+    }
+}
+
+TagSectionScan scan_tag_lines(const char* data, size_t size, TagLine* lines, size_t max_lines) {
+    switch (active_level) {
+#ifdef PGN_X86_KERNELS
+    case SimdLevel::avx2: return avx2::scan_tag_lines(data, size, lines, max_lines);
+    case SimdLevel::sse2: return sse2::scan_tag_lines(data, size, lines, max_lines);
+#endif
+    default: return scalar::scan_tag_lines(data, size, lines, max_lines);
+    }
+}
+
+} // namespace pgn
@@ -0,0 +1,52 @@
+#pragma once
+#include <cstddef>
+
+namespace pgn {
+
+// Result of scanning movetext: `length` bytes up to (not including) the
+// first line that begins with '[', or to the end of the input when
+// `found_tag_line` is false, and the number of '.' bytes in that span.
+struct MovetextScan {
+    size_t length = 0;
+    int dots = 0;
+    bool found_tag_line = false;
+};
+
+// Result of scanning one line: `length` bytes before the '\n' (or to the
+// end of the input when `has_newline` is false) and the offset of the last
+// '"' in that span, or `length` if there is none.
+struct LineScan {
+    size_t length = 0;
+    size_t last_quote = 0;
+    bool has_newline = false;
+};
+
+// One '\n'-terminated line of a tag section. Offsets are relative to the
+// start of the scan; `last_quote` is relative to the line and equals
+// `length` when the line has no '"'.
+struct TagLine {
+    size_t start;
+    size_t length;
+    size_t last_quote;
+};
+
+enum class TagScanStop {
+    end_of_tags,   // the next line does not begin with '['
+    end_of_input,  // ran out of data; an unterminated line may remain
+    lines_full,    // the output array is full; scan again from `length`
+};
+
+struct TagSectionScan {
+    size_t lines = 0;
+    size_t length = 0;
+    TagScanStop stop = TagScanStop::end_of_input;
+};
+
+// All scanners treat `data` as starting at the beginning of a line and use
+// the kernel selected by set_simd_level(). scan_tag_lines() expects that
+// line to begin with '[' and reports consecutive tag lines in one pass.
+MovetextScan scan_movetext(const char* data, size_t size);
+LineScan scan_line(const char* data, size_t size);
+TagSectionScan scan_tag_lines(const char* data, size_t size, TagLine* lines, size_t max_lines);
+
+} // namespace pgn
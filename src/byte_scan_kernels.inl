@@ -0,0 +1,116 @@
+// Block-scanning kernels shared by every instruction set. Included once per
+// ISA inside its own namespace, after that namespace defines
+//     BlockMasks classify(const char* block)
+// which classifies 64 readable bytes. Never read past `size`: the final
+// partial block is copied into a zero-padded buffer first.
+
+inline BlockMasks classify_tail(const char* data, size_t size) {
+    alignas(64) char block[64] = {};
+    std::memcpy(block, data, size);
+    return classify(block);
+}
+
+inline MovetextScan scan_movetext(const char* data, size_t size) {
+    MovetextScan result;
+    uint64_t line_start_carry = 1;
+    
+    for (size_t offset = 0; offset < size; offset += 64) {
+        size_t remaining = size - offset;
+        BlockMasks masks = remaining >= 64 ? classify(data + offset)
+                                           : classify_tail(data + offset, remaining);
+        
+        uint64_t line_starts = (masks.newline << 1) | line_start_carry;
+        line_start_carry = masks.newline >> 63;
+        uint64_t tag_starts = line_starts & masks.bracket;
+        
+        if (tag_starts) {
+            unsigned index = static_cast<unsigned>(__builtin_ctzll(tag_starts));
+            uint64_t before = (uint64_t(1) << index) - 1;
+            result.dots += __builtin_popcountll(masks.dot & before);
+            result.length = offset + index;
+            result.found_tag_line = true;
+            return result;
+        }
+        result.dots += __builtin_popcountll(masks.dot);
+    }
+    
+    result.length = size;
+    return result;
+}
+
+inline LineScan scan_line(const char* data, size_t size) {
+    LineScan result;
+    size_t last_quote = size;
+    
+    for (size_t offset = 0; offset < size; offset += 64) {
+        size_t remaining = size - offset;
+        BlockMasks masks = remaining >= 64 ? classify(data + offset)
+                                           : classify_tail(data + offset, remaining);
+        
+        uint64_t quotes = masks.quote;
+        if (masks.newline) {
+            unsigned index = static_cast<unsigned>(__builtin_ctzll(masks.newline));
+            quotes &= (uint64_t(1) << index) - 1;
+            if (quotes) last_quote = offset + 63 - __builtin_clzll(quotes);
+            result.length = offset + index;
+            result.last_quote = last_quote == size ? result.length : last_quote;
+            result.has_newline = true;
+            return result;
+        }
+        if (quotes) last_quote = offset + 63 - __builtin_clzll(quotes);
+    }
+    
+    result.length = size;
+    result.last_quote = last_quote;
+    return result;
+}
+
+inline TagSectionScan scan_tag_lines(const char* data, size_t size, TagLine* lines, size_t max_lines) {
+    TagSectionScan result;
+    size_t line_start = 0;
+    size_t last_quote = size;
+    
+    for (size_t offset = 0; offset < size; offset += 64) {
+        size_t remaining = size - offset;
+        BlockMasks masks = remaining >= 64 ? classify(data + offset)
+                                           : classify_tail(data + offset, remaining);
+        
+        uint64_t newlines = masks.newline;
+        uint64_t quotes = masks.quote;
+        
+        while (newlines) {
+            unsigned index = static_cast<unsigned>(__builtin_ctzll(newlines));
+            newlines &= newlines - 1;
+            
+            uint64_t below = (uint64_t(1) << index) - 1;
+            if (quotes & below) last_quote = offset + 63 - __builtin_clzll(quotes & below);
+            quotes &= ~below;
+            
+            size_t line_end = offset + index;
+            lines[result.lines++] = TagLine{line_start, line_end - line_start,
+                                            last_quote == size ? line_end - line_start
+                                                               : last_quote - line_start};
+            line_start = line_end + 1;
+            last_quote = size;
+            result.length = line_start;
+            
+            if (line_start >= size) {
+                result.stop = TagScanStop::end_of_input;
+                return result;
+            }
+            if (data[line_start] != '[') {
+                result.stop = TagScanStop::end_of_tags;
+                return result;
+            }
+            if (result.lines == max_lines) {
+                result.stop = TagScanStop::lines_full;
+                return result;
+            }
+        }
+        
+        if (quotes) last_quote = offset + 63 - __builtin_clzll(quotes);
+    }
+    
+    result.stop = TagScanStop::end_of_input;
+    return result;
+}
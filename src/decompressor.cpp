@@ -0,0 +1,311 @@
+#include "decompressor.hpp"
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#ifdef PGN_WITH_ZLIB
+#include <zlib.h>
+#endif
+#ifdef PGN_WITH_BZIP2
+#include <bzlib.h>
+#endif
+#ifdef PGN_WITH_ZSTD
+#include <zstd.h>
+#endif
+
+namespace pgn {
+
+namespace {
+
+constexpr size_t input_size = 1 << 20;
+
+// One compressed stream format. decode() advances both cursors and returns
+// true when it reaches the end of a stream; restart() prepares for another
+// stream concatenated after it.
+class Codec {
+public:
+    virtual ~Codec() = default;
+    virtual bool decode(const char*& in, const char* in_end, char*& out, char* out_end) = 0;
+    virtual void restart() = 0;
+};
+
+#ifdef PGN_WITH_ZLIB
+class GzipCodec : public Codec {
+public:
+    GzipCodec() {
+        // 15 + 32: full window, accept gzip or zlib headers.
+        if (inflateInit2(&stream_, 15 + 32) != Z_OK) {
+            throw std::runtime_error("Cannot initialize gzip decoder");
+        }
+    }
+    ~GzipCodec() override { inflateEnd(&stream_); }
+    
+    bool decode(const char*& in, const char* in_end, char*& out, char* out_end) override {
+        stream_.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(in));
+        stream_.avail_in = static_cast<uInt>(in_end - in);
+        stream_.next_out = reinterpret_cast<Bytef*>(out);
+        stream_.avail_out = static_cast<uInt>(out_end - out);
+        
+        int status = inflate(&stream_, Z_NO_FLUSH);
+        in = in_end - stream_.avail_in;
+        out = out_end - stream_.avail_out;
+        if (status == Z_STREAM_END) return true;
+        if (status != Z_OK && status != Z_BUF_ERROR) {
+            throw std::runtime_error(std::string("Corrupt gzip input: ") +
+                                     (stream_.msg ? stream_.msg : "inflate failed"));
+        }
+        return false;
+    }
+    
+    void restart() override { inflateReset(&stream_); }
+    
+private:
+    z_stream stream_{};
+};
+#endif
+
+#ifdef PGN_WITH_BZIP2
+class Bzip2Codec : public Codec {
+public:
+    Bzip2Codec() { init(); }
+    ~Bzip2Codec() override { BZ2_bzDecompressEnd(&stream_); }
+    
+    bool decode(const char*& in, const char* in_end, char*& out, char* out_end) override {
+        stream_.next_in = const_cast<char*>(in);
+        stream_.avail_in = static_cast<unsigned>(in_end - in);
+        stream_.next_out = out;
+        stream_.avail_out = static_cast<unsigned>(out_end - out);
+        
+        int status = BZ2_bzDecompress(&stream_);
+        in = in_end - stream_.avail_in;
+        out = out_end - stream_.avail_out;
+        if (status == BZ_STREAM_END) return true;
+        if (status != BZ_OK) throw std::runtime_error("Corrupt bzip2 input");
+        return false;
+    }
+    
+    void restart() override {
+        BZ2_bzDecompressEnd(&stream_);
+        init();
+    }
+    
+private:
+    void init() {
+        stream_ = bz_stream{};
+        if (BZ2_bzDecompressInit(&stream_, 0, 0) != BZ_OK) {
+            throw std::runtime_error("Cannot initialize bzip2 decoder");
+        }
+    }
+    
+    bz_stream stream_{};
+};
+#endif
+
+#ifdef PGN_WITH_ZSTD
+class ZstdCodec : public Codec {
+public:
+    ZstdCodec() : context_(ZSTD_createDCtx()) {
+        if (!context_) throw std::runtime_error("Cannot initialize zstd decoder");
+    }
+    ~ZstdCodec() override { ZSTD_freeDCtx(context_); }
+    
+    bool decode(const char*& in, const char* in_end, char*& out, char* out_end) override {
+        ZSTD_inBuffer input{in, static_cast<size_t>(in_end - in), 0};
+        ZSTD_outBuffer output{out, static_cast<size_t>(out_end - out), 0};
+        
+        size_t status = ZSTD_decompressStream(context_, &output, &input);
+        if (ZSTD_isError(status)) {
+            throw std::runtime_error(std::string("Corrupt zstd input: ") + ZSTD_getErrorName(status));
+        }
+        in += input.pos;
+        out += output.pos;
+        return status == 0;
+    }
+    
+    // A finished frame leaves the context ready for the next one.
+    void restart() override {}
+    
+private:
+    ZSTD_DCtx* context_;
+};
+#endif
+
+std::unique_ptr<Codec> make_codec(Compression compression) {
+    switch (compression) {
+#ifdef PGN_WITH_ZLIB
+        case Compression::gzip: return std::make_unique<GzipCodec>();
+#endif
+#ifdef PGN_WITH_BZIP2
+        case Compression::bzip2: return std::make_unique<Bzip2Codec>();
+#endif
+#ifdef PGN_WITH_ZSTD
+        case Compression::zstd: return std::make_unique<ZstdCodec>();
+#endif
+        default: break;
+    }
+    throw std::runtime_error(std::string("Built without ") + compression_name(compression) +
+                             " support");
+}
+
+} // namespace
+
+Compression detect_compression(const std::string& filename) {
+    std::error_code error;
+    if (!std::filesystem::is_regular_file(filename, error)) return Compression::none;
+    
+    std::ifstream file(filename, std::ios::binary);
+    unsigned char magic[4] = {};
+    file.read(reinterpret_cast<char*>(magic), sizeof(magic));
+    size_t size = static_cast<size_t>(file.gcount());
+    
+    if (size >= 2 && magic[0] == 0x1F && magic[1] == 0x8B) return Compression::gzip;
+    if (size >= 3 && magic[0] == 'B' && magic[1] == 'Z' && magic[2] == 'h') return Compression::bzip2;
+    if (size >= 4 && magic[0] == 0x28 && magic[1] == 0xB5 && magic[2] == 0x2F && magic[3] == 0xFD) {
+        return Compression::zstd;
+    }
+    return Compression::none;
+}
+
+const char* compression_name(Compression compression) {
+    switch (compression) {
+        case Compression::gzip: return "gzip";
+        case Compression::bzip2: return "bzip2";
+        case Compression::zstd: return "zstd";
+        default: return "none";
+    }
+}
+
+struct Decompressor::Impl {
+    std::string filename;
+    std::unique_ptr<Codec> codec;
+    size_t block_size = 0;
+    size_t queue_depth = 0;
+    
+    std::mutex mutex;
+    std::condition_variable not_empty;
+    std::condition_variable not_full;
+    std::deque<std::string> queue;
+    bool finished = false;
+    bool stopping = false;
+    std::exception_ptr error;
+    
+    std::thread worker;
+    
+    void run();
+    void decode_file();
+    bool push(std::string&& block);
+};
+
+Decompressor::Decompressor(const std::string& filename, Compression compression,
+                           size_t block_size, size_t queue_depth)
+    : pimpl(std::make_unique<Impl>()) {
+    pimpl->filename = filename;
+    pimpl->codec = make_codec(compression);
+    pimpl->block_size = block_size;
+    pimpl->queue_depth = queue_depth;
+    pimpl->worker = std::thread([impl = pimpl.get()] { impl->run(); });
+}
+
+Decompressor::~Decompressor() {
+    {
+        std::lock_guard<std::mutex> lock(pimpl->mutex);
+        pimpl->stopping = true;
+    }
+    pimpl->not_full.notify_all();
+    pimpl->worker.join();
+}
+
+bool Decompressor::next_block(std::string& block) {
+    std::unique_lock<std::mutex> lock(pimpl->mutex);
+    pimpl->not_empty.wait(lock, [this] { return !pimpl->queue.empty() || pimpl->finished; });
+    
+    if (pimpl->queue.empty()) {
+        if (pimpl->error) std::rethrow_exception(pimpl->error);
+        return false;
+    }
+    block = std::move(pimpl->queue.front());
+    pimpl->queue.pop_front();
+    lock.unlock();
+    pimpl->not_full.notify_one();
+    return true;
+}
+
+void Decompressor::Impl::run() {
+    try {
+        decode_file();
+    } catch (...) {
+        std::lock_guard<std::mutex> lock(mutex);
+        error = std::current_exception();
+    }
+    
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        finished = true;
+    }
+    not_empty.notify_all();
+}
+
+void Decompressor::Impl::decode_file() {
+    std::ifstream file(filename, std::ios::binary);
+    if (!file.is_open()) {
+        throw std::runtime_error("Cannot open file: " + filename);
+    }
+    
+    std::vector<char> input(input_size);
+    const char* in = input.data();
+    const char* in_end = in;
+    bool input_done = false;
+    bool stream_end = false;
+    
+    std::string block(block_size, '\0');
+    size_t used = 0;
+    
+    for (;;) {
+        if (in == in_end && !input_done) {
+            file.read(input.data(), input.size());
+            in = input.data();
+            in_end = in + file.gcount();
+            if (!file) input_done = true;
+        }
+        if (in == in_end && input_done) break;
+        
+        // More input after the end of a stream: a concatenated member.
+        if (stream_end) {
+            codec->restart();
+            stream_end = false;
+        }
+        
+        char* out = &block[used];
+        stream_end = codec->decode(in, in_end, out, block.data() + block.size());
+        used = static_cast<size_t>(out - block.data());
+        
+        if (used == block.size()) {
+            if (!push(std::move(block))) return;
+            block.assign(block_size, '\0');
+            used = 0;
+        }
+    }
+    
+    if (!stream_end) throw std::runtime_error("Truncated compressed input: " + filename);
+    
+    block.resize(used);
+    if (!block.empty()) push(std::move(block));
+}
+
+bool Decompressor::Impl::push(std::string&& block) {
+    std::unique_lock<std::mutex> lock(mutex);
+    not_full.wait(lock, [this] { return queue.size() < queue_depth || stopping; });
+    if (stopping) return false;
+    queue.push_back(std::move(block));
+    lock.unlock();
+    not_empty.notify_one();
+    return true;
+}
+
+} // namespace pgn
@@ -0,0 +1,48 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <string>
+
+namespace pgn {
+
+enum class Compression {
+    none,
+    gzip,
+    bzip2,
+    zstd,
+};
+
+// Identifies gzip, bzip2 and zstd inputs by their magic bytes. Anything
+// else, including files that cannot be read up front (pipes, devices), is
+// treated as plain text.
+Compression detect_compression(const std::string& filename);
+
+const char* compression_name(Compression compression);
+
+// Decodes a compressed file on a background thread into a bounded queue
+// of blocks, so decompression overlaps with whatever consumes the blocks.
+// Codecs are optional at build time (PGN_WITH_ZLIB, PGN_WITH_BZIP2,
+// PGN_WITH_ZSTD); opening a file whose codec was left out throws.
+class Decompressor {
+public:
+    static constexpr size_t default_block_size = 4 << 20;
+    static constexpr size_t default_queue_depth = 4;
+    
+    Decompressor(const std::string& filename, Compression compression,
+                 size_t block_size = default_block_size,
+                 size_t queue_depth = default_queue_depth);
+    ~Decompressor();
+    
+    Decompressor(const Decompressor&) = delete;
+    Decompressor& operator=(const Decompressor&) = delete;
+    
+    // Replaces `block` with the next run of decompressed bytes. Returns
+    // false at the end of the input; rethrows any decoding error.
+    bool next_block(std::string& block);
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> pimpl;
+};
+
+} // namespace pgn
@@ -0,0 +1,246 @@
+#include "dedup.hpp"
+#include "metrics_counters.hpp"
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <string_view>
+#include <thread>
+
+namespace pgn {
+
+namespace {
+
+constexpr unsigned ordinal_bits = 40;
+constexpr uint64_t ordinal_mask = (uint64_t(1) << ordinal_bits) - 1;
+constexpr uint64_t unset = ~uint64_t(0);
+constexpr size_t min_capacity = 1024;
+
+uint64_t fold_multiply(uint64_t a, uint64_t b) {
+    unsigned __int128 product = static_cast<unsigned __int128>(a) * b;
+    return static_cast<uint64_t>(product) ^ static_cast<uint64_t>(product >> 64);
+}
+
+uint64_t load64(const char* p) {
+    uint64_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+// Two multiply-fold lanes over 16-byte blocks, each lane taking both
+// words of every block.
+Fingerprint hash_text(std::string_view text) {
+    constexpr uint64_t k0 = 0xa0761d6478bd642full;
+    constexpr uint64_t k1 = 0xe7037ed1a0b428dbull;
+    constexpr uint64_t k2 = 0x8ebc6af09c88c6e3ull;
+    constexpr uint64_t k3 = 0x589965cc75374cc3ull;
+    uint64_t a = k0 ^ text.size();
+    uint64_t b = k1 ^ (text.size() << 32);
+    const char* p = text.data();
+    size_t n = text.size();
+    auto block = [&](uint64_t x, uint64_t y) {
+        a = fold_multiply(x ^ k2, y ^ a);
+        b = fold_multiply(y ^ k3, x ^ b);
+    };
+    for (; n > 16; p += 16, n -= 16) block(load64(p), load64(p + 8));
+    char tail[16] = {};
+    std::memcpy(tail, p, n);
+    block(load64(tail), load64(tail + 8));
+    
+    Fingerprint fingerprint;
+    fingerprint.high = fold_multiply(a ^ k0, b ^ k3);
+    fingerprint.low = fold_multiply(b ^ k1, a ^ k2);
+    if (fingerprint.high == 0) fingerprint.high = 1;
+    if (fingerprint.low == 0) fingerprint.low = 1;
+    return fingerprint;
+}
+
+bool is_digit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+// Byte classes for the movetext scan: token characters, blanks, and the
+// characters that open or close comments, variations and NAGs.
+enum : uint8_t { token_char, blank, delimiter };
+
+const std::array<uint8_t, 256> byte_classes = [] {
+    std::array<uint8_t, 256> classes{};
+    for (unsigned char c : {' ', '\n', '\r', '\t'}) classes[c] = blank;
+    for (unsigned char c : {'{', '}', '(', ')', ';', '$'}) classes[c] = delimiter;
+    return classes;
+}();
+
+uint8_t byte_class(char c) {
+    return byte_classes[static_cast<unsigned char>(c)];
+}
+
+// Letters folded to lower case and digits; other ASCII is dropped, so
+// "Carlsen, M." and "carlsen m" agree. UTF-8 bytes are kept as they are.
+void append_folded(std::string& out, std::string_view text) {
+    for (char c : text) {
+        auto byte = static_cast<unsigned char>(c);
+        if (c >= 'A' && c <= 'Z') {
+            out.push_back(static_cast<char>(c + ('a' - 'A')));
+        } else if ((c >= 'a' && c <= 'z') || is_digit(c) || byte >= 0x80) {
+            out.push_back(c);
+        }
+    }
+    out.push_back('\x1f');
+}
+
+// The main line's moves, one space after each. Returns how many.
+size_t append_moves(std::string& out, std::string_view text) {
+    size_t moves = 0;
+    int depth = 0;
+    size_t i = 0;
+    while (i < text.size()) {
+        char c = text[i];
+        uint8_t type = byte_class(c);
+        if (type == blank) {
+            i++;
+            continue;
+        }
+        if (type == delimiter) {
+            size_t end = i + 1;
+            if (c == '{' || c == ';') {
+                end = text.find(c == '{' ? '}' : '\n', i);
+                end = end == std::string_view::npos ? text.size() : end + 1;
+            } else if (c == '$') {
+                while (end < text.size() && is_digit(text[end])) end++;
+            } else if (c == '(') {
+                depth++;
+            } else if (c == ')' && depth > 0) {
+                depth--;
+            }
+            i = end;
+            continue;
+        }
+        
+        size_t start = i;
+        while (i < text.size() && byte_class(text[i]) == token_char) i++;
+        if (depth > 0) continue;
+        std::string_view token = text.substr(start, i - start);
+        if (token == "1-0" || token == "0-1" || token == "1/2-1/2" || token == "*") continue;
+        
+        // Move numbers, apart from the move or glued to it: "12.", "12...",
+        // "12.e4".
+        size_t digits = 0;
+        while (digits < token.size() && is_digit(token[digits])) digits++;
+        if (digits == token.size()) continue;
+        if (digits > 0 && token[digits] == '.') token.remove_prefix(digits);
+        while (!token.empty() && token.front() == '.') token.remove_prefix(1);
+        while (!token.empty() && (token.back() == '+' || token.back() == '#' ||
+                                  token.back() == '!' || token.back() == '?')) {
+            token.remove_suffix(1);
+        }
+        if (token.size() > 4 && token.substr(token.size() - 4) == "e.p.") token.remove_suffix(4);
+        if (token.empty()) continue;
+        
+        size_t at = out.size();
+        out.append(token);
+        out.push_back(' ');
+        // Castling is written with zeros as well as letters; no other move
+        // has a zero in it.
+        if (token.front() == '0') {
+            for (size_t k = at; k + 1 < out.size(); ++k) {
+                if (out[k] == '0') out[k] = 'O';
+            }
+        }
+        moves++;
+    }
+    return moves;
+}
+
+void store_min(std::atomic<uint64_t>& target, uint64_t value) {
+    uint64_t current = target.load(std::memory_order_relaxed);
+    while (value < current &&
+           !target.compare_exchange_weak(current, value, std::memory_order_relaxed)) {}
+}
+
+} // namespace
+
+Fingerprint fingerprint_game(const GameView& game, std::string& scratch) {
+    scratch.clear();
+    if (append_moves(scratch, game.movetext) == 0) return Fingerprint();
+    scratch.push_back('\x1e');
+    append_folded(scratch, game.white);
+    append_folded(scratch, game.black);
+    for (char c : game.date) {
+        if (is_digit(c)) scratch.push_back(c);
+    }
+    scratch.push_back('\x1f');
+    scratch.append(game.result);
+    scratch.push_back('\x1f');
+    scratch.append(game.fen);
+    return hash_text(scratch);
+}
+
+void FingerprintSet::reserve(size_t count) {
+    size_t needed = size_ + count;
+    if (needed * 4 <= capacity_ * 3) return;
+    size_t capacity = std::max(capacity_, min_capacity);
+    while (needed * 4 > capacity * 3) capacity *= 2;
+    if (capacity_ > 0) metrics::count_rehash(HashTable::fingerprints);
+    
+    std::unique_ptr<Slot[]> slots(new Slot[capacity]);
+    size_t mask = capacity - 1;
+    unsigned shift = 64 - static_cast<unsigned>(__builtin_ctzll(capacity));
+    for (size_t i = 0; i < capacity_; ++i) {
+        uint64_t key = slots_[i].key.load(std::memory_order_relaxed);
+        if (key == 0) continue;
+        size_t slot = key >> shift;
+        while (slots[slot].key.load(std::memory_order_relaxed) != 0) slot = (slot + 1) & mask;
+        slots[slot].key.store(key, std::memory_order_relaxed);
+        slots[slot].word.store(slots_[i].word.load(std::memory_order_relaxed),
+                               std::memory_order_relaxed);
+    }
+    slots_ = std::move(slots);
+    capacity_ = capacity;
+}
+
+bool FingerprintSet::claim(const Fingerprint& fingerprint, uint64_t ordinal) {
+    uint64_t tag = fingerprint.low >> ordinal_bits;
+    uint64_t word = (tag << ordinal_bits) | (ordinal & ordinal_mask);
+    size_t mask = capacity_ - 1;
+    unsigned shift = 64 - static_cast<unsigned>(__builtin_ctzll(capacity_));
+    for (size_t slot = fingerprint.high >> shift;; slot = (slot + 1) & mask) {
+        Slot& entry = slots_[slot];
+        uint64_t key = entry.key.load(std::memory_order_acquire);
+        if (key == 0 && entry.key.compare_exchange_strong(key, fingerprint.high,
+                                                          std::memory_order_acq_rel)) {
+            store_min(entry.word, word);
+            return true;
+        }
+        if (key != fingerprint.high) continue;
+        
+        // The thread that took the slot is about to store its tag.
+        uint64_t current;
+        while ((current = entry.word.load(std::memory_order_acquire)) == unset) {
+            std::this_thread::yield();
+        }
+        if (current >> ordinal_bits != tag) continue;
+        store_min(entry.word, word);
+        return false;
+    }
+}
+
+uint64_t FingerprintSet::owner(const Fingerprint& fingerprint) const {
+    if (capacity_ == 0) return unset;
+    uint64_t tag = fingerprint.low >> ordinal_bits;
+    size_t mask = capacity_ - 1;
+    unsigned shift = 64 - static_cast<unsigned>(__builtin_ctzll(capacity_));
+    for (size_t slot = fingerprint.high >> shift;; slot = (slot + 1) & mask) {
+        const Slot& entry = slots_[slot];
+        uint64_t key = entry.key.load(std::memory_order_acquire);
+        if (key == 0) return unset;
+        uint64_t word = entry.word.load(std::memory_order_acquire);
+        if (key == fingerprint.high && word >> ordinal_bits == tag) return word & ordinal_mask;
+    }
+}
+
+void FingerprintSet::clear() {
+    slots_.reset();
+    capacity_ = 0;
+    size_ = 0;
+}
+
+} // namespace pgn
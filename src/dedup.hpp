@@ -0,0 +1,70 @@
+#pragma once
+#include "pgn/types.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace pgn {
+
+// Content hash of one game; both halves are non-zero. An all-zero
+// fingerprint marks a game that is never treated as a duplicate.
+struct Fingerprint {
+    uint64_t high = 0;
+    uint64_t low = 0;
+    
+    bool empty() const { return high == 0; }
+};
+
+// Fingerprint of a game that survives the differences between databases
+// carrying the same game: player names and the date reduced to lower-case
+// letters and digits, the result, the starting position and the main
+// line's moves, without move numbers, comments, variations, NAGs, check
+// or annotation marks. Event, site and round are left out, since sources
+// spell them differently. Games without moves get an empty fingerprint.
+// `scratch` is reused between calls to hold the normalized text.
+Fingerprint fingerprint_game(const GameView& game, std::string& scratch);
+
+// Set of fingerprints that many threads fill at once without locks. For
+// each fingerprint it keeps the smallest ordinal it was claimed with, so
+// when copies of a game are claimed concurrently, the first in input
+// order owns it whatever the timing.
+//
+// Slots are 16 bytes: the high half of the fingerprint, and 24 bits of the
+// low half packed above a 40-bit ordinal, which a fetch-min keeps. A false
+// match needs 88 equal bits. Linear probing, at most 3/4 full.
+class FingerprintSet {
+public:
+    FingerprintSet() = default;
+    FingerprintSet(const FingerprintSet&) = delete;
+    FingerprintSet& operator=(const FingerprintSet&) = delete;
+    
+    // Makes room for `count` more fingerprints. Not thread-safe.
+    void reserve(size_t count);
+    // Thread-safe, within the room made by reserve(). Returns true if the
+    // fingerprint was not in the set before.
+    bool claim(const Fingerprint& fingerprint, uint64_t ordinal);
+    // Thread-safe once claiming is over: the smallest ordinal `fingerprint`
+    // was claimed with.
+    uint64_t owner(const Fingerprint& fingerprint) const;
+    // Counts fingerprints that claim() reported new. Not thread-safe.
+    void added(size_t count) { size_ += count; }
+    
+    size_t size() const { return size_; }
+    double load_factor() const { return capacity_ ? double(size_) / capacity_ : 0.0; }
+    size_t memory_usage() const { return capacity_ * sizeof(Slot); }
+    void clear();
+    
+private:
+    struct Slot {
+        std::atomic<uint64_t> key{0};
+        std::atomic<uint64_t> word{~uint64_t(0)};
+    };
+    
+    std::unique_ptr<Slot[]> slots_;
+    size_t capacity_ = 0;
+    size_t size_ = 0;
+};
+
+} // namespace pgn
@@ -0,0 +1,323 @@
+#include "game_index.hpp"
+#include "mapped_file.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <unordered_map>
+
+namespace pgn {
+
+namespace {
+
+constexpr char index_magic[8] = {'P', 'G', 'N', 'I', 'D', 'X', '0', '1'};
+constexpr uint32_t index_version = 2;
+constexpr uint32_t byte_order_mark = 0x01020304;
+constexpr size_t sample_size = 64 * 1024;
+
+using NameColumn = const std::vector<Symbol>& (GameTable::*)() const;
+const NameColumn name_columns[] = {
+    &GameTable::events, &GameTable::sites, &GameTable::rounds,
+    &GameTable::whites, &GameTable::blacks, &GameTable::openings,
+};
+std::vector<Symbol> GameTable::Columns::* const name_fields[] = {
+    &GameTable::Columns::events, &GameTable::Columns::sites, &GameTable::Columns::rounds,
+    &GameTable::Columns::whites, &GameTable::Columns::blacks, &GameTable::Columns::openings,
+};
+constexpr size_t name_column_count = sizeof(name_columns) / sizeof(name_columns[0]);
+constexpr size_t event_column = 0;
+constexpr size_t white_column = 3;
+constexpr size_t black_column = 4;
+
+struct IndexHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint64_t source_size;
+    int64_t source_mtime;
+    uint64_t source_hash;
+    uint64_t game_count;
+    uint64_t string_count;
+    uint64_t string_bytes;
+    uint64_t raw_count;
+    uint64_t tournament_count;
+    uint64_t player_count;
+};
+
+uint64_t fnv1a(const char* data, size_t size, uint64_t hash = 0xcbf29ce484222325ull) {
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= static_cast<unsigned char>(data[i]);
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+// Writes `count` values followed by zeros up to the next 8-byte boundary.
+template <typename T>
+void write_array(std::ofstream& out, const T* values, size_t count) {
+    static const char padding[8] = {};
+    size_t bytes = count * sizeof(T);
+    out.write(reinterpret_cast<const char*>(values), static_cast<std::streamsize>(bytes));
+    out.write(padding, static_cast<std::streamsize>((8 - bytes % 8) % 8));
+}
+
+template <typename T>
+void write_array(std::ofstream& out, const std::vector<T>& values) {
+    write_array(out, values.data(), values.size());
+}
+
+// Hands out the arrays of a mapped index in order, each 8-byte aligned.
+// Once an array would run past the end, every later one is null.
+class ArrayReader {
+public:
+    ArrayReader(const char* data, size_t size, size_t at) : data_(data), size_(size), at_(at) {}
+    
+    template <typename T>
+    const T* next(uint64_t count) {
+        if (failed_ || count > (size_ - at_) / sizeof(T)) {
+            failed_ = true;
+            return nullptr;
+        }
+        const T* values = reinterpret_cast<const T*>(data_ + at_);
+        size_t end = at_ + count * sizeof(T);
+        at_ = end + (8 - end % 8) % 8;
+        failed_ = at_ > size_;
+        return failed_ ? nullptr : values;
+    }
+    
+    // True when every array was in bounds and they end the file.
+    bool complete() const { return !failed_ && at_ == size_; }
+    
+private:
+    const char* data_;
+    size_t size_;
+    size_t at_;
+    bool failed_ = false;
+};
+
+} // namespace
+
+SourceStamp stamp_source(const std::string& filename) {
+    SourceStamp stamp;
+    std::error_code error;
+    stamp.size = std::filesystem::file_size(filename, error);
+    if (error) return SourceStamp{};
+    stamp.mtime = static_cast<int64_t>(
+        std::filesystem::last_write_time(filename, error).time_since_epoch().count());
+    
+    std::ifstream file(filename, std::ios::binary);
+    std::vector<char> sample(sample_size);
+    file.read(sample.data(), sample.size());
+    stamp.sample_hash = fnv1a(sample.data(), static_cast<size_t>(file.gcount()));
+    if (stamp.size > sample_size) {
+        file.clear();
+        file.seekg(static_cast<std::streamoff>(stamp.size - sample_size));
+        file.read(sample.data(), sample.size());
+        stamp.sample_hash = fnv1a(sample.data(), static_cast<size_t>(file.gcount()), stamp.sample_hash);
+    }
+    return stamp;
+}
+
+std::string index_path_for(const std::string& filename) {
+    return filename + ".pgnidx";
+}
+
+bool write_game_index(const std::string& path, const SourceStamp& stamp, const GameTable& table) {
+    size_t games = table.size();
+    
+    // Strings get ids in order of first use, "" being 0.
+    std::unordered_map<uint32_t, uint32_t> string_ids{{0, 0}};
+    std::vector<Symbol> strings{Symbol()};
+    auto id_of = [&](Symbol symbol) {
+        auto [it, inserted] = string_ids.emplace(symbol.id(), static_cast<uint32_t>(strings.size()));
+        if (inserted) strings.push_back(symbol);
+        return it->second;
+    };
+    
+    std::vector<uint32_t> names(name_column_count * games);
+    for (size_t column = 0; column < name_column_count; ++column) {
+        const std::vector<Symbol>& symbols = (table.*name_columns[column])();
+        for (size_t i = 0; i < games; ++i) names[column * games + i] = id_of(symbols[i]);
+    }
+    
+    std::vector<std::pair<uint64_t, uint32_t>> raw;
+    raw.reserve(table.raw_values().size());
+    for (const auto& [key, text] : table.raw_values()) raw.emplace_back(key, id_of(text));
+    std::sort(raw.begin(), raw.end());
+    std::vector<uint64_t> raw_keys;
+    std::vector<uint32_t> raw_strings;
+    for (const auto& [key, id] : raw) {
+        raw_keys.push_back(key);
+        raw_strings.push_back(id);
+    }
+    
+    std::vector<uint32_t> tournament_names;
+    std::vector<uint32_t> player_names;
+    std::vector<bool> seen_tournament(strings.size());
+    std::vector<bool> seen_player(strings.size());
+    seen_tournament[0] = seen_player[0] = true;
+    auto note = [](uint32_t id, std::vector<bool>& seen, std::vector<uint32_t>& list) {
+        if (!seen[id]) {
+            seen[id] = true;
+            list.push_back(id);
+        }
+    };
+    for (size_t i = 0; i < games; ++i) {
+        note(names[event_column * games + i], seen_tournament, tournament_names);
+        note(names[white_column * games + i], seen_player, player_names);
+        note(names[black_column * games + i], seen_player, player_names);
+    }
+    
+    std::vector<uint64_t> string_offsets{0};
+    std::string string_data;
+    string_offsets.reserve(strings.size() + 1);
+    for (Symbol text : strings) {
+        string_data += text.str();
+        string_offsets.push_back(string_data.size());
+    }
+    
+    IndexHeader header{};
+    std::memcpy(header.magic, index_magic, sizeof(index_magic));
+    header.version = index_version;
+    header.byte_order = byte_order_mark;
+    header.source_size = stamp.size;
+    header.source_mtime = stamp.mtime;
+    header.source_hash = stamp.sample_hash;
+    header.game_count = games;
+    header.string_count = strings.size();
+    header.string_bytes = string_data.size();
+    header.raw_count = raw.size();
+    header.tournament_count = tournament_names.size();
+    header.player_count = player_names.size();
+    
+    std::string temp_path = path + ".tmp";
+    {
+        std::ofstream out(temp_path, std::ios::binary | std::ios::trunc);
+        if (!out) return false;
+        
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        write_array(out, string_offsets);
+        write_array(out, string_data.data(), string_data.size());
+        write_array(out, names);
+        write_array(out, table.dates());
+        write_array(out, table.white_elos());
+        write_array(out, table.black_elos());
+        write_array(out, table.eco_codes());
+        write_array(out, table.move_counts());
+        write_array(out, table.offsets());
+        write_array(out, table.result_words());
+        write_array(out, raw_keys);
+        write_array(out, raw_strings);
+        write_array(out, tournament_names);
+        write_array(out, player_names);
+        
+        if (!out) {
+            out.close();
+            std::remove(temp_path.c_str());
+            return false;
+        }
+    }
+    
+    std::error_code error;
+    std::filesystem::rename(temp_path, path, error);
+    if (error) {
+        std::remove(temp_path.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool read_game_index(const std::string& path, const SourceStamp& stamp, IndexContents& contents) {
+    contents = IndexContents{};
+    
+    std::error_code error;
+    if (!std::filesystem::is_regular_file(path, error)) return false;
+    
+    MappedFile mapping;
+    try {
+        mapping.open(path);
+    } catch (const std::exception&) {
+        return false;
+    }
+    
+    const char* data = mapping.data();
+    size_t size = mapping.size();
+    if (size < sizeof(IndexHeader)) return false;
+    
+    IndexHeader header;
+    std::memcpy(&header, data, sizeof(header));
+    if (std::memcmp(header.magic, index_magic, sizeof(index_magic)) != 0 ||
+        header.version != index_version || header.byte_order != byte_order_mark ||
+        header.string_count == 0) {
+        return false;
+    }
+    
+    SourceStamp recorded{header.source_size, header.source_mtime, header.source_hash};
+    if (!(recorded == stamp)) return false;
+    
+    uint64_t games = header.game_count;
+    if (games > size || header.string_count > size) return false;
+    ArrayReader reader(data, size, sizeof(IndexHeader));
+    const uint64_t* string_offsets = reader.next<uint64_t>(header.string_count + 1);
+    const char* string_data = reader.next<char>(header.string_bytes);
+    const uint32_t* names = reader.next<uint32_t>(name_column_count * games);
+    const uint32_t* dates = reader.next<uint32_t>(games);
+    const uint16_t* white_elos = reader.next<uint16_t>(games);
+    const uint16_t* black_elos = reader.next<uint16_t>(games);
+    const uint16_t* eco_codes = reader.next<uint16_t>(games);
+    const int32_t* move_counts = reader.next<int32_t>(games);
+    const uint64_t* game_offsets = reader.next<uint64_t>(games);
+    const uint64_t* results = reader.next<uint64_t>((games + 31) / 32);
+    const uint64_t* raw_keys = reader.next<uint64_t>(header.raw_count);
+    const uint32_t* raw_strings = reader.next<uint32_t>(header.raw_count);
+    const uint32_t* tournament_names = reader.next<uint32_t>(header.tournament_count);
+    const uint32_t* player_names = reader.next<uint32_t>(header.player_count);
+    if (!reader.complete()) return false;
+    
+    // One symbol per distinct string; the name columns are translated
+    // through these instead of interning every game's names.
+    std::vector<Symbol> symbols(header.string_count);
+    for (uint64_t i = 0; i < header.string_count; ++i) {
+        uint64_t begin = string_offsets[i];
+        uint64_t finish = string_offsets[i + 1];
+        if (begin > finish || finish > header.string_bytes) return false;
+        symbols[i] = intern(std::string_view(string_data + begin, finish - begin));
+    }
+    auto translate = [&](const uint32_t* ids, uint64_t count, std::vector<Symbol>& into) {
+        into.resize(count);
+        for (uint64_t i = 0; i < count; ++i) {
+            if (ids[i] >= header.string_count) return false;
+            into[i] = symbols[ids[i]];
+        }
+        return true;
+    };
+    
+    GameTable::Columns columns;
+    for (size_t column = 0; column < name_column_count; ++column) {
+        if (!translate(names + column * games, games, columns.*name_fields[column])) return false;
+    }
+    columns.dates.assign(dates, dates + games);
+    columns.white_elos.assign(white_elos, white_elos + games);
+    columns.black_elos.assign(black_elos, black_elos + games);
+    columns.eco_codes.assign(eco_codes, eco_codes + games);
+    columns.move_counts.assign(move_counts, move_counts + games);
+    columns.offsets.assign(game_offsets, game_offsets + games);
+    columns.results.assign(results, results + (games + 31) / 32);
+    columns.raw.reserve(header.raw_count);
+    for (uint64_t i = 0; i < header.raw_count; ++i) {
+        // Five fields a row; see GameTable::Columns.
+        if (raw_keys[i] >= games * 5 || raw_strings[i] >= header.string_count) return false;
+        columns.raw.emplace(raw_keys[i], symbols[raw_strings[i]]);
+    }
+    
+    if (!translate(tournament_names, header.tournament_count, contents.tournament_names) ||
+        !translate(player_names, header.player_count, contents.player_names)) {
+        contents = IndexContents{};
+        return false;
+    }
+    contents.table.assign(std::move(columns));
+    return true;
+}
+
+} // namespace pgn
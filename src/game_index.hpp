@@ -0,0 +1,66 @@
+#pragma once
+#include "pgn/game_table.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace pgn {
+
+// Identity of a source PGN as recorded in its index: size, modification
+// time and a hash of its first and last 64 KiB.
+struct SourceStamp {
+    uint64_t size = 0;
+    int64_t mtime = 0;
+    uint64_t sample_hash = 0;
+    
+    bool operator==(const SourceStamp& other) const {
+        return size == other.size && mtime == other.mtime && sample_hash == other.sample_hash;
+    }
+};
+
+SourceStamp stamp_source(const std::string& filename);
+
+std::string index_path_for(const std::string& filename);
+
+// Binary sidecar (.pgnidx) holding a GameTable column by column, in the
+// table's own encodings, so that reading it back re-encodes nothing. Names
+// are ids into a deduplicated string table; each distinct string is
+// interned once on reading and the name columns are mapped through those
+// symbols. All integers are little-endian and fixed width, and every
+// array starts on an 8-byte boundary (zero padding in between):
+//
+//     header
+//     uint64 string_offsets[string_count + 1]
+//     char   string_data[string_bytes]
+//     uint32 name_columns[6][game_count]     event, site, round, white,
+//                                            black, opening
+//     uint32 dates[game_count]
+//     uint16 white_elos[game_count], black_elos[game_count],
+//            eco_codes[game_count]
+//     int32  move_counts[game_count]
+//     uint64 game_offsets[game_count]
+//     uint64 results[(game_count + 31) / 32]
+//     uint64 raw_keys[raw_count]             GameTable::Columns::raw
+//     uint32 raw_strings[raw_count]
+//     uint32 tournament_names[tournament_count]
+//     uint32 player_names[player_count]
+//
+// The name lists hold each non-empty event and player name in order of
+// first appearance, as DatabaseStats does.
+//
+// write_game_index writes to a temporary file and renames it into place, so
+// readers never see a partial index. Returns false if it could not write.
+bool write_game_index(const std::string& path, const SourceStamp& stamp, const GameTable& table);
+
+struct IndexContents {
+    GameTable table;
+    std::vector<Symbol> tournament_names;
+    std::vector<Symbol> player_names;
+};
+
+// Reads the index at `path` if it exists, is well formed and was built from
+// a source matching `stamp`. Returns false, leaving `contents` empty,
+// otherwise.
+bool read_game_index(const std::string& path, const SourceStamp& stamp, IndexContents& contents);
+
+} // namespace pgn
@@ -0,0 +1,184 @@
+#include "game_scanner.hpp"
+#include "byte_scan.hpp"
+#include "metrics_counters.hpp"
+#include "pgn/movetext.hpp"
+
+namespace pgn {
+
+namespace {
+
+constexpr unsigned tag_key(size_t length, char first) {
+    return static_cast<unsigned>(length << 8) | static_cast<unsigned char>(first);
+}
+
+// GameView fields by TagKind.
+constexpr std::string_view GameView::* tag_fields[] = {
+    &GameView::event, &GameView::site, &GameView::date, &GameView::round, &GameView::white,
+    &GameView::black, &GameView::result, &GameView::white_elo, &GameView::black_elo,
+    &GameView::eco, &GameView::fen, &GameView::opening};
+
+// Maps a tag name to the kind of tag with a single switch on (length,
+// first letter), which is collision-free for the tags we keep; one
+// comparison then confirms the name.
+TagKind tag_kind(std::string_view name) {
+    if (name.empty()) return TagKind::other;
+    
+    std::string_view expected;
+    TagKind kind;
+    switch (tag_key(name.size(), name[0])) {
+    case tag_key(5, 'E'): expected = "Event"; kind = TagKind::event; break;
+    case tag_key(4, 'S'): expected = "Site"; kind = TagKind::site; break;
+    case tag_key(4, 'D'): expected = "Date"; kind = TagKind::date; break;
+    case tag_key(5, 'R'): expected = "Round"; kind = TagKind::round; break;
+    case tag_key(5, 'W'): expected = "White"; kind = TagKind::white; break;
+    case tag_key(5, 'B'): expected = "Black"; kind = TagKind::black; break;
+    case tag_key(6, 'R'): expected = "Result"; kind = TagKind::result; break;
+    case tag_key(8, 'W'): expected = "WhiteElo"; kind = TagKind::white_elo; break;
+    case tag_key(8, 'B'): expected = "BlackElo"; kind = TagKind::black_elo; break;
+    case tag_key(3, 'E'): expected = "ECO"; kind = TagKind::eco; break;
+    case tag_key(3, 'F'): expected = "FEN"; kind = TagKind::fen; break;
+    case tag_key(7, 'O'): expected = "Opening"; kind = TagKind::opening; break;
+    default: return TagKind::other;
+    }
+    return name == expected ? kind : TagKind::other;
+}
+
+// `line` is a whole tag line such as [White "Carlsen, Magnus"] and
+// `last_quote` the offset of its final '"'.
+void read_tag(std::string_view line, size_t last_quote, uint32_t tags, GameView& game) {
+    size_t name_end = 1;
+    while (name_end < line.size() && name_end < 16 && line[name_end] != ' ') name_end++;
+    
+    size_t start = name_end + 2;
+    if (start > line.size() || line[name_end] != ' ' || line[name_end + 1] != '"') {
+        metrics::count_tag(TagKind::other);
+        return;
+    }
+    
+    TagKind kind = tag_kind(line.substr(1, name_end - 1));
+    metrics::count_tag(kind);
+    if (kind != TagKind::other && (tags >> size_t(kind) & 1) && last_quote != line.size() &&
+        last_quote > start) {
+        game.*tag_fields[size_t(kind)] = line.substr(start, last_quote - start);
+    }
+}
+
+void read_tag_line(const char* base, const TagLine& line, uint32_t tags, GameView& game) {
+    size_t length = line.length;
+    if (length > 0 && base[line.start + length - 1] == '\r') length--;
+    size_t last_quote = line.last_quote < length ? line.last_quote : length;
+    read_tag(std::string_view(base + line.start, length), last_quote, tags, game);
+}
+
+// Replaces the '.' estimate of move_count with the number of full moves
+// actually played.
+void replay_game(GameView& game) {
+    metrics::StageTimer timer(Stage::replay);
+    static const Position start;
+    Position position = start;
+    if (!game.fen.empty() && !position.set_fen(game.fen)) {
+        game.moves_valid = false;
+        game.move_count = 0;
+        return;
+    }
+    ReplayResult replay = replay_movetext(game.movetext, position);
+    game.move_count = (replay.plies + 1) / 2;
+    game.moves_valid = replay.valid;
+}
+
+// Offset just past the last complete line of `text`.
+size_t last_line_start(std::string_view text) {
+    size_t newline = text.rfind('\n');
+    return newline == std::string_view::npos ? 0 : newline + 1;
+}
+
+} // namespace
+
+bool GameScanner::next(GameView& game) {
+    const char* base = text_.data();
+    size_t size = text_.size();
+    
+    for (;;) {
+        game = GameView{};
+        
+        // Skip anything before the first tag line.
+        if (pos_ < size && base[pos_] != '[') {
+            MovetextScan skipped = scan_movetext(base + pos_, size - pos_);
+            if (!skipped.found_tag_line) {
+                pos_ = input_complete_ ? size : pos_ + last_line_start(text_.substr(pos_));
+                return false;
+            }
+            pos_ += skipped.length;
+        }
+        if (pos_ >= size) return false;
+        
+        size_t game_start = pos_;
+        game.offset = base_offset_ + game_start;
+        
+        // Tag section: consecutive lines that begin with '['.
+        TagLine lines[32];
+        for (;;) {
+            TagSectionScan tags = scan_tag_lines(base + pos_, size - pos_, lines, 32);
+            for (size_t i = 0; i < tags.lines; ++i) {
+                read_tag_line(base + pos_, lines[i], tags_, game);
+            }
+            pos_ += tags.length;
+            
+            if (tags.stop == TagScanStop::lines_full) continue;
+            if (tags.stop == TagScanStop::end_of_tags || pos_ >= size) break;
+            
+            // The input ends inside a tag line.
+            if (!input_complete_) {
+                pos_ = game_start;
+                return false;
+            }
+            LineScan last = scan_line(base + pos_, size - pos_);
+            read_tag_line(base + pos_, TagLine{0, last.length, last.last_quote}, tags_, game);
+            pos_ = size;
+            break;
+        }
+        
+        bool keep = !filter_ || filter_->matches_tags(game);
+        
+        // Movetext: everything up to the next line that begins with '['.
+        MovetextScan moves = scan_movetext(base + pos_, size - pos_);
+        if (!moves.found_tag_line && !input_complete_) {
+            pos_ = game_start;
+            return false;
+        }
+        game.movetext = text_.substr(pos_, moves.length);
+        game.move_count = moves.dots;
+        pos_ += moves.length;
+        metrics::add(metrics::games);
+        metrics::add(metrics::bytes_read, pos_ - game_start);
+        if (keep && replay_) replay_game(game);
+        
+        if (keep && (!filter_ || filter_->matches_rest(game))) return true;
+    }
+}
+
+size_t find_game_start(std::string_view text, size_t from) {
+    static constexpr std::string_view marker = "\n[Event \"";
+    
+    size_t pos = from == 0 ? 0 : from - 1;
+    if (pos == 0 && text.substr(0, marker.size() - 1) == marker.substr(1)) {
+        return 0;
+    }
+    
+    while ((pos = text.find(marker, pos)) != std::string_view::npos) {
+        size_t line_end = pos;
+        if (line_end > 0 && text[line_end - 1] == '\r') line_end--;
+        size_t prev_start = text.rfind('\n', pos == 0 ? 0 : pos - 1);
+        prev_start = (prev_start == std::string_view::npos || prev_start >= pos) ? 0 : prev_start + 1;
+        
+        bool prev_is_tag = line_end > prev_start && text[prev_start] == '[';
+        if (!prev_is_tag) {
+            return pos + 1;
+        }
+        pos += marker.size();
+    }
+    
+    return text.size();
+}
+
+} // namespace pgn
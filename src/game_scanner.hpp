@@ -0,0 +1,67 @@
+#pragma once
+#include "pgn/query.hpp"
+#include "pgn/types.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace pgn {
+
+// Splits PGN text into games without copying. A game starts at the first
+// tag line that follows a blank line or movetext and runs until the next
+// such tag line; the returned views slice directly into the input.
+//
+// When the input is only a prefix of the stream (input_complete is false),
+// a game that runs into the end of the text is held back: next() returns
+// false and position() is left at that game's first line, so the caller
+// can append more data and rescan from there.
+//
+// Game offsets are reported relative to `base_offset`, the position of the
+// text in the file. With a filter set, games that fail it are skipped as
+// soon as their tag section has been read, without a view being returned.
+class GameScanner {
+public:
+    GameScanner() = default;
+    explicit GameScanner(std::string_view text, bool input_complete = true,
+                         uint64_t base_offset = 0)
+        : text_(text), input_complete_(input_complete), base_offset_(base_offset) {}
+    
+    void reset(std::string_view text, bool input_complete = true, uint64_t base_offset = 0) {
+        text_ = text;
+        input_complete_ = input_complete;
+        base_offset_ = base_offset;
+        pos_ = 0;
+    }
+    
+    // `filter` must outlive the scanner; nullptr returns every game.
+    void set_filter(const Query* filter) { filter_ = filter; }
+    
+    // Replay each game's moves to count them and check their legality.
+    void set_replay(bool replay) { replay_ = replay; }
+    
+    // Keep only the tags whose TagKind bit is set in `tags`; the others are
+    // read past and left empty in the returned views.
+    void set_tags(uint32_t tags) { tags_ = tags; }
+    
+    bool next(GameView& game);
+    
+    size_t position() const { return pos_; }
+    bool at_end() const { return pos_ >= text_.size(); }
+    
+private:
+    std::string_view text_;
+    bool input_complete_ = true;
+    uint64_t base_offset_ = 0;
+    const Query* filter_ = nullptr;
+    bool replay_ = false;
+    uint32_t tags_ = ~uint32_t(0);
+    size_t pos_ = 0;
+};
+
+// Returns the offset of the first game start at or after `from` whose tag
+// section opens with an Event tag, or text.size() if there is none. Only
+// tag lines preceded by a blank line or movetext count, so scanning from
+// the returned offset yields exactly the games a scan from 0 would.
+size_t find_game_start(std::string_view text, size_t from);
+
+} // namespace pgn
@@ -0,0 +1,350 @@
+#include "pgn/game_table.hpp"
+#include <array>
+#include <string>
+
+namespace pgn {
+
+namespace {
+
+constexpr uint64_t low_bits = 0x5555555555555555ull;
+
+bool all_digits(std::string_view text) {
+    for (char c : text) {
+        if (c < '0' || c > '9') return false;
+    }
+    return true;
+}
+
+bool all_unknown(std::string_view text) {
+    return text.find_first_not_of('?') == std::string_view::npos;
+}
+
+int to_int(std::string_view digits) {
+    int value = 0;
+    for (char c : digits) value = value * 10 + (c - '0');
+    return value;
+}
+
+void append_padded(std::string& out, int value, int width) {
+    char digits[8];
+    for (int i = width - 1; i >= 0; --i) {
+        digits[i] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    }
+    out.append(digits, width);
+}
+
+std::string eco_text(uint16_t code) {
+    int index = code - 1;
+    std::string text(1, static_cast<char>('A' + index / 100));
+    append_padded(text, index % 100, 2);
+    return text;
+}
+
+// Counts the 2-bit codes in `word`, ignoring slots not set in `mask`
+// (a mask of low bits, one per slot).
+void count_word(uint64_t word, uint64_t mask, GameTable::ResultCounts& counts) {
+    uint64_t low = word & mask;
+    uint64_t high = (word >> 1) & mask;
+    size_t white = __builtin_popcountll(low & ~high);
+    size_t black = __builtin_popcountll(high & ~low);
+    size_t draws = __builtin_popcountll(low & high);
+    counts.white_wins += white;
+    counts.black_wins += black;
+    counts.draws += draws;
+    counts.unknown += __builtin_popcountll(mask) - white - black - draws;
+}
+
+} // namespace
+
+GameResult parse_result(std::string_view text) {
+    if (text == "1-0") return GameResult::white_win;
+    if (text == "0-1") return GameResult::black_win;
+    if (text == "1/2-1/2") return GameResult::draw;
+    return GameResult::unknown;
+}
+
+std::string_view result_text(GameResult result) {
+    switch (result) {
+        case GameResult::white_win: return "1-0";
+        case GameResult::black_win: return "0-1";
+        case GameResult::draw: return "1/2-1/2";
+        default: return "*";
+    }
+}
+
+std::string date_text(uint32_t date) {
+    std::string text;
+    text.reserve(10);
+    int year = date_year(date);
+    int month = date_month(date);
+    int day = date_day(date);
+    if (year < 0) text += "????"; else append_padded(text, year, 4);
+    text += '.';
+    if (month == 0) text += "??"; else append_padded(text, month, 2);
+    text += '.';
+    if (day == 0) text += "??"; else append_padded(text, day, 2);
+    return text;
+}
+
+uint16_t encode_elo(std::string_view text) {
+    if (text.empty()) return 0;
+    if (text.size() > 5 || text[0] == '0' || !all_digits(text)) return raw_elo;
+    int value = to_int(text);
+    return value < raw_elo ? static_cast<uint16_t>(value) : raw_elo;
+}
+
+uint32_t encode_date(std::string_view text) {
+    if (text.empty()) return 0;
+    if (text.size() != 10 || text[4] != '.' || text[7] != '.') return raw_date;
+    
+    std::string_view parts[3] = {text.substr(0, 4), text.substr(5, 2), text.substr(8, 2)};
+    int values[3];
+    for (int i = 0; i < 3; ++i) {
+        if (all_unknown(parts[i])) values[i] = -1;
+        else if (all_digits(parts[i])) values[i] = to_int(parts[i]);
+        else return raw_date;
+    }
+    
+    int year = values[0], month = values[1], day = values[2];
+    if (month == 0 || month > 12 || day == 0 || day > 31) return raw_date;
+    return 1u << 31 | uint32_t(year + 1) << 9 | uint32_t(month < 0 ? 0 : month) << 5 |
+           uint32_t(day < 0 ? 0 : day);
+}
+
+uint16_t encode_eco(std::string_view text) {
+    if (text.empty()) return 0;
+    if (text.size() != 3 || text[0] < 'A' || text[0] > 'E' || !all_digits(text.substr(1))) {
+        return raw_eco;
+    }
+    return static_cast<uint16_t>(1 + (text[0] - 'A') * 100 + to_int(text.substr(1)));
+}
+
+Symbol eco_symbol(uint16_t code) {
+    static const std::array<Symbol, 501> symbols = [] {
+        std::array<Symbol, 501> table{};
+        for (uint16_t code = 1; code < table.size(); ++code) {
+            table[code] = intern(eco_text(code));
+        }
+        return table;
+    }();
+    return code < symbols.size() ? symbols[code] : Symbol();
+}
+
+void GameTable::clear() {
+    *this = GameTable{};
+}
+
+void GameTable::reserve(size_t games) {
+    events_.reserve(games);
+    sites_.reserve(games);
+    rounds_.reserve(games);
+    whites_.reserve(games);
+    blacks_.reserve(games);
+    openings_.reserve(games);
+    dates_.reserve(games);
+    white_elos_.reserve(games);
+    black_elos_.reserve(games);
+    eco_codes_.reserve(games);
+    move_counts_.reserve(games);
+    offsets_.reserve(games);
+    results_.reserve((games + 31) / 32);
+}
+
+void GameTable::append(const GameView& game) {
+    size_t row = size();
+    
+    auto keep_raw = [&](Field field, std::string_view text) {
+        raw_.emplace(raw_key(row, field), intern(text));
+    };
+    
+    events_.push_back(intern(game.event));
+    sites_.push_back(intern(game.site));
+    rounds_.push_back(intern(game.round));
+    whites_.push_back(intern(game.white));
+    blacks_.push_back(intern(game.black));
+    openings_.push_back(intern(game.opening));
+    
+    uint32_t date = encode_date(game.date);
+    if (date == raw_date) keep_raw(date_field, game.date);
+    dates_.push_back(date);
+    
+    uint16_t white_elo = encode_elo(game.white_elo);
+    if (white_elo == raw_elo) keep_raw(white_elo_field, game.white_elo);
+    white_elos_.push_back(white_elo);
+    
+    uint16_t black_elo = encode_elo(game.black_elo);
+    if (black_elo == raw_elo) keep_raw(black_elo_field, game.black_elo);
+    black_elos_.push_back(black_elo);
+    
+    uint16_t eco = encode_eco(game.eco);
+    if (eco == raw_eco) keep_raw(eco_field, game.eco);
+    eco_codes_.push_back(eco);
+    
+    GameResult result = parse_result(game.result);
+    if (result == GameResult::unknown && game.result != "*") keep_raw(result_field, game.result);
+    if (row % 32 == 0) results_.push_back(0);
+    results_.back() |= uint64_t(result) << (row % 32 * 2);
+    
+    move_counts_.push_back(game.move_count);
+    offsets_.push_back(game.offset);
+}
+
+void GameTable::append(const GameTable& other) {
+    size_t base = size();
+    
+    auto extend = [](auto& column, const auto& source) {
+        column.insert(column.end(), source.begin(), source.end());
+    };
+    extend(events_, other.events_);
+    extend(sites_, other.sites_);
+    extend(rounds_, other.rounds_);
+    extend(whites_, other.whites_);
+    extend(blacks_, other.blacks_);
+    extend(openings_, other.openings_);
+    extend(dates_, other.dates_);
+    extend(white_elos_, other.white_elos_);
+    extend(black_elos_, other.black_elos_);
+    extend(eco_codes_, other.eco_codes_);
+    extend(move_counts_, other.move_counts_);
+    extend(offsets_, other.offsets_);
+    
+    if (base % 32 == 0) {
+        extend(results_, other.results_);
+    } else {
+        for (size_t i = 0; i < other.size(); ++i) {
+            size_t row = base + i;
+            if (row % 32 == 0) results_.push_back(0);
+            results_.back() |= uint64_t(other.result(i)) << (row % 32 * 2);
+        }
+    }
+    
+    for (const auto& [key, text] : other.raw_) {
+        raw_.emplace(key + base * field_count, text);
+    }
+}
+
+void GameTable::assign(Columns&& columns) {
+    events_ = std::move(columns.events);
+    sites_ = std::move(columns.sites);
+    rounds_ = std::move(columns.rounds);
+    whites_ = std::move(columns.whites);
+    blacks_ = std::move(columns.blacks);
+    openings_ = std::move(columns.openings);
+    dates_ = std::move(columns.dates);
+    white_elos_ = std::move(columns.white_elos);
+    black_elos_ = std::move(columns.black_elos);
+    eco_codes_ = std::move(columns.eco_codes);
+    move_counts_ = std::move(columns.move_counts);
+    offsets_ = std::move(columns.offsets);
+    results_ = std::move(columns.results);
+    raw_ = std::move(columns.raw);
+}
+
+Symbol GameTable::raw_symbol(size_t row, Field field) const {
+    auto it = raw_.find(raw_key(row, field));
+    return it != raw_.end() ? it->second : Symbol();
+}
+
+std::string GameTable::raw_text(size_t row, Field field) const {
+    return std::string(raw_symbol(row, field).str());
+}
+
+Symbol GameTable::eco(size_t index) const {
+    uint16_t code = eco_codes_[index];
+    if (code != raw_eco) return eco_symbol(code);
+    auto it = raw_.find(raw_key(index, eco_field));
+    return it != raw_.end() ? it->second : Symbol();
+}
+
+Game GameTable::row(size_t index) const {
+    auto elo_text = [&](uint16_t elo, Field field) {
+        if (elo == 0) return std::string();
+        if (elo == raw_elo) return raw_text(index, field);
+        return std::to_string(elo);
+    };
+    
+    uint32_t date = dates_[index];
+    GameResult result = this->result(index);
+    std::string result_string = std::string(result_text(result));
+    if (result == GameResult::unknown && raw_.count(raw_key(index, result_field))) {
+        result_string = raw_text(index, result_field);
+    }
+    
+    return Game{events_[index], sites_[index],
+                date == 0 ? std::string() : date == raw_date ? raw_text(index, date_field) : date_text(date),
+                std::string(rounds_[index].str()), whites_[index], blacks_[index],
+                std::move(result_string),
+                elo_text(white_elos_[index], white_elo_field),
+                elo_text(black_elos_[index], black_elo_field),
+                eco(index), openings_[index], move_counts_[index]};
+}
+
+GameView GameTable::view(size_t index, std::unordered_map<uint32_t, std::string>& formatted) const {
+    // Packed dates have bit 31 set and ratings fit in 16 bits, so both
+    // share `formatted` without clashing.
+    auto elo_text = [&](uint16_t elo, Field field) -> std::string_view {
+        if (elo == 0) return {};
+        if (elo == raw_elo) return raw_symbol(index, field).str();
+        auto it = formatted.find(elo);
+        if (it == formatted.end()) it = formatted.emplace(elo, std::to_string(elo)).first;
+        return it->second;
+    };
+    
+    GameView game;
+    game.event = events_[index].str();
+    game.site = sites_[index].str();
+    game.round = rounds_[index].str();
+    game.white = whites_[index].str();
+    game.black = blacks_[index].str();
+    game.opening = openings_[index].str();
+    game.eco = eco(index).str();
+    
+    uint32_t date = dates_[index];
+    if (date == raw_date) {
+        game.date = raw_symbol(index, date_field).str();
+    } else if (date != 0) {
+        auto it = formatted.find(date);
+        if (it == formatted.end()) it = formatted.emplace(date, date_text(date)).first;
+        game.date = it->second;
+    }
+    game.white_elo = elo_text(white_elos_[index], white_elo_field);
+    game.black_elo = elo_text(black_elos_[index], black_elo_field);
+    
+    GameResult result = this->result(index);
+    auto raw_result = raw_.find(raw_key(index, result_field));
+    game.result = result == GameResult::unknown && raw_result != raw_.end()
+                      ? raw_result->second.str() : result_text(result);
+    
+    game.move_count = move_counts_[index];
+    game.offset = offsets_[index];
+    return game;
+}
+
+GameTable::ResultCounts GameTable::count_results(size_t begin, size_t end) const {
+    ResultCounts counts;
+    if (begin >= end) return counts;
+    
+    size_t first_word = begin / 32;
+    size_t last_word = (end - 1) / 32;
+    for (size_t w = first_word; w <= last_word; ++w) {
+        uint64_t mask = low_bits;
+        if (w == first_word) mask &= low_bits << (begin % 32 * 2);
+        if (w == last_word && end % 32 != 0) mask &= low_bits >> ((32 - end % 32) * 2);
+        count_word(results_[w], mask, counts);
+    }
+    return counts;
+}
+
+size_t GameTable::memory_usage() const {
+    size_t symbols = events_.capacity() + sites_.capacity() + rounds_.capacity() +
+                     whites_.capacity() + blacks_.capacity() + openings_.capacity();
+    return symbols * sizeof(Symbol) +
+           dates_.capacity() * sizeof(uint32_t) +
+           (white_elos_.capacity() + black_elos_.capacity() + eco_codes_.capacity()) * sizeof(uint16_t) +
+           move_counts_.capacity() * sizeof(int) +
+           (offsets_.capacity() + results_.capacity()) * sizeof(uint64_t) +
+           raw_.size() * (sizeof(uint64_t) + sizeof(Symbol) + 2 * sizeof(void*));
+}
+
+} // namespace pgn
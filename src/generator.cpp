@@ -0,0 +1,311 @@
+#include "pgn/generator.hpp"
+#include "pgn/position.hpp"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+
+namespace pgn {
+
+namespace {
+
+constexpr const char* first_names[] = {
+    "Anna", "Boris", "Carlos", "Dmitri", "Elena", "Farid", "Grace", "Hikaru",
+    "Irina", "Jonas", "Kateryna", "Luis", "Magnus", "Nodira", "Oscar", "Pia",
+    "Quang", "Rafael", "Sofia", "Tigran", "Ursula", "Viktor", "Wei", "Yasmin"};
+
+constexpr const char* cities[] = {
+    "Amsterdam", "Baku", "Berlin", "Biel", "Budapest", "Chennai", "Dortmund", "Gibraltar",
+    "Hastings", "Linares", "London", "Madrid", "Moscow", "Novi Sad", "Paris", "Prague",
+    "Reykjavik", "Riga", "Saint Louis", "Shenzhen", "Sochi", "Stavanger", "Tbilisi", "Wijk aan Zee"};
+
+constexpr const char* event_kinds[] = {
+    "Open", "Championship", "Rapid", "Blitz", "Invitational", "Masters", "Cup", "Festival"};
+
+constexpr int days_in_month[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+
+uint64_t mix(uint64_t value) {
+    value += 0x9E3779B97F4A7C15ull;
+    value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+    value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+    return value ^ (value >> 31);
+}
+
+// splitmix64; small, fast and good enough for synthetic data.
+class Random {
+public:
+    explicit Random(uint64_t seed) : state_(seed) {}
+    
+    uint64_t next() { return mix(state_++); }
+    uint64_t below(uint64_t bound) { return bound ? next() % bound : 0; }
+    double uniform() { return (next() >> 11) * (1.0 / 9007199254740992.0); }
+    
+    double normal() {
+        double u = std::max(uniform(), 1e-12);
+        return std::sqrt(-2.0 * std::log(u)) * std::cos(6.283185307179586 * uniform());
+    }
+    
+private:
+    uint64_t state_;
+};
+
+// Surnames spell the player's index in consonant-vowel syllables followed
+// by an optional closing consonant, so distinct players never share one.
+std::string player_name(uint64_t index, uint64_t seed) {
+    static const char consonants[] = "bdgklmnrstvz";
+    static const char vowels[] = "aeiou";
+    static const char* endings[] = {"", "n", "v", "r", "s", "k"};
+    
+    std::string name;
+    for (uint64_t digits = index + 60; digits; digits /= 60) {
+        name += consonants[digits % 60 / 5];
+        name += vowels[digits % 5];
+    }
+    uint64_t hash = mix(index ^ seed);
+    name += endings[hash % 6];
+    name[0] = static_cast<char>(name[0] - 'a' + 'A');
+    return name + ", " + first_names[(hash >> 8) % 24];
+}
+
+std::string event_name(uint64_t index) {
+    const uint64_t per_year = 24 * 8;
+    std::string name = std::string(cities[index % 24]) + " " + event_kinds[index / 24 % 8] + " " +
+                       std::to_string(2000 + index / per_year % 26);
+    if (index >= per_year * 26) name += " " + std::to_string(index / (per_year * 26) + 1);
+    return name;
+}
+
+void append_date(std::string& out, int year, int day) {
+    int month = 0;
+    while (month < 11 && day >= days_in_month[month]) day -= days_in_month[month++];
+    out += std::to_string(year);
+    out += month < 9 ? ".0" : ".";
+    out += std::to_string(month + 1);
+    out += day < 9 ? ".0" : ".";
+    out += std::to_string(day + 1);
+}
+
+struct Line {
+    std::string movetext;
+    std::string eco;
+    // Length of the last text line, to decide where the result goes.
+    size_t column = 0;
+};
+
+// Opening preference: pawn and minor piece moves toward the centre first,
+// ties broken by the position key so each position has a fixed favourite.
+uint64_t book_rank(const Position& position, uint64_t key, const Move& move) {
+    static const int piece_bonus[] = {3, 3, 2, -2, -4, -6};
+    int file = move.to % 8;
+    int rank = move.to / 8;
+    int centre = 6 - std::max(std::abs(2 * file - 7), std::abs(2 * rank - 7));
+    int score = 8 + centre + piece_bonus[int(position.piece_on(move.from))];
+    return uint64_t(score) << 56 | (mix(key ^ (move.from | move.to << 6)) >> 8);
+}
+
+// Plays a random legal game. The first plies pick among the few moves a
+// position's book_rank() puts highest, so lines share openings and
+// transpose the way real games do; later plies are uniform.
+Line play_line(Random& random) {
+    Line line;
+    Position position;
+    int plies = std::clamp(static_cast<int>(80 + 30 * random.normal()), 10, 200);
+    size_t& column = line.column;
+    
+    for (int ply = 0; ply < plies; ++ply) {
+        MoveList moves;
+        position.legal_moves(moves);
+        if (moves.size() == 0) break;
+        
+        size_t choice = random.below(moves.size());
+        if (ply < 12) {
+            uint64_t key = position.hash();
+            Move* begin = moves.moves;
+            Move* end = moves.moves + moves.size();
+            std::sort(begin, end, [&](const Move& a, const Move& b) {
+                return book_rank(position, key, a) > book_rank(position, key, b);
+            });
+            // Weights 8:4:2:1 over the top four moves.
+            uint64_t roll = random.below(15);
+            choice = std::min<size_t>(roll < 8 ? 0 : roll < 12 ? 1 : roll < 14 ? 2 : 3, moves.size() - 1);
+        }
+        
+        const Move& move = moves.moves[choice];
+        std::string token = position.san(move);
+        if (position.side_to_move() == Color::white) {
+            token = std::to_string(position.fullmove_number()) + ". " + token;
+        }
+        if (column + token.size() + 1 > 79) {
+            line.movetext += '\n';
+            column = 0;
+        } else if (column > 0) {
+            line.movetext += ' ';
+            column++;
+        }
+        line.movetext += token;
+        column += token.size();
+        position.play(move);
+        
+        if (ply == 5) {
+            uint64_t code = position.hash() % 500;
+            line.eco = std::string(1, static_cast<char>('A' + code / 100)) +
+                       static_cast<char>('0' + code / 10 % 10) + static_cast<char>('0' + code % 10);
+        }
+    }
+    if (line.eco.empty()) line.eco = "A00";
+    return line;
+}
+
+} // namespace
+
+struct GameGenerator::Impl {
+    GeneratorOptions options;
+    Random random;
+    std::vector<Line> lines;
+    uint64_t produced = 0;
+    
+    // The event run in progress.
+    uint64_t run = 0;
+    uint64_t run_left = 0;
+    uint64_t run_game = 0;
+    uint64_t boards = 1;
+    uint64_t event = 0;
+    int year = 2000;
+    int first_day = 0;
+    
+    explicit Impl(const GeneratorOptions& opts) : options(opts), random(mix(opts.seed)) {
+        uint64_t games = std::max<uint64_t>(options.games, 1);
+        if (options.players == 0) {
+            options.players = static_cast<uint32_t>(std::clamp<uint64_t>(games / 10, 100, 5000000));
+        }
+        if (options.events == 0) {
+            options.events = static_cast<uint32_t>(std::clamp<uint64_t>(games / 300, 1, 1000000));
+        }
+        if (options.lines == 0) {
+            options.lines = static_cast<uint32_t>(std::min<uint64_t>(games, 4096));
+        }
+        options.players = std::max<uint32_t>(options.players, 2);
+        
+        Random line_random(mix(options.seed ^ 0x6C696E6573ull));
+        lines.reserve(options.lines);
+        for (uint32_t i = 0; i < options.lines; ++i) lines.push_back(play_line(line_random));
+    }
+    
+    // A few players play most of the games.
+    uint64_t pick_player() {
+        double u = random.uniform();
+        return static_cast<uint64_t>(options.players * u * u) % options.players;
+    }
+    
+    // Each player has a fixed strength and a trend over the span of the
+    // file; individual games add a little noise.
+    int rating(uint64_t player, double progress) {
+        Random own(mix(player ^ options.seed));
+        double base = 1850 + 280 * own.normal();
+        double trend = 150 * own.normal();
+        double value = base + trend * (progress - 0.5) + 15 * random.normal();
+        return static_cast<int>(std::clamp(value, 800.0, 2900.0));
+    }
+    
+    void start_run() {
+        uint64_t average = std::max<uint64_t>(options.games / options.events, 1);
+        run_left = 1 + random.below(2 * average);
+        run_game = 0;
+        boards = 1 + random.below(std::min<uint64_t>(run_left, 64));
+        event = run % options.events;
+        year = 2000 + static_cast<int>(25 * produced / std::max<uint64_t>(options.games, 1));
+        first_day = static_cast<int>(random.below(330));
+        run++;
+    }
+    
+    void append_game(std::string& out) {
+        if (run_left == 0) start_run();
+        double progress = static_cast<double>(produced) / std::max<uint64_t>(options.games, 1);
+        uint64_t round = run_game / boards;
+        run_left--;
+        run_game++;
+        
+        uint64_t white = pick_player();
+        uint64_t black = pick_player();
+        if (black == white) black = (white + 1 + random.below(options.players - 1)) % options.players;
+        int white_elo = rating(white, progress);
+        int black_elo = rating(black, progress);
+        
+        // Draws grow more common with strength and with evenly matched players.
+        double expected = 1.0 / (1.0 + std::pow(10.0, (black_elo - white_elo) / 400.0));
+        double strength = std::clamp((white_elo + black_elo) / 2.0 - 1200, 0.0, 1600.0) / 1600;
+        double draw = (0.1 + 0.35 * strength) * (1 - std::fabs(2 * expected - 1));
+        double roll = random.uniform();
+        const char* result = roll < 0.002 ? "*" :
+                             roll < expected - draw / 2 ? "1-0" :
+                             roll < expected + draw / 2 ? "1/2-1/2" : "0-1";
+        
+        const Line& line = lines[random.below(lines.size())];
+        
+        out += "[Event \"";
+        out += event_name(event);
+        out += "\"]\n[Site \"";
+        out += cities[event % 24];
+        out += "\"]\n[Date \"";
+        append_date(out, year, std::min<int>(first_day + static_cast<int>(round), 364));
+        out += "\"]\n[Round \"";
+        out += std::to_string(round + 1);
+        out += "\"]\n[White \"";
+        out += player_name(white, options.seed);
+        out += "\"]\n[Black \"";
+        out += player_name(black, options.seed);
+        out += "\"]\n[Result \"";
+        out += result;
+        out += "\"]\n";
+        // Some sources leave ratings out.
+        if (random.below(100) >= 3) {
+            out += "[WhiteElo \"";
+            out += std::to_string(white_elo);
+            out += "\"]\n[BlackElo \"";
+            out += std::to_string(black_elo);
+            out += "\"]\n";
+        }
+        out += "[ECO \"";
+        out += line.eco;
+        out += "\"]\n\n";
+        out += line.movetext;
+        out += line.column > 70 ? '\n' : ' ';
+        out += result;
+        out += "\n\n";
+    }
+};
+
+GameGenerator::GameGenerator(const GeneratorOptions& options)
+    : pimpl(std::make_unique<Impl>(options)) {}
+
+GameGenerator::~GameGenerator() = default;
+
+bool GameGenerator::next(std::string& out) {
+    if (pimpl->produced >= pimpl->options.games) return false;
+    pimpl->append_game(out);
+    pimpl->produced++;
+    return true;
+}
+
+void GameGenerator::write(std::ostream& out) {
+    std::string buffer;
+    buffer.reserve(1 << 20);
+    while (next(buffer)) {
+        if (buffer.size() >= (1 << 20) - 4096) {
+            out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+            buffer.clear();
+        }
+    }
+    out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+}
+
+void GameGenerator::write_file(const std::string& filename) {
+    std::ofstream out(filename, std::ios::binary);
+    if (!out.is_open()) throw std::runtime_error("Cannot open file: " + filename);
+    write(out);
+    out.flush();
+    if (!out) throw std::runtime_error("Cannot write file: " + filename);
+}
+
+} // namespace pgn
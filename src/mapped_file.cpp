@@ -0,0 +1,133 @@
+#include "mapped_file.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace pgn {
+
+#ifdef _WIN32
+
+void MappedFile::open(const std::string& filename) {
+    close();
+    
+    HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                              OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        throw std::runtime_error("Cannot open file: " + filename);
+    }
+    
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file, &file_size)) {
+        CloseHandle(file);
+        throw std::runtime_error("Cannot stat file: " + filename);
+    }
+    
+    file_handle_ = file;
+    open_ = true;
+    size_ = static_cast<size_t>(file_size.QuadPart);
+    if (size_ == 0) return;
+    
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping == nullptr) {
+        close();
+        throw std::runtime_error("Cannot map file: " + filename);
+    }
+    mapping_handle_ = mapping;
+    
+    data_ = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    if (data_ == nullptr) {
+        close();
+        throw std::runtime_error("Cannot map file: " + filename);
+    }
+}
+
+void MappedFile::discard_before(size_t offset) {
+    if (!data_ || offset == 0) return;
+    
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    size_t length = offset / info.dwPageSize * info.dwPageSize;
+    if (length > 0) {
+        // Pages of a read-only file view are clean; unlocking them lets the
+        // memory manager trim them from the working set first.
+        VirtualUnlock(const_cast<char*>(data_), length);
+    }
+}
+
+void MappedFile::close() {
+    if (data_) UnmapViewOfFile(data_);
+    if (mapping_handle_) CloseHandle(static_cast<HANDLE>(mapping_handle_));
+    if (file_handle_) CloseHandle(static_cast<HANDLE>(file_handle_));
+    data_ = nullptr;
+    mapping_handle_ = nullptr;
+    file_handle_ = nullptr;
+    size_ = 0;
+    open_ = false;
+}
+
+#else
+
+void MappedFile::open(const std::string& filename) {
+    close();
+    
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Cannot open file: " + filename);
+    }
+    
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        ::close(fd);
+        throw std::runtime_error("Cannot map file: " + filename);
+    }
+    
+    open_ = true;
+    size_ = static_cast<size_t>(st.st_size);
+    if (size_ == 0) {
+        ::close(fd);
+        return;
+    }
+    
+    void* addr = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (addr == MAP_FAILED) {
+        size_ = 0;
+        open_ = false;
+        throw std::runtime_error("Cannot map file: " + filename);
+    }
+    
+    madvise(addr, size_, MADV_SEQUENTIAL);
+    data_ = static_cast<const char*>(addr);
+}
+
+void MappedFile::discard_before(size_t offset) {
+    if (!data_ || offset == 0) return;
+    
+    size_t page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    size_t length = std::min(offset, size_) / page_size * page_size;
+    if (length > 0) {
+        madvise(const_cast<char*>(data_), length, MADV_DONTNEED);
+    }
+}
+
+void MappedFile::close() {
+    if (data_) munmap(const_cast<char*>(data_), size_);
+    data_ = nullptr;
+    size_ = 0;
+    open_ = false;
+}
+
+#endif
+
+} // namespace pgn
@@ -0,0 +1,41 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace pgn {
+
+// Read-only memory mapping of a whole file. The mapping is released on
+// destruction or when another file is opened.
+class MappedFile {
+public:
+    MappedFile() = default;
+    explicit MappedFile(const std::string& filename) { open(filename); }
+    ~MappedFile() { close(); }
+    
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    
+    void open(const std::string& filename);
+    void close();
+    
+    // Hints that [0, offset) will not be read again so its pages can be
+    // dropped from the working set. Re-reading it remains valid.
+    void discard_before(size_t offset);
+    
+    const char* data() const { return data_; }
+    size_t size() const { return size_; }
+    std::string_view view() const { return std::string_view(data_, size_); }
+    bool is_open() const { return open_; }
+
+private:
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+    bool open_ = false;
+#ifdef _WIN32
+    void* file_handle_ = nullptr;
+    void* mapping_handle_ = nullptr;
+#endif
+};
+
+} // namespace pgn
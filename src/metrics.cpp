@@ -0,0 +1,172 @@
+#include "metrics_counters.hpp"
+#include "pgn/symbol_table.hpp"
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace pgn {
+
+namespace {
+
+// Every block ever handed out. A thread's block returns to the free list,
+// counts and all, when the thread exits, and the next new thread takes it
+// over; so there are only as many blocks as threads ever ran at once, and
+// no counts are lost.
+struct Registry {
+    std::mutex mutex;
+    std::vector<std::unique_ptr<metrics::Block>> blocks;
+    std::vector<metrics::Block*> free_blocks;
+    std::atomic<double> load_factors[hash_table_count] = {};
+};
+
+// Never destroyed, so threads that exit during shutdown can still return
+// their blocks.
+Registry& registry() {
+    static Registry* instance = new Registry;
+    return *instance;
+}
+
+class CountedHeap : public std::pmr::memory_resource {
+    void* do_allocate(size_t bytes, size_t alignment) override {
+        metrics::add(metrics::arena_allocations);
+        metrics::add(metrics::arena_bytes, bytes);
+        return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    }
+    
+    void do_deallocate(void* memory, size_t bytes, size_t alignment) override {
+        std::pmr::new_delete_resource()->deallocate(memory, bytes, alignment);
+    }
+    
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+};
+
+#ifndef PGN_NO_METRICS
+
+struct BlockLease {
+    metrics::Block* block = nullptr;
+    
+    ~BlockLease() {
+        if (!block) return;
+        Registry& r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        r.free_blocks.push_back(block);
+        metrics::local_block = nullptr;
+    }
+};
+
+thread_local BlockLease lease;
+
+#endif
+
+} // namespace
+
+namespace metrics {
+
+std::pmr::memory_resource* counted_heap() {
+    static CountedHeap heap;
+    return &heap;
+}
+
+void record_load_factor(HashTable table, double load_factor) {
+    if (on()) registry().load_factors[size_t(table)].store(load_factor, std::memory_order_relaxed);
+}
+
+#ifndef PGN_NO_METRICS
+
+std::atomic<bool> enabled{false};
+
+Block* attach_block() {
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    if (r.free_blocks.empty()) {
+        r.blocks.push_back(std::make_unique<Block>());
+        lease.block = r.blocks.back().get();
+    } else {
+        lease.block = r.free_blocks.back();
+        r.free_blocks.pop_back();
+    }
+    local_block = lease.block;
+    return local_block;
+}
+
+#endif
+
+} // namespace metrics
+
+double MetricsSnapshot::games_per_second() const {
+    double seconds = stage(Stage::load).seconds;
+    return seconds > 0 ? games / seconds : 0.0;
+}
+
+double MetricsSnapshot::megabytes_per_second() const {
+    double seconds = stage(Stage::load).seconds;
+    return seconds > 0 ? bytes_read / (1024.0 * 1024.0) / seconds : 0.0;
+}
+
+void enable_metrics(bool enabled) {
+#ifndef PGN_NO_METRICS
+    metrics::enabled.store(enabled, std::memory_order_relaxed);
+#else
+    (void)enabled;
+#endif
+}
+
+bool metrics_enabled() {
+    return metrics::on();
+}
+
+MetricsSnapshot metrics_snapshot() {
+    uint64_t totals[metrics::counter_count] = {};
+    Registry& r = registry();
+    {
+        std::lock_guard<std::mutex> lock(r.mutex);
+        for (const auto& block : r.blocks) {
+            for (size_t i = 0; i < metrics::counter_count; ++i) {
+                totals[i] += block->values[i].load(std::memory_order_relaxed);
+            }
+        }
+    }
+    
+    MetricsSnapshot snapshot;
+    for (size_t i = 0; i < stage_count; ++i) {
+        snapshot.stages[i].calls = totals[metrics::stage_calls + i];
+        snapshot.stages[i].seconds = totals[metrics::stage_nanoseconds + i] * 1e-9;
+    }
+    snapshot.bytes_read = totals[metrics::bytes_read];
+    snapshot.games = totals[metrics::games];
+    for (size_t i = 0; i < tag_kind_count; ++i) {
+        snapshot.tag_lines[i] = totals[metrics::tag_lines + i];
+    }
+    snapshot.arena_allocations = totals[metrics::arena_allocations];
+    snapshot.arena_bytes = totals[metrics::arena_bytes];
+    for (size_t i = 0; i < hash_table_count; ++i) {
+        snapshot.rehashes[i] = totals[metrics::rehashes + i];
+        snapshot.load_factors[i] = r.load_factors[i].load(std::memory_order_relaxed);
+    }
+    if (metrics::on()) {
+        snapshot.load_factors[size_t(HashTable::symbols)] = SymbolTable::global().load_factor();
+    }
+    return snapshot;
+}
+
+// Blocks being written while this runs may keep part of their counts.
+void reset_metrics() {
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    for (const auto& block : r.blocks) {
+        for (auto& value : block->values) value.store(0, std::memory_order_relaxed);
+    }
+    for (auto& load_factor : r.load_factors) load_factor.store(0.0, std::memory_order_relaxed);
+}
+
+namespace detail {
+
+void count_rehash(HashTable table) {
+    metrics::count_rehash(table);
+}
+
+} // namespace detail
+
+} // namespace pgn
@@ -0,0 +1,104 @@
+#pragma once
+#include "pgn/metrics.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+
+namespace pgn {
+namespace metrics {
+
+// Offsets into a thread's block of counters.
+enum Counter : size_t {
+    stage_nanoseconds = 0,
+    stage_calls = stage_nanoseconds + stage_count,
+    bytes_read = stage_calls + stage_count,
+    games,
+    tag_lines,
+    arena_allocations = tag_lines + tag_kind_count,
+    arena_bytes,
+    rehashes,
+    counter_count = rehashes + hash_table_count
+};
+
+struct Block {
+    std::atomic<uint64_t> values[counter_count] = {};
+};
+
+// The upstream of the parsers' arenas: the default heap, with each block
+// it hands out counted.
+std::pmr::memory_resource* counted_heap();
+
+void record_load_factor(HashTable table, double load_factor);
+
+#ifndef PGN_NO_METRICS
+
+extern std::atomic<bool> enabled;
+inline thread_local Block* local_block = nullptr;
+Block* attach_block();
+
+inline bool on() {
+    return enabled.load(std::memory_order_relaxed);
+}
+
+inline void add(size_t counter, uint64_t amount = 1) {
+    if (!on()) return;
+    Block* block = local_block ? local_block : attach_block();
+    // Only this thread writes its block; readers just need untorn values.
+    auto& value = block->values[counter];
+    value.store(value.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+}
+
+// Adds the time from construction to destruction to a stage.
+class StageTimer {
+public:
+    explicit StageTimer(Stage stage) : stage_(stage), running_(on()) {
+        if (running_) start_ = std::chrono::steady_clock::now();
+    }
+    
+    ~StageTimer() {
+        if (!running_) return;
+        auto elapsed = std::chrono::steady_clock::now() - start_;
+        add(stage_nanoseconds + size_t(stage_),
+            std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+        add(stage_calls + size_t(stage_));
+    }
+    
+    StageTimer(const StageTimer&) = delete;
+    StageTimer& operator=(const StageTimer&) = delete;
+    
+private:
+    Stage stage_;
+    bool running_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+#else
+
+inline bool on() { return false; }
+inline void add(size_t, uint64_t = 1) {}
+
+class StageTimer {
+public:
+    explicit StageTimer(Stage) {}
+};
+
+#endif
+
+inline void count_tag(TagKind kind) {
+    add(tag_lines + size_t(kind));
+}
+
+inline void count_rehash(HashTable table) {
+    add(rehashes + size_t(table));
+}
+
+// Counts a rehash if inserting into `container` changed its bucket count.
+template <typename Container>
+void note_buckets(const Container& container, size_t buckets_before, HashTable table) {
+    if (container.bucket_count() != buckets_before) count_rehash(table);
+}
+
+} // namespace metrics
+} // namespace pgn
@@ -0,0 +1,108 @@
+#include "pgn/movetext.hpp"
+
+namespace pgn {
+
+namespace {
+
+bool is_space(char c) {
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+bool ends_token(char c) {
+    return is_space(c) || c == '{' || c == '}' || c == '(' || c == ')' || c == ';' || c == '$';
+}
+
+bool is_result(std::string_view token) {
+    return token == "1-0" || token == "0-1" || token == "1/2-1/2" || token == "*";
+}
+
+} // namespace
+
+bool MovetextTokenizer::next(std::string_view& san) {
+    size_t size = text_.size();
+    while (pos_ < size) {
+        char c = text_[pos_];
+        if (is_space(c)) {
+            pos_++;
+            continue;
+        }
+        
+        switch (c) {
+        case '{': {
+            size_t close = text_.find('}', pos_ + 1);
+            pos_ = close == std::string_view::npos ? size : close + 1;
+            continue;
+        }
+        case ';':
+        case '%': {
+            // Rest-of-line comment; '%' escapes only count at a line start.
+            if (c == '%' && pos_ > 0 && text_[pos_ - 1] != '\n') break;
+            size_t newline = text_.find('\n', pos_ + 1);
+            pos_ = newline == std::string_view::npos ? size : newline + 1;
+            continue;
+        }
+        case '(':
+            depth_++;
+            pos_++;
+            continue;
+        case ')':
+            if (depth_ > 0) depth_--;
+            pos_++;
+            continue;
+        case '$':
+            pos_++;
+            while (pos_ < size && text_[pos_] >= '0' && text_[pos_] <= '9') pos_++;
+            continue;
+        case '}':
+            pos_++;
+            continue;
+        default:
+            break;
+        }
+        
+        size_t start = pos_;
+        while (pos_ < size && !ends_token(text_[pos_])) pos_++;
+        std::string_view token = text_.substr(start, pos_ - start);
+        if (depth_ > 0) continue;
+        if (is_result(token)) {
+            pos_ = size;
+            return false;
+        }
+        
+        // Move numbers, possibly run together with the move ("12.Nf3").
+        if (token[0] >= '0' && token[0] <= '9' && token.substr(0, 3) != "0-0") {
+            size_t digits = token.find_first_not_of("0123456789");
+            if (digits == std::string_view::npos || token[digits] != '.') {
+                san = token;
+                return true;
+            }
+            token.remove_prefix(digits);
+        }
+        size_t dots = token.find_first_not_of('.');
+        if (dots == std::string_view::npos) continue;
+        token.remove_prefix(dots);
+        
+        san = token;
+        return true;
+    }
+    return false;
+}
+
+ReplayResult replay_movetext(std::string_view movetext, Position& position) {
+    ReplayResult result;
+    MovetextTokenizer tokens(movetext);
+    std::string_view san;
+    Move move;
+    while (tokens.next(san)) {
+        if (!position.parse_san(san, move)) {
+            result.valid = false;
+            result.error_offset = static_cast<size_t>(san.data() - movetext.data());
+            break;
+        }
+        position.play(move);
+        result.plies++;
+    }
+    return result;
+}
+
+} // namespace pgn
@@ -0,0 +1,267 @@
+#include "pgn/opening_tree.hpp"
+#include "pgn/movetext.hpp"
+#include "metrics_counters.hpp"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+namespace pgn {
+
+namespace {
+
+constexpr char tree_magic[8] = {'P', 'G', 'N', 'T', 'R', 'E', 'E', '1'};
+constexpr uint32_t tree_version = 1;
+constexpr uint32_t byte_order_mark = 0x01020304;
+
+// Key 0 marks empty slots, so a position that hashes to 0 is stored as 1.
+uint64_t stored_key(uint64_t key) {
+    return key ? key : 1;
+}
+
+size_t hash_slot(uint64_t key, size_t mask) {
+    return static_cast<size_t>((key ^ (key >> 32)) & mask);
+}
+
+template <typename T>
+void write_pod(std::ofstream& out, const T* data, size_t count) {
+    out.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(count * sizeof(T)));
+}
+
+template <typename T>
+void read_pod(std::ifstream& in, T* data, size_t count, const std::string& filename) {
+    in.read(reinterpret_cast<char*>(data), static_cast<std::streamsize>(count * sizeof(T)));
+    if (!in) throw std::runtime_error("Truncated opening tree: " + filename);
+}
+
+} // namespace
+
+void OpeningTree::Counts::add(GameResult result) {
+    games++;
+    switch (result) {
+    case GameResult::white_win: white_wins++; break;
+    case GameResult::black_win: black_wins++; break;
+    case GameResult::draw: draws++; break;
+    default: break;
+    }
+}
+
+void OpeningTree::Counts::add(const Counts& other) {
+    games += other.games;
+    white_wins += other.white_wins;
+    draws += other.draws;
+    black_wins += other.black_wins;
+}
+
+OpeningTree::OpeningTree(int max_plies) : max_plies_(max_plies) {}
+
+size_t OpeningTree::memory_usage() const {
+    return nodes_.capacity() * sizeof(Node) + edges_.capacity() * sizeof(Edge);
+}
+
+uint16_t OpeningTree::encode_move(const Move& move) {
+    unsigned promotion = move.kind == Move::promotion ? unsigned(move.promoted) : 0;
+    return static_cast<uint16_t>(move.from | move.to << 6 | promotion << 12);
+}
+
+bool OpeningTree::decode_move(const Position& position, uint16_t code, Move& move) {
+    MoveList moves;
+    position.legal_moves(moves);
+    for (const Move& candidate : moves) {
+        if (encode_move(candidate) == code) {
+            move = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+size_t OpeningTree::slot_of(uint64_t key) const {
+    size_t mask = nodes_.size() - 1;
+    size_t slot = hash_slot(key, mask);
+    while (nodes_[slot].key != key && nodes_[slot].key != 0) slot = (slot + 1) & mask;
+    return slot;
+}
+
+size_t OpeningTree::insert(uint64_t key) {
+    if (nodes_.empty()) grow();
+    size_t slot = slot_of(key);
+    if (nodes_[slot].key == key) return slot;
+    
+    // Keep the load factor at or below 5/8.
+    if ((size_ + 1) * 8 > nodes_.size() * 5) {
+        grow();
+        slot = slot_of(key);
+    }
+    nodes_[slot].key = key;
+    size_++;
+    return slot;
+}
+
+void OpeningTree::grow() {
+    if (!nodes_.empty()) metrics::count_rehash(HashTable::opening_tree);
+    std::vector<Node> old(std::max<size_t>(nodes_.size() * 2, 1024));
+    old.swap(nodes_);
+    for (const Node& node : old) {
+        if (node.key != 0) nodes_[slot_of(node.key)] = node;
+    }
+}
+
+void OpeningTree::add_edge(size_t slot, uint16_t move, const Counts& counts) {
+    uint32_t* link = &nodes_[slot].first_edge;
+    for (uint32_t index = *link; index != no_edge; index = edges_[index].next) {
+        if (edges_[index].move == move) {
+            edges_[index].counts.add(counts);
+            return;
+        }
+    }
+    edges_.push_back(Edge{move, *link, counts});
+    *link = static_cast<uint32_t>(edges_.size() - 1);
+}
+
+void OpeningTree::add_game(std::string_view movetext, GameResult result, std::string_view fen) {
+    static const Position start;
+    Position position = start;
+    if (!fen.empty() && !position.set_fen(fen)) return;
+    
+    Counts counts;
+    counts.add(result);
+    
+    MovetextTokenizer tokens(movetext);
+    std::string_view san;
+    Move move;
+    for (int ply = 0; ply < max_plies_; ++ply) {
+        if (!tokens.next(san) || !position.parse_san(san, move)) break;
+        size_t slot = insert(stored_key(position.hash()));
+        nodes_[slot].counts.add(counts);
+        add_edge(slot, encode_move(move), counts);
+        position.play(move);
+    }
+    nodes_[insert(stored_key(position.hash()))].counts.add(counts);
+}
+
+void OpeningTree::merge(const OpeningTree& other) {
+    for (const Node& node : other.nodes_) {
+        if (node.key == 0) continue;
+        size_t slot = insert(node.key);
+        nodes_[slot].counts.add(node.counts);
+        for (uint32_t index = node.first_edge; index != no_edge; index = other.edges_[index].next) {
+            add_edge(slot, other.edges_[index].move, other.edges_[index].counts);
+        }
+    }
+}
+
+const OpeningTree::Counts* OpeningTree::find(uint64_t key) const {
+    if (size_ == 0) return nullptr;
+    size_t slot = slot_of(stored_key(key));
+    return nodes_[slot].key != 0 ? &nodes_[slot].counts : nullptr;
+}
+
+std::vector<OpeningTree::NextMove> OpeningTree::next_moves(uint64_t key) const {
+    std::vector<NextMove> moves;
+    if (size_ == 0) return moves;
+    size_t slot = slot_of(stored_key(key));
+    if (nodes_[slot].key == 0) return moves;
+    
+    for (uint32_t index = nodes_[slot].first_edge; index != no_edge; index = edges_[index].next) {
+        moves.push_back(NextMove{edges_[index].move, edges_[index].counts});
+    }
+    std::sort(moves.begin(), moves.end(), [](const NextMove& a, const NextMove& b) {
+        return a.counts.games != b.counts.games ? a.counts.games > b.counts.games : a.move < b.move;
+    });
+    return moves;
+}
+
+void OpeningTree::save(const std::string& filename) const {
+    std::vector<const Node*> sorted;
+    sorted.reserve(size_);
+    for (const Node& node : nodes_) {
+        if (node.key != 0) sorted.push_back(&node);
+    }
+    std::sort(sorted.begin(), sorted.end(), [](const Node* a, const Node* b) { return a->key < b->key; });
+    
+    std::vector<uint64_t> keys;
+    std::vector<Counts> node_counts;
+    std::vector<uint32_t> edge_begin{0};
+    std::vector<uint16_t> edge_moves;
+    std::vector<Counts> edge_counts;
+    keys.reserve(sorted.size());
+    node_counts.reserve(sorted.size());
+    edge_begin.reserve(sorted.size() + 1);
+    edge_moves.reserve(edges_.size());
+    edge_counts.reserve(edges_.size());
+    for (const Node* node : sorted) {
+        keys.push_back(node->key);
+        node_counts.push_back(node->counts);
+        for (const NextMove& next : next_moves(node->key)) {
+            edge_moves.push_back(next.move);
+            edge_counts.push_back(next.counts);
+        }
+        edge_begin.push_back(static_cast<uint32_t>(edge_moves.size()));
+    }
+    
+    std::ofstream out(filename, std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) throw std::runtime_error("Cannot open file: " + filename);
+    
+    uint32_t header[4] = {tree_version, byte_order_mark, uint32_t(max_plies_), 0};
+    uint64_t counts[2] = {keys.size(), edge_moves.size()};
+    out.write(tree_magic, sizeof(tree_magic));
+    write_pod(out, header, 4);
+    write_pod(out, counts, 2);
+    write_pod(out, keys.data(), keys.size());
+    write_pod(out, node_counts.data(), node_counts.size());
+    write_pod(out, edge_begin.data(), edge_begin.size());
+    write_pod(out, edge_counts.data(), edge_counts.size());
+    write_pod(out, edge_moves.data(), edge_moves.size());
+    out.close();
+    if (!out) throw std::runtime_error("Cannot write file: " + filename);
+}
+
+OpeningTree OpeningTree::load(const std::string& filename) {
+    std::ifstream in(filename, std::ios::binary);
+    if (!in.is_open()) throw std::runtime_error("Cannot open file: " + filename);
+    
+    char magic[8];
+    uint32_t header[4];
+    uint64_t counts[2];
+    read_pod(in, magic, 8, filename);
+    read_pod(in, header, 4, filename);
+    read_pod(in, counts, 2, filename);
+    if (std::memcmp(magic, tree_magic, sizeof(magic)) != 0 || header[0] != tree_version ||
+        header[1] != byte_order_mark) {
+        throw std::runtime_error("Not an opening tree file: " + filename);
+    }
+    
+    std::vector<uint64_t> keys(counts[0]);
+    std::vector<Counts> node_counts(counts[0]);
+    std::vector<uint32_t> edge_begin(counts[0] + 1);
+    std::vector<Counts> edge_counts(counts[1]);
+    std::vector<uint16_t> edge_moves(counts[1]);
+    read_pod(in, keys.data(), keys.size(), filename);
+    read_pod(in, node_counts.data(), node_counts.size(), filename);
+    read_pod(in, edge_begin.data(), edge_begin.size(), filename);
+    read_pod(in, edge_counts.data(), edge_counts.size(), filename);
+    read_pod(in, edge_moves.data(), edge_moves.size(), filename);
+    if (edge_begin.back() != counts[1]) throw std::runtime_error("Corrupt opening tree: " + filename);
+    
+    OpeningTree tree(static_cast<int>(header[2]));
+    size_t slots = 1024;
+    while (keys.size() * 8 > slots * 5) slots *= 2;
+    tree.nodes_.assign(slots, Node{});
+    tree.edges_.reserve(edge_moves.size());
+    
+    for (size_t i = 0; i < keys.size(); ++i) {
+        if (keys[i] == 0 || edge_begin[i] > edge_begin[i + 1] || edge_begin[i + 1] > counts[1]) {
+            throw std::runtime_error("Corrupt opening tree: " + filename);
+        }
+        size_t slot = tree.insert(keys[i]);
+        tree.nodes_[slot].counts = node_counts[i];
+        // Linked in reverse so the list keeps the file's order.
+        for (uint32_t e = edge_begin[i + 1]; e-- > edge_begin[i];) {
+            tree.add_edge(slot, edge_moves[e], edge_counts[e]);
+        }
+    }
+    return tree;
+}
+
+} // namespace pgn
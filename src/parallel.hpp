@@ -0,0 +1,93 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace pgn {
+
+// Runs task(0) .. task(count - 1), each on its own thread (inline when
+// count is 1), and rethrows the first exception any of them raised once
+// all have finished.
+template <typename Task>
+void run_parallel(size_t count, Task&& task) {
+    if (count == 1) {
+        task(size_t(0));
+        return;
+    }
+    
+    std::vector<std::exception_ptr> errors(count);
+    std::vector<std::thread> threads;
+    threads.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        threads.emplace_back([&task, &error = errors[i], i] {
+            try {
+                task(i);
+            } catch (...) {
+                error = std::current_exception();
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+    for (const auto& error : errors) {
+        if (error) std::rethrow_exception(error);
+    }
+}
+
+// Runs task(0) .. task(count - 1) on up to `workers` threads. Each thread
+// starts on its own contiguous run of tasks, taking them from the front;
+// a thread that runs out steals from the back of the run with the most
+// tasks left, so uneven tasks still keep every thread busy. Exceptions are
+// rethrown as by run_parallel().
+template <typename Task>
+void run_work_stealing(size_t count, unsigned workers, Task&& task) {
+    workers = static_cast<unsigned>(std::max<size_t>(1, std::min<size_t>(workers, count)));
+    
+    struct Run {
+        std::mutex mutex;
+        size_t begin = 0;
+        size_t end = 0;
+    };
+    std::unique_ptr<Run[]> runs(new Run[workers]);
+    for (unsigned w = 0; w < workers; ++w) {
+        runs[w].begin = count * w / workers;
+        runs[w].end = count * (w + 1) / workers;
+    }
+    
+    auto take_own = [&](unsigned w, size_t& index) {
+        std::lock_guard<std::mutex> lock(runs[w].mutex);
+        if (runs[w].begin == runs[w].end) return false;
+        index = runs[w].begin++;
+        return true;
+    };
+    auto steal = [&](size_t& index) {
+        for (;;) {
+            unsigned victim = workers;
+            size_t most = 0;
+            for (unsigned w = 0; w < workers; ++w) {
+                std::lock_guard<std::mutex> lock(runs[w].mutex);
+                if (runs[w].end - runs[w].begin > most) {
+                    most = runs[w].end - runs[w].begin;
+                    victim = w;
+                }
+            }
+            if (victim == workers) return false;
+            
+            // The run may have shrunk since it was measured; look again.
+            std::lock_guard<std::mutex> lock(runs[victim].mutex);
+            if (runs[victim].begin == runs[victim].end) continue;
+            index = --runs[victim].end;
+            return true;
+        }
+    };
+    
+    run_parallel(workers, [&](size_t w) {
+        size_t index;
+        while (take_own(static_cast<unsigned>(w), index) || steal(index)) task(index);
+    });
+}
+
+} // namespace pgn
@@ -1,30 +1,246 @@
 #include "pgn/parser.hpp"
+#include "pgn/reader.hpp"
 #include "pgn/types.hpp"
+#include "async_io.hpp"
+#include "decompressor.hpp"
+#include "dedup.hpp"
+#include "game_index.hpp"
+#include "game_scanner.hpp"
+#include "mapped_file.hpp"
+#include "metrics_counters.hpp"
+#include "parallel.hpp"
+#include "stats_builder.hpp"
+#include "stats_export.hpp"
+#include <deque>
+#include <filesystem>
 #include <fstream>
 #include <iostream>
 #include <unordered_set>
 #include <unordered_map>
 #include <chrono>
 #include <algorithm>
+#include <thread>
+#include <exception>
+#include <limits>
+#include <memory_resource>
+#include <mutex>
+#include <new>
 
 namespace pgn {
 
+namespace {
+
+// Games and first occurrences of each name, in file order, for one byte
+// range of the input.
+struct ChunkResult {
+    std::vector<GameView> games;
+    GameTable table;
+    std::vector<std::string_view> tournament_names;
+    std::vector<std::string_view> player_names;
+    OpeningTree tree;
+    // One per game, with ParserOptions::deduplicate.
+    std::vector<Fingerprint> fingerprints;
+};
+
+// Adds games to a ChunkResult, noting each name the first time it occurs
+// unless `track_names` is false, and fingerprinting each game if
+// `fingerprint` is set.
+class ChunkBuilder {
+public:
+    explicit ChunkBuilder(ChunkResult& result, int tree_plies = 0, bool track_names = true,
+                          bool fingerprint = false)
+        : result_(result), tree_plies_(tree_plies), track_names_(track_names),
+          fingerprint_(fingerprint) {
+        if (tree_plies_ > 0) result_.tree = OpeningTree(tree_plies_);
+    }
+    
+    ~ChunkBuilder() {
+        metrics::record_load_factor(HashTable::chunk_names, seen_players_.load_factor());
+    }
+    
+    void add(const GameView& game) {
+        if (track_names_) {
+            size_t buckets = seen_tournaments_.bucket_count();
+            if (!game.event.empty() && seen_tournaments_.insert(game.event).second) {
+                result_.tournament_names.push_back(game.event);
+                metrics::note_buckets(seen_tournaments_, buckets, HashTable::chunk_names);
+            }
+            note_player(game.white);
+            note_player(game.black);
+        }
+        result_.games.push_back(game);
+        result_.table.append(game);
+        if (tree_plies_ > 0) {
+            result_.tree.add_game(game.movetext, parse_result(game.result), game.fen);
+        }
+        if (fingerprint_) result_.fingerprints.push_back(fingerprint_game(game, scratch_));
+    }
+    
+private:
+    void note_player(std::string_view name) {
+        size_t buckets = seen_players_.bucket_count();
+        if (!name.empty() && seen_players_.insert(name).second) {
+            result_.player_names.push_back(name);
+            metrics::note_buckets(seen_players_, buckets, HashTable::chunk_names);
+        }
+    }
+    
+    ChunkResult& result_;
+    int tree_plies_;
+    bool track_names_;
+    bool fingerprint_;
+    std::string scratch_;
+    // Set nodes come from here and are dropped with the builder.
+    std::pmr::monotonic_buffer_resource arena_{metrics::counted_heap()};
+    std::pmr::unordered_set<std::string_view> seen_tournaments_{&arena_};
+    std::pmr::unordered_set<std::string_view> seen_players_{&arena_};
+};
+
+// Shell-style match of a file name: '*' stands for any run of characters
+// and '?' for any one character.
+bool matches_pattern(std::string_view name, std::string_view pattern) {
+    size_t n = 0;
+    size_t p = 0;
+    size_t star = std::string_view::npos;
+    size_t resume = 0;
+    while (n < name.size()) {
+        if (p < pattern.size() && (pattern[p] == '?' || pattern[p] == name[n])) {
+            n++;
+            p++;
+        } else if (p < pattern.size() && pattern[p] == '*') {
+            star = p++;
+            resume = n;
+        } else if (star != std::string_view::npos) {
+            // Let the last '*' absorb one more character and retry.
+            p = star + 1;
+            n = ++resume;
+        } else {
+            return false;
+        }
+    }
+    while (p < pattern.size() && pattern[p] == '*') p++;
+    return p == pattern.size();
+}
+
+} // namespace
+
 struct Parser::Impl {
+    // The statistics entries are allocated from these monotonic arenas and
+    // freed in bulk on the next load or when the parser is destroyed. Each
+    // parallel analysis worker fills its own arena.
+    std::pmr::monotonic_buffer_resource arena{metrics::counted_heap()};
+    std::deque<std::pmr::monotonic_buffer_resource> worker_arenas;
+    
+    ParserOptions options;
+    MappedFile mapping;
+    std::string buffer;
+    // Decompressed input, in the blocks it was parsed from.
+    std::deque<std::string> segments;
+    // The inputs of load_files(), one per file.
+    struct InputFile {
+        MappedFile mapping;
+        std::string buffer;
+        std::deque<std::string> segments;
+    };
+    std::deque<InputFile> inputs;
+    std::vector<FileTiming> file_timings;
+    std::vector<GameView> views;
+    // Set when the games came from a sidecar: views are then made from the
+    // table on first use, their dates and ratings formatted into view_text.
+    bool views_pending = false;
+    std::unordered_map<uint32_t, std::string> view_text;
+    GameTable table;
     std::vector<Game> games;
-    DatabaseStats stats;
+    bool games_materialized = false;
+    // Held while get_games() or get_game_views() fills its vector on first
+    // use, so that const readers on several threads do not race.
+    std::mutex materialize_mutex;
+    bool from_index = false;
+    DatabaseStats stats{&arena};
+    // Behind stats with options.approximate_stats.
+    ApproximateStats approximate;
+    OpeningTree opening_tree;
+    // Names in order of first appearance, kept so appended games extend
+    // stats.tournament_names and stats.player_names.
+    SymbolSet tournament_names;
+    SymbolSet player_names;
+    // Games seen so far with options.deduplicate, numbered in input order
+    // from 0; appended games are checked against those already loaded.
+    FingerprintSet fingerprints;
+    uint64_t fingerprinted = 0;
+    
+    // Where the last load_file() stopped reading, for load_appended().
+    // loaded_file is empty when that load cannot be continued.
+    std::string loaded_file;
+    Query loaded_query;
+    uint64_t parsed_bytes = 0;
+    std::string boundary_sample;
     
-    void parse_file(const std::string& filename, ProgressCallback callback);
+    std::string_view load_source(const std::string& filename, MappedFile& into,
+                                 std::string& read_buffer) const;
+    bool map_source(const std::string& filename, MappedFile& into, std::string_view& text) const;
+    bool load_index(const std::string& filename, const SourceStamp& stamp);
+    unsigned worker_count(size_t work, size_t min_per_worker) const;
+    void reset();
+    void reset_stats();
+    void parse_file(const std::string& filename, const Query* query, ProgressCallback callback,
+                    bool growing = false);
+    size_t parse_text(std::string_view text, uint64_t base_offset, const Query* query,
+                      bool growing, std::vector<ChunkResult>& chunks, bool input_complete = true);
+    size_t parse_read(const std::string& filename, const Query* query, bool growing,
+                      std::vector<ChunkResult>& chunks);
+    void remember_boundary(const std::string& filename, uint64_t parsed, const Query* query);
+    bool parse_appended(const std::string& filename, ProgressCallback callback);
+    void parse_files(const std::vector<std::string>& filenames, ProgressCallback callback);
+    void select_loaded(const Query& query, ProgressCallback callback);
+    void collect(std::vector<ChunkResult>& chunks, ProgressCallback callback,
+                 bool growing = false);
+    void drop_duplicates(std::vector<ChunkResult>& chunks);
     void analyze_data(ProgressCallback callback);
-    void update_player_stats(const Game& game);
-    void update_tournament_stats(const Game& game);
+    void analyze_appended(size_t first_new, ProgressCallback callback);
+    void analyze_approximate(size_t first_new, ProgressCallback callback);
+    void sketch_file(const std::string& filename, ProgressCallback callback);
+    void stream_file(const std::string& filename, const Query* query, const GameVisitor& visitor,
+                     ProgressCallback callback);
+    void scan_fields(const std::string& filename, uint32_t tags,
+                     const std::function<void(size_t)>& begin, const ChunkVisitor& add);
+    const std::vector<Game>& materialize_games();
+    const std::vector<GameView>& game_views();
 };
 
 Parser::Parser() : pimpl(std::make_unique<Impl>()) {}
+
+Parser::Parser(const ParserOptions& options) : pimpl(std::make_unique<Impl>()) {
+    pimpl->options = options;
+}
+
 Parser::~Parser() = default;
 
+void Parser::set_options(const ParserOptions& options) {
+    pimpl->options = options;
+}
+
+const ParserOptions& Parser::get_options() const {
+    return pimpl->options;
+}
+
 bool Parser::load_file(const std::string& filename, ProgressCallback callback) {
+    metrics::StageTimer timer(Stage::load);
+    try {
+        pimpl->parse_file(filename, nullptr, callback);
+        pimpl->analyze_data(callback);
+        return true;
+    } catch (const std::exception& e) {
+        std::cerr << "Error loading file: " << e.what() << std::endl;
+        return false;
+    }
+}
+
+bool Parser::load_file(const std::string& filename, const Query& query,
+                       ProgressCallback callback) {
+    metrics::StageTimer timer(Stage::load);
     try {
-        pimpl->parse_file(filename, callback);
+        pimpl->parse_file(filename, &query, callback);
         pimpl->analyze_data(callback);
         return true;
     } catch (const std::exception& e) {
@@ -33,270 +249,1146 @@ bool Parser::load_file(const std::string& filename, ProgressCallback callback) {
     }
 }
 
+bool Parser::load_appended(const std::string& filename, ProgressCallback callback) {
+    metrics::StageTimer timer(Stage::load);
+    try {
+        if (!pimpl->parse_appended(filename, callback)) {
+            Query query;
+            if (filename == pimpl->loaded_file) query = pimpl->loaded_query;
+            pimpl->parse_file(filename, &query, callback, true);
+            pimpl->analyze_data(callback);
+        }
+        return true;
+    } catch (const std::exception& e) {
+        std::cerr << "Error loading file: " << e.what() << std::endl;
+        return false;
+    }
+}
+
+bool Parser::load_files(const std::vector<std::string>& filenames, ProgressCallback callback) {
+    metrics::StageTimer timer(Stage::load);
+    try {
+        pimpl->parse_files(filenames, callback);
+        pimpl->analyze_data(callback);
+        return true;
+    } catch (const std::exception& e) {
+        std::cerr << "Error loading file: " << e.what() << std::endl;
+        return false;
+    }
+}
+
+bool Parser::load_directory(const std::string& directory, const std::string& pattern,
+                            ProgressCallback callback) {
+    std::vector<std::string> filenames;
+    try {
+        for (const auto& entry : std::filesystem::directory_iterator(directory)) {
+            if (entry.is_regular_file() &&
+                matches_pattern(entry.path().filename().string(), pattern)) {
+                filenames.push_back(entry.path().string());
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error loading file: " << e.what() << std::endl;
+        return false;
+    }
+    std::sort(filenames.begin(), filenames.end());
+    return load_files(filenames, callback);
+}
+
+bool Parser::for_each_game(const std::string& filename, GameVisitor visitor,
+                           ProgressCallback callback) {
+    metrics::StageTimer timer(Stage::load);
+    try {
+        pimpl->stream_file(filename, nullptr, visitor, callback);
+        return true;
+    } catch (const std::exception& e) {
+        std::cerr << "Error loading file: " << e.what() << std::endl;
+        return false;
+    }
+}
+
+bool Parser::for_each_game(const std::string& filename, const Query& query, GameVisitor visitor,
+                           ProgressCallback callback) {
+    metrics::StageTimer timer(Stage::load);
+    try {
+        pimpl->stream_file(filename, &query, visitor, callback);
+        return true;
+    } catch (const std::exception& e) {
+        std::cerr << "Error loading file: " << e.what() << std::endl;
+        return false;
+    }
+}
+
+bool Parser::loaded_from_index() const {
+    return pimpl->from_index;
+}
+
 const DatabaseStats& Parser::get_stats() const {
     return pimpl->stats;
 }
 
+const ApproximateStats& Parser::get_approximate_stats() const {
+    return pimpl->approximate;
+}
+
 const std::vector<Game>& Parser::get_games() const {
-    return pimpl->games;
+    return pimpl->materialize_games();
 }
 
-const std::unordered_map<std::string, PlayerStats>& Parser::get_player_stats() const {
+const std::vector<GameView>& Parser::get_game_views() const {
+    return pimpl->game_views();
+}
+
+const GameTable& Parser::get_game_table() const {
+    return pimpl->table;
+}
+
+const std::pmr::unordered_map<Symbol, PlayerStats>& Parser::get_player_stats() const {
     return pimpl->stats.player_stats;
 }
 
-const std::unordered_map<std::string, Tournament>& Parser::get_tournaments() const {
+const std::pmr::unordered_map<Symbol, Tournament>& Parser::get_tournaments() const {
     return pimpl->stats.tournaments;
 }
 
-void Parser::Impl::parse_file(const std::string& filename, ProgressCallback callback) {
-    auto start_time = std::chrono::high_resolution_clock::now();
+const std::vector<FileTiming>& Parser::get_file_timings() const {
+    return pimpl->file_timings;
+}
+
+const OpeningTree& Parser::get_opening_tree() const {
+    return pimpl->opening_tree;
+}
+
+const std::vector<Game>& Parser::Impl::materialize_games() {
+    std::lock_guard<std::mutex> lock(materialize_mutex);
+    if (!games_materialized) {
+        games.clear();
+        games.reserve(table.size());
+        for (size_t i = 0; i < table.size(); ++i) {
+            games.push_back(table.row(i));
+        }
+        games_materialized = true;
+    }
+    return games;
+}
+
+const std::vector<GameView>& Parser::Impl::game_views() {
+    std::lock_guard<std::mutex> lock(materialize_mutex);
+    if (views_pending) {
+        views.reserve(table.size());
+        for (size_t i = 0; i < table.size(); ++i) {
+            views.push_back(table.view(i, view_text));
+        }
+        views_pending = false;
+    }
+    return views;
+}
+
+void Parser::Impl::reset() {
+    views.clear();
+    views_pending = false;
+    view_text.clear();
+    table.clear();
+    games.clear();
+    games_materialized = false;
+    from_index = false;
+    mapping.close();
+    buffer.clear();
+    buffer.shrink_to_fit();
+    segments.clear();
+    inputs.clear();
+    file_timings.clear();
+    reset_stats();
+    opening_tree = OpeningTree(options.opening_tree_plies);
+    tournament_names.clear();
+    player_names.clear();
+    fingerprints.clear();
+    fingerprinted = 0;
+    loaded_file.clear();
+    loaded_query = Query();
+    parsed_bytes = 0;
+    boundary_sample.clear();
+}
+
+// Destroys the statistics first, since releasing the arenas frees their
+// memory without running destructors.
+void Parser::Impl::reset_stats() {
+    stats.~DatabaseStats();
+    worker_arenas.clear();
+    arena.release();
+    new (&stats) DatabaseStats(&arena);
+    approximate.clear();
+}
+
+// Maps `filename` into `into` if options.use_mmap allows; false if it
+// cannot be mapped (pipe, device, exotic filesystem) and must be read.
+bool Parser::Impl::map_source(const std::string& filename, MappedFile& into,
+                              std::string_view& text) const {
+    if (!options.use_mmap) return false;
+    metrics::StageTimer timer(Stage::read);
+    try {
+        into.open(filename);
+        text = into.view();
+        return true;
+    } catch (const std::exception&) {
+        return false;
+    }
+}
+
+std::string_view Parser::Impl::load_source(const std::string& filename, MappedFile& into,
+                                           std::string& read_buffer) const {
+    std::string_view text;
+    if (map_source(filename, into, text)) return text;
     
-    std::ifstream pgn_file(filename);
+    metrics::StageTimer timer(Stage::read);
+    std::error_code error;
+    if (std::filesystem::is_regular_file(filename, error)) {
+        read_file(filename, read_buffer, options.use_io_uring);
+        return read_buffer;
+    }
+    
+    std::ifstream pgn_file(filename, std::ios::binary);
     if (!pgn_file.is_open()) {
         throw std::runtime_error("Cannot open file: " + filename);
     }
     
-    games.clear();
-    stats = DatabaseStats{};
-    
-    std::string line;
-    Game current_game;
-    bool in_game = false;
-    
-    std::unordered_set<std::string> tournament_names;
-    std::unordered_set<std::string> player_names;
-    
-    while (std::getline(pgn_file, line)) {
-        if (line.find("[Event \"") == 0) {
-            size_t start = 8;
-            size_t end = line.find_last_of('"');
-            if (end != std::string::npos && end > start) {
-                current_game.event = line.substr(start, end - start);
-                tournament_names.insert(current_game.event);
-            }
+    constexpr size_t block_size = 1 << 20;
+    size_t used = 0;
+    while (pgn_file) {
+        read_buffer.resize(used + block_size);
+        pgn_file.read(&read_buffer[used], block_size);
+        used += static_cast<size_t>(pgn_file.gcount());
+    }
+    read_buffer.resize(used);
+    return read_buffer;
+}
+
+namespace {
+
+constexpr size_t boundary_sample_size = 64;
+
+// True if `text` ends with a full line whose last token is a game result.
+bool ends_with_result(std::string_view text) {
+    if (text.empty() || text.back() != '\n') return false;
+    size_t end = text.find_last_not_of(" \t\r\n");
+    if (end == std::string_view::npos) return false;
+    text = text.substr(0, end + 1);
+    size_t start = text.find_last_of(" \t\r\n)}");
+    std::string_view token = start == std::string_view::npos ? text : text.substr(start + 1);
+    return token == "1-0" || token == "0-1" || token == "1/2-1/2" || token == "*";
+}
+
+// Returns how much of `text` was consumed; with input_complete false a game
+// that runs into the end of the text is left for the next call. `growing`
+// marks the current end of a file that is still being appended to: there
+// the last game is taken once its result has been written.
+size_t parse_chunk(std::string_view text, uint64_t base_offset, const ParserOptions& options,
+                   const Query* query, ChunkResult& result, bool input_complete = true,
+                   bool growing = false) {
+    metrics::StageTimer timer(Stage::scan);
+    ChunkBuilder builder(result, options.opening_tree_plies, !options.approximate_stats,
+                         options.deduplicate);
+    auto scan = [&](size_t from, bool complete) {
+        GameScanner scanner(text.substr(from), complete, base_offset + from);
+        scanner.set_filter(query);
+        scanner.set_replay(options.replay_moves);
+        GameView game;
+        while (scanner.next(game)) builder.add(game);
+        return from + scanner.position();
+    };
+    
+    size_t consumed = scan(0, input_complete && !growing);
+    if (growing && ends_with_result(text.substr(consumed))) consumed = scan(consumed, true);
+    return consumed;
+}
+
+// Up to `workers` byte ranges of `text`, as boundaries from 0 to
+// text.size(), each starting at a game.
+std::vector<size_t> split_at_games(std::string_view text, unsigned workers) {
+    std::vector<size_t> bounds{0};
+    for (unsigned i = 1; i < workers; ++i) {
+        size_t start = find_game_start(text, text.size() / workers * i);
+        if (start > bounds.back() && start < text.size()) bounds.push_back(start);
+    }
+    bounds.push_back(text.size());
+    return bounds;
+}
+
+// Parses a compressed file as it is decompressed. Each decoded block, with
+// the unfinished game carried over from the previous one, becomes a segment
+// that stays alive for the views into it.
+std::vector<ChunkResult> parse_compressed(const std::string& filename, Compression compression,
+                                          const ParserOptions& options, const Query* query,
+                                          std::deque<std::string>& segments) {
+    std::vector<ChunkResult> chunks;
+    Decompressor decompressor(filename, compression);
+    
+    std::string block;
+    std::string_view carry;
+    uint64_t offset = 0;
+    bool more = true;
+    while (more) {
+        {
+            metrics::StageTimer timer(Stage::read);
+            more = decompressor.next_block(block);
         }
-        else if (line.find("[Site \"") == 0) {
-            size_t start = 7;
-            size_t end = line.find_last_of('"');
-            if (end != std::string::npos && end > start) {
-                current_game.site = line.substr(start, end - start);
-            }
+        
+        std::string& segment = segments.emplace_back();
+        segment.reserve(carry.size() + block.size());
+        segment.append(carry);
+        if (more) segment.append(block);
+        
+        chunks.emplace_back();
+        size_t consumed = parse_chunk(segment, offset, options, query, chunks.back(), !more);
+        offset += consumed;
+        carry = std::string_view(segment).substr(consumed);
+    }
+    return chunks;
+}
+
+// Reads the games of `text` keeping only `tags` and hands them to `add`
+// in batches. Returns how much of `text` was consumed.
+template <typename Add>
+size_t scan_batches(std::string_view text, uint64_t base_offset, bool input_complete,
+                    uint32_t tags, bool replay, Add&& add) {
+    metrics::StageTimer timer(Stage::scan);
+    constexpr size_t batch_size = 4096;
+    GameScanner scanner(text, input_complete, base_offset);
+    scanner.set_tags(tags);
+    scanner.set_replay(replay);
+    std::vector<GameView> batch;
+    batch.reserve(batch_size);
+    GameView game;
+    while (scanner.next(game)) {
+        batch.push_back(game);
+        if (batch.size() == batch_size) {
+            add(batch);
+            batch.clear();
         }
-        else if (line.find("[Date \"") == 0) {
-            size_t start = 7;
-            size_t end = line.find_last_of('"');
-            if (end != std::string::npos && end > start) {
-                current_game.date = line.substr(start, end - start);
-            }
+    }
+    if (!batch.empty()) add(batch);
+    return scanner.position();
+}
+
+} // namespace
+
+unsigned Parser::Impl::worker_count(size_t work, size_t min_per_worker) const {
+    unsigned threads = options.threads;
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    size_t max_workers = std::max<size_t>(1, work / min_per_worker);
+    return static_cast<unsigned>(std::min<size_t>(threads, max_workers));
+}
+
+void Parser::Impl::parse_file(const std::string& filename, const Query* query,
+                              ProgressCallback callback, bool growing) {
+    auto start_time = std::chrono::high_resolution_clock::now();
+    
+    Query filter = query ? *query : Query();
+    query = filter.empty() ? nullptr : &filter;
+    reset();
+    
+    // Sidecars hold the '.' move counts, not replayed ones, and no movetext.
+    bool use_index = options.use_index && !options.replay_moves &&
+                     options.opening_tree_plies == 0 && !options.deduplicate;
+    SourceStamp stamp;
+    if (use_index) {
+        stamp = stamp_source(filename);
+        if (load_index(filename, stamp)) {
+            if (query) select_loaded(*query, callback);
+            remember_boundary(filename, stamp.size, query);
+            auto end_time = std::chrono::high_resolution_clock::now();
+            stats.parsing_time_seconds =
+                std::chrono::duration<double>(end_time - start_time).count();
+            return;
         }
-        else if (line.find("[Round \"") == 0) {
-            size_t start = 8;
-            size_t end = line.find_last_of('"');
-            if (end != std::string::npos && end > start) {
-                current_game.round = line.substr(start, end - start);
-            }
+    }
+    
+    std::vector<ChunkResult> chunks;
+    Compression compression = detect_compression(filename);
+    if (compression != Compression::none) {
+        chunks = parse_compressed(filename, compression, options, query, segments);
+    } else {
+        std::string_view text;
+        std::error_code error;
+        size_t parsed;
+        bool mapped = map_source(filename, mapping, text);
+        if (!mapped && std::filesystem::is_regular_file(filename, error)) {
+            parsed = parse_read(filename, query, growing, chunks);
+        } else {
+            if (!mapped) text = load_source(filename, mapping, buffer);
+            parsed = parse_text(text, 0, query, growing, chunks);
         }
-        else if (line.find("[White \"") == 0) {
-            size_t start = 8;
-            size_t end = line.find_last_of('"');
-            if (end != std::string::npos && end > start) {
-                current_game.white = line.substr(start, end - start);
-                player_names.insert(current_game.white);
-            }
+        remember_boundary(filename, parsed, query);
+    }
+    
+    collect(chunks, callback, growing);
+    
+    // Best effort: a missing or unwritable index only costs the next load a
+    // full parse. A filtered load has only some of the games to write, and
+    // a growing file may have held back its last game.
+    if (use_index && !query && !growing && stamp_source(filename) == stamp) {
+        metrics::StageTimer timer(Stage::index);
+        write_game_index(index_path_for(filename), stamp, table);
+    }
+    
+    auto end_time = std::chrono::high_resolution_clock::now();
+    stats.parsing_time_seconds = 
+        std::chrono::duration<double>(end_time - start_time).count();
+}
+
+void Parser::Impl::collect(std::vector<ChunkResult>& chunks, ProgressCallback callback,
+                           bool growing) {
+    metrics::StageTimer timer(Stage::merge);
+    if (options.deduplicate) drop_duplicates(chunks);
+    // Games appended to a load from a sidecar follow views of the earlier ones.
+    game_views();
+    
+    // Name lists are kept in order of first appearance, which is the same
+    // whichever way the file was split.
+    size_t old_tournaments = tournament_names.size();
+    size_t old_players = player_names.size();
+    
+    // Appended games grow the columns geometrically instead; an exact
+    // reserve would copy them on every refresh. A growing file starts with
+    // room for as many games again, which costs address space but no
+    // memory until it is used.
+    if (views.empty()) {
+        size_t total = 0;
+        for (const auto& chunk : chunks) total += chunk.games.size();
+        if (growing) total *= 2;
+        views.reserve(total);
+        table.reserve(total);
+    }
+    
+    // Opening trees are merged pairwise, like the statistics slices.
+    if (options.opening_tree_plies > 0 && !chunks.empty()) {
+        for (size_t stride = 1; stride < chunks.size(); stride *= 2) {
+            std::vector<size_t> targets;
+            for (size_t i = 0; i + stride < chunks.size(); i += 2 * stride) targets.push_back(i);
+            run_parallel(targets.size(), [&](size_t k) {
+                chunks[targets[k]].tree.merge(chunks[targets[k] + stride].tree);
+                chunks[targets[k] + stride].tree = OpeningTree();
+            });
         }
-        else if (line.find("[Black \"") == 0) {
-            size_t start = 8;
-            size_t end = line.find_last_of('"');
-            if (end != std::string::npos && end > start) {
-                current_game.black = line.substr(start, end - start);
-                player_names.insert(current_game.black);
-            }
+        if (opening_tree.size() == 0) {
+            opening_tree = std::move(chunks[0].tree);
+        } else {
+            opening_tree.merge(chunks[0].tree);
         }
-        else if (line.find("[Result \"") == 0) {
-            size_t start = 9;
-            size_t end = line.find_last_of('"');
-            if (end != std::string::npos && end > start) {
-                current_game.result = line.substr(start, end - start);
+        metrics::record_load_factor(HashTable::opening_tree, opening_tree.load_factor());
+    }
+    
+    for (auto& chunk : chunks) {
+        // Empty when approximate statistics skip the names.
+        for (std::string_view name : chunk.tournament_names) tournament_names.insert(intern(name));
+        for (std::string_view name : chunk.player_names) player_names.insert(intern(name));
+        
+        table.append(chunk.table);
+        for (const auto& game : chunk.games) {
+            views.push_back(game);
+            stats.total_games++;
+            if (!game.moves_valid) stats.invalid_move_games++;
+            
+            if (callback && stats.total_games % 1000 == 0) {
+                callback(stats.total_games, "Parsing games");
             }
         }
-        else if (line.find("[WhiteElo \"") == 0) {
-            size_t start = 11;
-            size_t end = line.find_last_of('"');
-            if (end != std::string::npos && end > start) {
-                current_game.white_elo = line.substr(start, end - start);
-            }
+        chunk = ChunkResult();
+    }
+    
+    const auto& new_tournaments = tournament_names.items();
+    const auto& new_players = player_names.items();
+    stats.tournament_names.insert(stats.tournament_names.end(),
+                                  new_tournaments.begin() + old_tournaments, new_tournaments.end());
+    stats.player_names.insert(stats.player_names.end(),
+                              new_players.begin() + old_players, new_players.end());
+    stats.unique_tournaments = tournament_names.size();
+    stats.unique_players = player_names.size();
+}
+
+// Drops the games of `chunks` that repeat an earlier game of this load,
+// or for appended games, one already loaded, keeping the first copy in
+// input order. Fingerprints are claimed from all chunks at once; a chunk
+// that lost games is then rebuilt from the games it keeps.
+void Parser::Impl::drop_duplicates(std::vector<ChunkResult>& chunks) {
+    std::vector<uint64_t> first(chunks.size() + 1, fingerprinted);
+    for (size_t i = 0; i < chunks.size(); ++i) {
+        first[i + 1] = first[i] + chunks[i].fingerprints.size();
+    }
+    size_t count = static_cast<size_t>(first.back() - fingerprinted);
+    fingerprints.reserve(count);
+    fingerprinted = first.back();
+    
+    constexpr size_t min_games_per_worker = 65536;
+    unsigned workers = worker_count(count, min_games_per_worker);
+    std::vector<size_t> added(chunks.size());
+    run_work_stealing(chunks.size(), workers, [&](size_t i) {
+        const auto& prints = chunks[i].fingerprints;
+        for (size_t j = 0; j < prints.size(); ++j) {
+            if (!prints[j].empty() && fingerprints.claim(prints[j], first[i] + j)) added[i]++;
         }
-        else if (line.find("[BlackElo \"") == 0) {
-            size_t start = 11;
-            size_t end = line.find_last_of('"');
-            if (end != std::string::npos && end > start) {
-                current_game.black_elo = line.substr(start, end - start);
+    });
+    for (size_t n : added) fingerprints.added(n);
+    
+    std::vector<size_t> dropped(chunks.size());
+    run_work_stealing(chunks.size(), workers, [&](size_t i) {
+        ChunkResult& chunk = chunks[i];
+        auto is_copy = [&](size_t j) {
+            const Fingerprint& print = chunk.fingerprints[j];
+            return !print.empty() && fingerprints.owner(print) != first[i] + j;
+        };
+        size_t copies = 0;
+        for (size_t j = 0; j < chunk.games.size(); ++j) copies += is_copy(j);
+        if (copies == 0) return;
+        
+        ChunkResult kept;
+        {
+            ChunkBuilder builder(kept, options.opening_tree_plies, !options.approximate_stats);
+            for (size_t j = 0; j < chunk.games.size(); ++j) {
+                if (!is_copy(j)) builder.add(chunk.games[j]);
             }
         }
-        else if (line.find("[ECO \"") == 0) {
-            size_t start = 6;
-            size_t end = line.find_last_of('"');
-            if (end != std::string::npos && end > start) {
-                current_game.eco = line.substr(start, end - start);
-            }
+        chunk = std::move(kept);
+        dropped[i] = copies;
+    });
+    for (size_t n : dropped) stats.duplicate_games += static_cast<int>(n);
+    metrics::record_load_factor(HashTable::fingerprints, fingerprints.load_factor());
+}
+
+void Parser::Impl::parse_files(const std::vector<std::string>& filenames,
+                               ProgressCallback callback) {
+    auto start_time = std::chrono::high_resolution_clock::now();
+    reset();
+    
+    // A piece is a byte range of one input, or a whole compressed input,
+    // which can only be decoded from the start.
+    struct Piece {
+        size_t file;
+        size_t begin;
+        size_t end;
+    };
+    
+    std::vector<std::string_view> texts(filenames.size());
+    std::vector<Compression> compressions(filenames.size());
+    std::vector<double> open_seconds(filenames.size());
+    uint64_t total_bytes = 0;
+    file_timings.resize(filenames.size());
+    for (size_t f = 0; f < filenames.size(); ++f) {
+        auto open_start = std::chrono::high_resolution_clock::now();
+        InputFile& input = inputs.emplace_back();
+        FileTiming& timing = file_timings[f];
+        timing.filename = filenames[f];
+        compressions[f] = detect_compression(filenames[f]);
+        if (compressions[f] != Compression::none) {
+            std::error_code error;
+            timing.bytes = std::filesystem::file_size(filenames[f], error);
+        } else {
+            texts[f] = load_source(filenames[f], input.mapping, input.buffer);
+            timing.bytes = texts[f].size();
         }
-        else if (line.find("[Opening \"") == 0) {
-            size_t start = 10;
-            size_t end = line.find_last_of('"');
-            if (end != std::string::npos && end > start) {
-                current_game.opening = line.substr(start, end - start);
-            }
+        total_bytes += timing.bytes;
+        open_seconds[f] = std::chrono::duration<double>(
+            std::chrono::high_resolution_clock::now() - open_start).count();
+    }
+    
+    // Pieces are sized so each thread gets several, which leaves room to
+    // even out the load by stealing.
+    unsigned threads = worker_count(std::numeric_limits<size_t>::max(), 1);
+    constexpr size_t min_piece_size = 1 << 20;
+    size_t piece_size = std::max<size_t>(min_piece_size, total_bytes / (threads * 8ull));
+    
+    std::vector<Piece> pieces;
+    for (size_t f = 0; f < filenames.size(); ++f) {
+        std::string_view text = texts[f];
+        if (compressions[f] != Compression::none || text.size() <= piece_size) {
+            pieces.push_back(Piece{f, 0, text.size()});
+            continue;
+        }
+        size_t begin = 0;
+        while (begin < text.size()) {
+            size_t end = text.size() - begin > piece_size * 3 / 2
+                ? find_game_start(text, begin + piece_size)
+                : text.size();
+            pieces.push_back(Piece{f, begin, end});
+            begin = end;
+        }
+    }
+    
+    // Small inputs that follow each other share a task until it reaches
+    // the piece size; compressed inputs are a task each.
+    std::vector<size_t> task_begin;
+    size_t task_bytes = piece_size;
+    for (size_t i = 0; i < pieces.size(); ++i) {
+        bool compressed = compressions[pieces[i].file] != Compression::none;
+        if (compressed || task_bytes >= piece_size) {
+            task_begin.push_back(i);
+            task_bytes = 0;
         }
-        else if (!line.empty() && line[0] != '[') {
-            current_game.move_count = 0;
-            for (size_t i = 0; i < line.length(); i++) {
-                if (line[i] == '.') current_game.move_count++;
+        task_bytes += compressed ? piece_size : pieces[i].end - pieces[i].begin;
+    }
+    task_begin.push_back(pieces.size());
+    
+    std::vector<std::vector<ChunkResult>> results(pieces.size());
+    std::vector<double> piece_seconds(pieces.size());
+    run_work_stealing(task_begin.size() - 1, threads, [&](size_t task) {
+        for (size_t i = task_begin[task]; i < task_begin[task + 1]; ++i) {
+            const Piece& piece = pieces[i];
+            auto piece_start = std::chrono::high_resolution_clock::now();
+            if (compressions[piece.file] != Compression::none) {
+                results[i] = parse_compressed(filenames[piece.file], compressions[piece.file],
+                                              options, nullptr, inputs[piece.file].segments);
+            } else {
+                results[i].resize(1);
+                parse_chunk(texts[piece.file].substr(piece.begin, piece.end - piece.begin),
+                            piece.begin, options, nullptr, results[i][0]);
             }
+            piece_seconds[i] = std::chrono::duration<double>(
+                std::chrono::high_resolution_clock::now() - piece_start).count();
+        }
+    });
+    
+    std::vector<ChunkResult> chunks;
+    for (size_t f = 0; f < filenames.size(); ++f) {
+        file_timings[f].parse_seconds = open_seconds[f];
+    }
+    for (size_t i = 0; i < pieces.size(); ++i) {
+        FileTiming& timing = file_timings[pieces[i].file];
+        timing.parse_seconds += piece_seconds[i];
+        for (ChunkResult& chunk : results[i]) {
+            timing.games += static_cast<int>(chunk.games.size());
+            chunks.push_back(std::move(chunk));
+        }
+    }
+    collect(chunks, callback);
+    
+    auto end_time = std::chrono::high_resolution_clock::now();
+    stats.parsing_time_seconds =
+        std::chrono::duration<double>(end_time - start_time).count();
+}
+
+// Parses `text`, which starts `base_offset` bytes into the file, in up to
+// options.threads byte ranges, adding a chunk for each. Returns how much of
+// it was consumed; unless `input_complete`, a game that runs into the end
+// of the text is left for a later call.
+size_t Parser::Impl::parse_text(std::string_view text, uint64_t base_offset, const Query* query,
+                                bool growing, std::vector<ChunkResult>& chunks,
+                                bool input_complete) {
+    constexpr size_t min_chunk_size = 4 << 20;
+    std::vector<size_t> bounds = split_at_games(text, worker_count(text.size(), min_chunk_size));
+    size_t first = chunks.size();
+    size_t count = bounds.size() - 1;
+    chunks.resize(first + count);
+    size_t parsed = 0;
+    run_parallel(count, [&](size_t i) {
+        bool last = i + 1 == count;
+        size_t consumed = parse_chunk(text.substr(bounds[i], bounds[i + 1] - bounds[i]),
+                                      base_offset + bounds[i], options, query, chunks[first + i],
+                                      !last || input_complete, growing && last);
+        if (last) parsed = bounds[i] + consumed;
+    });
+    return parsed;
+}
+
+// Reads `filename` into `buffer` with read_depth reads in flight, parsing
+// each stretch of the file as soon as the reads up to it are in, so the
+// device keeps reading while the games already read are parsed. Without
+// io_uring the reads block and the two take turns. Returns how much of the
+// file was consumed.
+size_t Parser::Impl::parse_read(const std::string& filename, const Query* query, bool growing,
+                                std::vector<ChunkResult>& chunks) {
+    constexpr size_t block_size = 4 << 20;
+    constexpr unsigned read_depth = 8;
+    AsyncFile file(filename, read_depth, options.use_io_uring);
+    buffer.assign(static_cast<size_t>(file.size()), '\0');
+    
+    // Reads are tagged with their block. `arrived` is the end of the
+    // stretch read without gaps; a file that shrank while being read ends
+    // at the first short read.
+    size_t blocks = (buffer.size() + block_size - 1) / block_size;
+    std::vector<bool> done(blocks, false);
+    size_t next = 0;
+    size_t arrived = 0;
+    size_t parsed = 0;
+    size_t end = buffer.size();
+    // Without io_uring, submit() is where the read happens.
+    auto submit_next = [&] {
+        metrics::StageTimer timer(Stage::read);
+        size_t offset = next * block_size;
+        file.submit(&buffer[offset], std::min(block_size, buffer.size() - offset), offset, next);
+        next++;
+    };
+    
+    // Parse in steps that give every worker a chunk of its own.
+    size_t step = block_size * worker_count(std::numeric_limits<size_t>::max(), 1);
+    while (next < blocks && file.in_flight() < read_depth) submit_next();
+    while (file.in_flight() > 0) {
+        AsyncFile::Completion completion;
+        {
+            metrics::StageTimer timer(Stage::read);
+            completion = file.wait();
         }
+        size_t offset = completion.tag * block_size;
+        if (completion.bytes < std::min(block_size, buffer.size() - offset)) {
+            end = std::min(end, offset + completion.bytes);
+        }
+        done[completion.tag] = true;
+        while (arrived < end && done[arrived / block_size]) {
+            arrived = std::min(end, (arrived / block_size + 1) * block_size);
+        }
+        if (next < blocks && next * block_size < end) submit_next();
         
-        if (line.empty() && in_game) {
-            games.push_back(current_game);
-            current_game = Game{};
-            in_game = false;
-            stats.total_games++;
-            
-            if (callback && stats.total_games % 1000 == 0) {
-                callback(stats.total_games, "Parsing games");
-            }
+        bool complete = file.in_flight() == 0;
+        if (arrived - parsed >= step || (complete && arrived > parsed)) {
+            std::string_view text(buffer.data() + parsed, arrived - parsed);
+            parsed += parse_text(text, parsed, query, growing && complete, chunks, complete);
         }
-        else if (!line.empty() && line[0] == '[') {
-            in_game = true;
+    }
+    buffer.resize(end);
+    return parsed;
+}
+
+// Fields are the TagKind bits of the tags they come from.
+static_assert(uint32_t(Fields::event) == 1u << size_t(TagKind::event) &&
+              uint32_t(Fields::eco) == 1u << size_t(TagKind::eco) &&
+              uint32_t(Fields::opening) == 1u << size_t(TagKind::opening));
+
+void Parser::Impl::scan_fields(const std::string& filename, uint32_t tags,
+                               const std::function<void(size_t)>& begin, const ChunkVisitor& add) {
+    bool replay = options.replay_moves && has_field(Fields(tags), Fields::move_count);
+    if (replay) tags |= 1u << size_t(TagKind::fen);
+    
+    // Blocks are converted as they are decoded, so only the unfinished
+    // game of the last one is carried.
+    Compression compression = detect_compression(filename);
+    if (compression != Compression::none) {
+        begin(1);
+        Decompressor decompressor(filename, compression);
+        std::string block;
+        std::string segment;
+        uint64_t offset = 0;
+        bool more = true;
+        while (more) {
+            {
+                metrics::StageTimer timer(Stage::read);
+                more = decompressor.next_block(block);
+            }
+            if (more) segment.append(block);
+            size_t consumed = scan_batches(segment, offset, !more, tags, replay,
+                                           [&](const std::vector<GameView>& games) { add(0, games); });
+            offset += consumed;
+            segment.erase(0, consumed);
         }
+        return;
     }
     
-    if (in_game) {
-        games.push_back(current_game);
-        stats.total_games++;
+    constexpr size_t min_chunk_size = 4 << 20;
+    std::string_view text = load_source(filename, mapping, buffer);
+    std::vector<size_t> bounds = split_at_games(text, worker_count(text.size(), min_chunk_size));
+    begin(bounds.size() - 1);
+    run_parallel(bounds.size() - 1, [&](size_t i) {
+        scan_batches(text.substr(bounds[i], bounds[i + 1] - bounds[i]), bounds[i], true, tags, replay,
+                     [&](const std::vector<GameView>& games) { add(i, games); });
+    });
+}
+
+// Notes where parsing of `filename` stopped, with the bytes just before
+// that point so load_appended() can tell whether the file was rewritten.
+void Parser::Impl::remember_boundary(const std::string& filename, uint64_t parsed,
+                                     const Query* query) {
+    uint64_t sample_start = parsed > boundary_sample_size ? parsed - boundary_sample_size : 0;
+    std::ifstream file(filename, std::ios::binary);
+    boundary_sample.assign(static_cast<size_t>(parsed - sample_start), '\0');
+    file.seekg(static_cast<std::streamoff>(sample_start));
+    file.read(&boundary_sample[0], static_cast<std::streamsize>(boundary_sample.size()));
+    if (!file) return;
+    
+    loaded_file = filename;
+    loaded_query = query ? *query : Query();
+    parsed_bytes = parsed;
+}
+
+// Parses only what was appended to the last loaded file. Returns false,
+// having changed nothing, if that file cannot be continued: it was not
+// loaded last, was compressed or streamed, or was truncated or rewritten.
+bool Parser::Impl::parse_appended(const std::string& filename, ProgressCallback callback) {
+    auto start_time = std::chrono::high_resolution_clock::now();
+    if (loaded_file.empty() || filename != loaded_file) return false;
+    
+    std::ifstream file(filename, std::ios::binary | std::ios::ate);
+    if (!file.is_open()) {
+        throw std::runtime_error("Cannot open file: " + filename);
     }
+    uint64_t size = static_cast<uint64_t>(file.tellg());
+    if (size < parsed_bytes) return false;
     
-    stats.tournament_names.assign(tournament_names.begin(), tournament_names.end());
-    stats.player_names.assign(player_names.begin(), player_names.end());
-    stats.unique_tournaments = tournament_names.size();
-    stats.unique_players = player_names.size();
+    std::string sample(boundary_sample.size(), '\0');
+    file.seekg(static_cast<std::streamoff>(parsed_bytes - sample.size()));
+    file.read(&sample[0], static_cast<std::streamsize>(sample.size()));
+    if (!file || sample != boundary_sample) return false;
+    
+    // The new bytes get a segment of their own; views into earlier input
+    // stay valid.
+    std::string& segment = segments.emplace_back(size - parsed_bytes, '\0');
+    file.read(&segment[0], static_cast<std::streamsize>(segment.size()));
+    segment.resize(static_cast<size_t>(file.gcount()));
+    
+    const Query* query = loaded_query.empty() ? nullptr : &loaded_query;
+    std::vector<ChunkResult> chunks;
+    size_t parsed = parse_text(segment, parsed_bytes, query, true, chunks);
+    
+    size_t first_new = table.size();
+    collect(chunks, callback);
+    
+    boundary_sample.append(segment, 0, parsed);
+    if (boundary_sample.size() > boundary_sample_size) {
+        boundary_sample.erase(0, boundary_sample.size() - boundary_sample_size);
+    }
+    parsed_bytes += parsed;
+    segment.resize(parsed);
+    if (parsed == 0) segments.pop_back();
+    games_materialized = false;
     
     auto end_time = std::chrono::high_resolution_clock::now();
-    stats.parsing_time_seconds = 
-        std::chrono::duration<double>(end_time - start_time).count();
+    stats.parsing_time_seconds = std::chrono::duration<double>(end_time - start_time).count();
+    analyze_appended(first_new, callback);
+    return true;
+}
+
+// Narrows games read from an index to those matching `query`, as if the
+// filtered load had scanned the PGN.
+void Parser::Impl::select_loaded(const Query& query, ProgressCallback callback) {
+    std::vector<ChunkResult> chunks(1);
+    ChunkBuilder builder(chunks[0], 0, !options.approximate_stats);
+    for (const auto& game : game_views()) {
+        if (query.matches(game)) builder.add(game);
+    }
+    
+    views.clear();
+    table.clear();
+    reset_stats();
+    tournament_names.clear();
+    player_names.clear();
+    collect(chunks, callback);
+}
+
+bool Parser::Impl::load_index(const std::string& filename, const SourceStamp& stamp) {
+    metrics::StageTimer timer(Stage::index);
+    IndexContents contents;
+    if (stamp.size == 0 || !read_game_index(index_path_for(filename), stamp, contents)) {
+        return false;
+    }
+    
+    table = std::move(contents.table);
+    views_pending = true;
+    if (!options.approximate_stats) {
+        for (Symbol name : contents.tournament_names) tournament_names.insert(name);
+        for (Symbol name : contents.player_names) player_names.insert(name);
+    }
+    stats.tournament_names.assign(tournament_names.begin(), tournament_names.end());
+    stats.player_names.assign(player_names.begin(), player_names.end());
     
-    pgn_file.close();
+    stats.total_games = static_cast<int>(table.size());
+    stats.unique_tournaments = static_cast<int>(stats.tournament_names.size());
+    stats.unique_players = static_cast<int>(stats.player_names.size());
+    from_index = true;
+    return true;
 }
 
 void Parser::Impl::analyze_data(ProgressCallback callback) {
+    if (options.approximate_stats) return analyze_approximate(0, callback);
+    metrics::StageTimer timer(Stage::analysis);
+    auto start_time = std::chrono::high_resolution_clock::now();
     if (callback) callback(0, "Analyzing data");
     
-    stats.player_stats.clear();
-    stats.tournaments.clear();
-    stats.white_wins = 0;
-    stats.black_wins = 0;
-    stats.draws = 0;
-    stats.unknown_results = 0;
+    constexpr size_t min_slice_size = 16384;
+    unsigned workers = worker_count(table.size(), min_slice_size);
     
-    for (size_t i = 0; i < games.size(); ++i) {
-        update_player_stats(games[i]);
-        update_tournament_stats(games[i]);
-        
-        if (games[i].is_white_win()) stats.white_wins++;
-        else if (games[i].is_black_win()) stats.black_wins++;
-        else if (games[i].is_draw()) stats.draws++;
-        else stats.unknown_results++;
+    // Each worker folds a contiguous slice of the games into its own
+    // partial statistics; worker 0 writes straight into `stats`.
+    std::vector<DatabaseStats> partials;
+    partials.reserve(workers - 1);
+    for (unsigned i = 1; i < workers; ++i) partials.emplace_back(&worker_arenas.emplace_back(metrics::counted_heap()));
+    std::vector<StatsBuilder> builders;
+    builders.reserve(workers);
+    builders.emplace_back(stats, options.rating_stats);
+    for (auto& partial : partials) builders.emplace_back(partial, options.rating_stats);
+    
+    run_parallel(workers, [&](size_t i) {
+        size_t begin = table.size() * i / workers;
+        size_t end = table.size() * (i + 1) / workers;
+        builders[i].reset();
         
-        if (callback && (i % 1000 == 0)) {
-            callback(i, "Analyzing games");
+        constexpr size_t block_size = 1000;
+        for (size_t block = begin; block < end; block += block_size) {
+            builders[i].add(table, block, std::min(block + block_size, end));
+            // Progress is only reported from the calling thread.
+            if (callback && workers == 1) callback(block, "Analyzing games");
         }
+    });
+    
+    // Tree reduction: each round merges slice i + stride into slice i, so
+    // later games are always folded into earlier ones.
+    for (size_t stride = 1; stride < workers; stride *= 2) {
+        std::vector<size_t> targets;
+        for (size_t i = 0; i + stride < workers; i += 2 * stride) targets.push_back(i);
+        run_parallel(targets.size(), [&](size_t k) {
+            builders[targets[k]].merge(std::move(partials[targets[k] + stride - 1]));
+        });
     }
     
-    for (auto& [name, player] : stats.player_stats) {
-        player.calculate_percentages();
-        
-        if (player.total_games > stats.max_games_by_player) {
-            stats.max_games_by_player = player.total_games;
-            stats.most_active_player = name;
+    builders[0].finish(workers);
+    
+    auto end_time = std::chrono::high_resolution_clock::now();
+    stats.analysis_time_seconds =
+        std::chrono::duration<double>(end_time - start_time).count();
+    metrics::record_load_factor(HashTable::statistics, stats.player_stats.load_factor());
+    
+    if (callback) callback(table.size(), "Analysis complete");
+}
+
+// Folds the games from `first_new` on into statistics that already cover
+// the games before them.
+void Parser::Impl::analyze_appended(size_t first_new, ProgressCallback callback) {
+    if (options.approximate_stats) return analyze_approximate(first_new, callback);
+    metrics::StageTimer timer(Stage::analysis);
+    auto start_time = std::chrono::high_resolution_clock::now();
+    if (callback) callback(0, "Analyzing data");
+    
+    StatsBuilder builder(stats, options.rating_stats);
+    builder.add(table, first_new, table.size());
+    builder.finish_added(table, first_new, table.size());
+    
+    auto end_time = std::chrono::high_resolution_clock::now();
+    stats.analysis_time_seconds =
+        std::chrono::duration<double>(end_time - start_time).count();
+    metrics::record_load_factor(HashTable::statistics, stats.player_stats.load_factor());
+    
+    if (callback) callback(table.size(), "Analysis complete");
+}
+
+// Adds the games from `first_new` on to the sketches, each worker
+// sketching a slice of them, and refreshes the statistics.
+void Parser::Impl::analyze_approximate(size_t first_new, ProgressCallback callback) {
+    metrics::StageTimer timer(Stage::analysis);
+    auto start_time = std::chrono::high_resolution_clock::now();
+    if (callback) callback(0, "Analyzing data");
+    
+    constexpr size_t min_slice_size = 65536;
+    size_t count = table.size() - first_new;
+    unsigned workers = worker_count(count, min_slice_size);
+    std::vector<ApproximateStats> partials(workers - 1);
+    run_parallel(workers, [&](size_t i) {
+        ApproximateStats& sketch = i == 0 ? approximate : partials[i - 1];
+        size_t end = first_new + count * (i + 1) / workers;
+        for (size_t row = first_new + count * i / workers; row < end; ++row) {
+            sketch.add(table.events()[row].str(), table.whites()[row].str(),
+                       table.blacks()[row].str(), table.result(row));
         }
+    });
+    for (const auto& partial : partials) approximate.merge(partial);
+    approximate.fill(stats);
+    
+    auto end_time = std::chrono::high_resolution_clock::now();
+    stats.analysis_time_seconds =
+        std::chrono::duration<double>(end_time - start_time).count();
+    
+    if (callback) callback(table.size(), "Analysis complete");
+}
+
+// Sketches a file without keeping its games: each worker scans a byte
+// range of the mapped input into sketches of its own.
+void Parser::Impl::sketch_file(const std::string& filename, ProgressCallback callback) {
+    auto start_time = std::chrono::high_resolution_clock::now();
+    if (detect_compression(filename) != Compression::none) {
+        stream_file(filename, nullptr, nullptr, callback);
+        return;
     }
     
-    for (const auto& [name, tournament] : stats.tournaments) {
-        if (tournament.total_games > stats.max_games_in_tournament) {
-            stats.max_games_in_tournament = tournament.total_games;
-            stats.largest_tournament = name;
+    reset();
+    std::string_view text = load_source(filename, mapping, buffer);
+    constexpr size_t min_chunk_size = 4 << 20;
+    std::vector<size_t> bounds = split_at_games(text, worker_count(text.size(), min_chunk_size));
+    size_t workers = bounds.size() - 1;
+    std::vector<ApproximateStats> partials(workers - 1);
+    std::vector<int> invalid(workers);
+    
+    run_parallel(workers, [&](size_t i) {
+        metrics::StageTimer timer(Stage::scan);
+        ApproximateStats& sketch = i == 0 ? approximate : partials[i - 1];
+        GameScanner scanner(text.substr(bounds[i], bounds[i + 1] - bounds[i]), true, bounds[i]);
+        scanner.set_replay(options.replay_moves);
+        GameView game;
+        while (scanner.next(game)) {
+            sketch.add(game);
+            if (!game.moves_valid) invalid[i]++;
+            if (callback && workers == 1 && sketch.total_games() % 1000 == 0) {
+                callback(static_cast<int>(sketch.total_games()), "Streaming games");
+            }
         }
+    });
+    
+    {
+        metrics::StageTimer timer(Stage::merge);
+        for (const auto& partial : partials) approximate.merge(partial);
     }
+    approximate.fill(stats);
+    for (int count : invalid) stats.invalid_move_games += count;
+    mapping.close();
+    buffer.clear();
+    buffer.shrink_to_fit();
+    
+    auto end_time = std::chrono::high_resolution_clock::now();
+    stats.parsing_time_seconds =
+        std::chrono::duration<double>(end_time - start_time).count();
     
-    if (callback) callback(games.size(), "Analysis complete");
+    if (callback) callback(stats.total_games, "Analysis complete");
 }
 
-void Parser::Impl::update_player_stats(const Game& game) {
-    PlayerStats& white = stats.player_stats[game.white];
-    white.name = game.white;
-    white.total_games++;
-    white.games_as_white++;
+void Parser::Impl::stream_file(const std::string& filename, const Query* query,
+                               const GameVisitor& visitor, ProgressCallback callback) {
+    auto start_time = std::chrono::high_resolution_clock::now();
     
-    if (game.is_white_win()) white.wins++;
-    else if (game.is_black_win()) white.losses++;
-    else if (game.is_draw()) white.draws++;
+    reset();
+    GameReader reader(filename, options);
+    if (query) reader.set_query(*query);
+    StatsBuilder builder(stats, options.rating_stats);
     
-    if (std::find(white.opponents.begin(), white.opponents.end(), game.black) == white.opponents.end()) {
-        white.opponents.push_back(game.black);
+    GameView game;
+    std::string scratch;
+    while (reader.next(game)) {
+        if (options.deduplicate) {
+            Fingerprint fingerprint = fingerprint_game(game, scratch);
+            if (!fingerprint.empty()) {
+                fingerprints.reserve(1);
+                if (!fingerprints.claim(fingerprint, fingerprinted++)) {
+                    stats.duplicate_games++;
+                    continue;
+                }
+                fingerprints.added(1);
+            }
+        }
+        stats.total_games++;
+        if (!game.moves_valid) stats.invalid_move_games++;
+        if (options.approximate_stats) {
+            approximate.add(game);
+        } else {
+            builder.track_names(game);
+            builder.add(game);
+        }
+        if (options.opening_tree_plies > 0) {
+            opening_tree.add_game(game.movetext, parse_result(game.result), game.fen);
+        }
+        if (visitor) visitor(game);
+        
+        if (callback && stats.total_games % 1000 == 0) {
+            callback(stats.total_games, "Streaming games");
+        }
     }
     
-    if (!game.eco.empty()) {
-        white.opening_frequency[game.eco]++;
+    if (options.approximate_stats) {
+        approximate.fill(stats);
+    } else {
+        builder.finish();
+        metrics::record_load_factor(HashTable::statistics, stats.player_stats.load_factor());
+    }
+    if (options.opening_tree_plies > 0) {
+        metrics::record_load_factor(HashTable::opening_tree, opening_tree.load_factor());
+    }
+    if (options.deduplicate) {
+        metrics::record_load_factor(HashTable::fingerprints, fingerprints.load_factor());
     }
     
-    PlayerStats& black = stats.player_stats[game.black];
-    black.name = game.black;
-    black.total_games++;
-    black.games_as_black++;
+    auto end_time = std::chrono::high_resolution_clock::now();
+    stats.parsing_time_seconds = 
+        std::chrono::duration<double>(end_time - start_time).count();
     
-    if (game.is_black_win()) black.wins++;
-    else if (game.is_white_win()) black.losses++;
-    else if (game.is_draw()) black.draws++;
+    if (callback) callback(stats.total_games, "Analysis complete");
+}
+
+DatabaseStats Parser::analyze_file(const std::string& filename, ProgressCallback callback,
+                                   const ParserOptions& options) {
+    Parser parser(options);
     
-    if (std::find(black.opponents.begin(), black.opponents.end(), game.white) == black.opponents.end()) {
-        black.opponents.push_back(game.white);
+    // Only the statistics are returned, so a serial analysis never needs
+    // to hold the games; parallel parsing works on the whole file at once,
+    // unless sketches are enough and each thread can drop its games.
+    // Duplicates are only found across the whole file.
+    bool loaded;
+    if (options.approximate_stats && options.threads != 1 && !options.deduplicate) {
+        metrics::StageTimer timer(Stage::load);
+        try {
+            parser.pimpl->sketch_file(filename, callback);
+            loaded = true;
+        } catch (const std::exception& e) {
+            std::cerr << "Error loading file: " << e.what() << std::endl;
+            loaded = false;
+        }
+    } else {
+        loaded = options.threads == 1
+            ? parser.for_each_game(filename, nullptr, callback)
+            : parser.load_file(filename, callback);
     }
-    
-    if (!game.eco.empty()) {
-        black.opening_frequency[game.eco]++;
+    if (loaded) {
+        return parser.get_stats();
     }
+    return DatabaseStats{};
 }
 
-void Parser::Impl::update_tournament_stats(const Game& game) {
-    Tournament& tournament = stats.tournaments[game.event];
-    tournament.name = game.event;
-    tournament.total_games++;
-    
-    if (std::find(tournament.players.begin(), tournament.players.end(), game.white) == tournament.players.end()) {
-        tournament.players.push_back(game.white);
+bool Parser::scan_fields(const std::string& filename, const ParserOptions& options, Fields fields,
+                         const std::function<void(size_t)>& begin, const ChunkVisitor& add) {
+    Parser parser(options);
+    metrics::StageTimer timer(Stage::load);
+    try {
+        parser.pimpl->scan_fields(filename, static_cast<uint32_t>(fields), begin, add);
+        return true;
+    } catch (const std::exception& e) {
+        std::cerr << "Error loading file: " << e.what() << std::endl;
+        return false;
     }
-    if (std::find(tournament.players.begin(), tournament.players.end(), game.black) == tournament.players.end()) {
-        tournament.players.push_back(game.black);
+}
+
+bool Parser::export_player_stats_csv(const std::string& filename) const {
+    metrics::StageTimer timer(Stage::save);
+    try {
+        write_player_stats_csv(pimpl->stats, filename, pimpl->options.threads);
+        return true;
+    } catch (const std::exception& e) {
+        std::cerr << "Error exporting file: " << e.what() << std::endl;
+        return false;
     }
-    
-    tournament.unique_players = tournament.players.size();
-    tournament.player_game_count[game.white]++;
-    tournament.player_game_count[game.black]++;
 }
 
-DatabaseStats Parser::analyze_file(const std::string& filename, ProgressCallback callback) {
-    Parser parser;
-    if (parser.load_file(filename, callback)) {
-        return parser.get_stats();
+bool Parser::export_tournaments_csv(const std::string& filename) const {
+    metrics::StageTimer timer(Stage::save);
+    try {
+        write_tournaments_csv(pimpl->stats, filename, pimpl->options.threads);
+        return true;
+    } catch (const std::exception& e) {
+        std::cerr << "Error exporting file: " << e.what() << std::endl;
+        return false;
     }
-    return DatabaseStats{};
 }
 
-void Parser::export_player_stats_csv(const std::string& filename) const {
-    // TODO: Implement
+bool Parser::export_stats_binary(const std::string& filename) const {
+    metrics::StageTimer timer(Stage::save);
+    try {
+        write_stats_binary(pimpl->stats, filename);
+        return true;
+    } catch (const std::exception& e) {
+        std::cerr << "Error exporting file: " << e.what() << std::endl;
+        return false;
+    }
 }
 
-void Parser::export_tournaments_csv(const std::string& filename) const {
-    // TODO: Implement
+bool Parser::export_opening_tree(const std::string& filename) const {
+    metrics::StageTimer timer(Stage::save);
+    try {
+        pimpl->opening_tree.save(filename);
+        return true;
+    } catch (const std::exception& e) {
+        std::cerr << "Error exporting file: " << e.what() << std::endl;
+        return false;
+    }
 }
 
-} // namespace pgn
\ No newline at end of file
+} // namespace pgn
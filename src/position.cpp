@@ -0,0 +1,616 @@
+#include "pgn/position.hpp"
+#include "attacks.hpp"
+
+namespace pgn {
+
+namespace {
+
+constexpr uint8_t no_piece = uint8_t(PieceType::none);
+
+constexpr int square_of(int file, int rank) { return rank * 8 + file; }
+constexpr int file_of(int square) { return square & 7; }
+constexpr int rank_of(int square) { return square >> 3; }
+
+inline int pop_lowest(Bitboard& bits) {
+    int square = __builtin_ctzll(bits);
+    bits &= bits - 1;
+    return square;
+}
+
+constexpr Bitboard bit(int square) { return Bitboard(1) << square; }
+
+constexpr Bitboard file_a = 0x0101010101010101ull;
+constexpr Bitboard rank_1 = 0xFFull;
+
+const char piece_letters[] = "PNBRQK";
+
+PieceType piece_from_letter(char c) {
+    switch (c) {
+    case 'N': return PieceType::knight;
+    case 'B': return PieceType::bishop;
+    case 'R': return PieceType::rook;
+    case 'Q': return PieceType::queen;
+    case 'K': return PieceType::king;
+    default: return PieceType::none;
+    }
+}
+
+// Castling rights kept after a move touches each square.
+constexpr uint8_t castling_keep(int square) {
+    switch (square) {
+    case 0: return 0xF & ~2;
+    case 4: return 0xF & ~3;
+    case 7: return 0xF & ~1;
+    case 56: return 0xF & ~8;
+    case 60: return 0xF & ~12;
+    case 63: return 0xF & ~4;
+    default: return 0xF;
+    }
+}
+
+Bitboard piece_attacks(PieceType type, int square, Bitboard occupied) {
+    switch (type) {
+    case PieceType::knight: return attacks::knight(square);
+    case PieceType::bishop: return attacks::bishop(square, occupied);
+    case PieceType::rook: return attacks::rook(square, occupied);
+    case PieceType::queen: return attacks::queen(square, occupied);
+    case PieceType::king: return attacks::king(square);
+    default: return 0;
+    }
+}
+
+// Random keys for Zobrist hashing, from a fixed seed so hashes are stable
+// across runs and can be stored.
+struct ZobristKeys {
+    uint64_t pieces[2][6][64];
+    uint64_t castling[16];
+    uint64_t en_passant[8];
+    uint64_t black_to_move;
+    
+    ZobristKeys() {
+        uint64_t state = 0x5A0B8157ull;
+        auto next = [&state]() {
+            uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+            return z ^ (z >> 31);
+        };
+        for (auto& color : pieces) {
+            for (auto& type : color) {
+                for (auto& key : type) key = next();
+            }
+        }
+        // Rights combine by XOR, so each set of rights has its own key.
+        uint64_t rights[4];
+        for (auto& key : rights) key = next();
+        for (int mask = 0; mask < 16; ++mask) {
+            castling[mask] = 0;
+            for (int i = 0; i < 4; ++i) {
+                if (mask & (1 << i)) castling[mask] ^= rights[i];
+            }
+        }
+        for (auto& key : en_passant) key = next();
+        black_to_move = next();
+    }
+};
+
+const ZobristKeys& zobrist() {
+    static const ZobristKeys keys;
+    return keys;
+}
+
+bool parse_square(char file, char rank, int& square) {
+    if (file < 'a' || file > 'h' || rank < '1' || rank > '8') return false;
+    square = square_of(file - 'a', rank - '1');
+    return true;
+}
+
+void append_square(std::string& out, int square) {
+    out += static_cast<char>('a' + file_of(square));
+    out += static_cast<char>('1' + rank_of(square));
+}
+
+} // namespace
+
+Position::Position() {
+    set_fen(start_fen);
+}
+
+void Position::clear() {
+    for (auto& bits : colors_) bits = 0;
+    for (auto& bits : types_) bits = 0;
+    for (auto& piece : board_) piece = no_piece;
+    side_ = Color::white;
+    castling_ = 0;
+    ep_square_ = -1;
+    halfmove_clock_ = 0;
+    fullmove_ = 1;
+    piece_key_ = 0;
+}
+
+void Position::put(int square, Color color, PieceType type) {
+    colors_[int(color)] |= bit(square);
+    types_[int(type)] |= bit(square);
+    board_[square] = uint8_t(type);
+    piece_key_ ^= zobrist().pieces[int(color)][int(type)][square];
+}
+
+void Position::remove(int square) {
+    Color color = (colors_[1] & bit(square)) ? Color::black : Color::white;
+    piece_key_ ^= zobrist().pieces[int(color)][board_[square]][square];
+    Bitboard mask = ~bit(square);
+    colors_[0] &= mask;
+    colors_[1] &= mask;
+    types_[board_[square]] &= mask;
+    board_[square] = no_piece;
+}
+
+bool Position::set_fen(std::string_view fen) {
+    Position result(*this);
+    result.clear();
+    
+    size_t pos = 0;
+    auto field = [&]() {
+        while (pos < fen.size() && fen[pos] == ' ') pos++;
+        size_t start = pos;
+        while (pos < fen.size() && fen[pos] != ' ') pos++;
+        return fen.substr(start, pos - start);
+    };
+    
+    std::string_view placement = field();
+    int file = 0, rank = 7;
+    for (char c : placement) {
+        if (c == '/') {
+            if (file != 8 || rank == 0) return false;
+            file = 0;
+            rank--;
+        } else if (c >= '1' && c <= '8') {
+            file += c - '0';
+            if (file > 8) return false;
+        } else {
+            Color color = (c >= 'a' && c <= 'z') ? Color::black : Color::white;
+            PieceType type = c == 'P' || c == 'p' ? PieceType::pawn
+                                                  : piece_from_letter(static_cast<char>(c & ~0x20));
+            if (type == PieceType::none || file >= 8) return false;
+            result.put(square_of(file, rank), color, type);
+            file++;
+        }
+    }
+    if (file != 8 || rank != 0) return false;
+    if (__builtin_popcountll(result.pieces(Color::white, PieceType::king)) != 1 ||
+        __builtin_popcountll(result.pieces(Color::black, PieceType::king)) != 1) {
+        return false;
+    }
+    
+    std::string_view side = field();
+    if (side == "w") result.side_ = Color::white;
+    else if (side == "b") result.side_ = Color::black;
+    else return false;
+    
+    std::string_view castling = field();
+    if (castling != "-") {
+        for (char c : castling) {
+            switch (c) {
+            case 'K': result.castling_ |= 1; break;
+            case 'Q': result.castling_ |= 2; break;
+            case 'k': result.castling_ |= 4; break;
+            case 'q': result.castling_ |= 8; break;
+            default: return false;
+            }
+        }
+    }
+    
+    std::string_view ep = field();
+    if (ep != "-") {
+        int square;
+        if (ep.size() != 2 || !parse_square(ep[0], ep[1], square)) return false;
+        result.ep_square_ = static_cast<int8_t>(square);
+    }
+    
+    std::string_view halfmove = field();
+    std::string_view fullmove = field();
+    auto number = [](std::string_view text, int& value) {
+        if (text.empty() || text.size() > 6) return text.empty();
+        int parsed = 0;
+        for (char c : text) {
+            if (c < '0' || c > '9') return false;
+            parsed = parsed * 10 + (c - '0');
+        }
+        value = parsed;
+        return true;
+    };
+    if (!number(halfmove, result.halfmove_clock_) || !number(fullmove, result.fullmove_)) {
+        return false;
+    }
+    
+    // The side that just moved cannot be left in check.
+    int their_king = __builtin_ctzll(result.pieces(~result.side_, PieceType::king));
+    if (result.attacked(their_king, result.side_)) return false;
+    
+    *this = result;
+    return true;
+}
+
+std::string Position::fen() const {
+    std::string out;
+    for (int rank = 7; rank >= 0; --rank) {
+        int empty = 0;
+        for (int file = 0; file < 8; ++file) {
+            int square = square_of(file, rank);
+            if (board_[square] == no_piece) {
+                empty++;
+                continue;
+            }
+            if (empty) out += static_cast<char>('0' + empty);
+            empty = 0;
+            char letter = piece_letters[board_[square]];
+            out += (colors_[1] & bit(square)) ? static_cast<char>(letter | 0x20) : letter;
+        }
+        if (empty) out += static_cast<char>('0' + empty);
+        if (rank) out += '/';
+    }
+    out += side_ == Color::white ? " w " : " b ";
+    if (!castling_) out += '-';
+    if (castling_ & 1) out += 'K';
+    if (castling_ & 2) out += 'Q';
+    if (castling_ & 4) out += 'k';
+    if (castling_ & 8) out += 'q';
+    out += ' ';
+    if (ep_square_ < 0) out += '-';
+    else append_square(out, ep_square_);
+    out += ' ';
+    out += std::to_string(halfmove_clock_);
+    out += ' ';
+    out += std::to_string(fullmove_);
+    return out;
+}
+
+uint64_t Position::hash() const {
+    const ZobristKeys& keys = zobrist();
+    uint64_t key = piece_key_ ^ keys.castling[castling_];
+    if (side_ == Color::black) key ^= keys.black_to_move;
+    // Only an en passant capture that is available changes the position.
+    if (ep_square_ >= 0 && (attacks::pawn(~side_, ep_square_) & pieces(side_, PieceType::pawn))) {
+        key ^= keys.en_passant[file_of(ep_square_)];
+    }
+    return key;
+}
+
+Bitboard Position::attackers(int square, Color by, Bitboard occupied) const {
+    Bitboard them = colors_[int(by)];
+    Bitboard diagonal = types_[int(PieceType::bishop)] | types_[int(PieceType::queen)];
+    Bitboard straight = types_[int(PieceType::rook)] | types_[int(PieceType::queen)];
+    return them & ((attacks::pawn(~by, square) & types_[int(PieceType::pawn)]) |
+                   (attacks::knight(square) & types_[int(PieceType::knight)]) |
+                   (attacks::king(square) & types_[int(PieceType::king)]) |
+                   (attacks::bishop(square, occupied) & diagonal) |
+                   (attacks::rook(square, occupied) & straight));
+}
+
+bool Position::attacked(int square, Color by) const {
+    return attackers(square, by, occupied()) != 0;
+}
+
+bool Position::in_check() const {
+    int king = __builtin_ctzll(pieces(side_, PieceType::king));
+    return attacked(king, ~side_);
+}
+
+// Whether the side to move's king is safe after `move`, which must be
+// pseudo-legal and not castling. Captured pieces are masked out of the
+// attackers; moving pieces are moved in the occupancy.
+bool Position::leaves_king_safe(const Move& move) const {
+    Bitboard occupied = this->occupied() ^ bit(move.from);
+    Bitboard captured = bit(move.to);
+    if (move.kind == Move::en_passant) {
+        int victim = move.to + (side_ == Color::white ? -8 : 8);
+        occupied ^= bit(victim);
+        captured |= bit(victim);
+    }
+    occupied |= bit(move.to);
+    
+    int king = board_[move.from] == uint8_t(PieceType::king)
+        ? move.to
+        : __builtin_ctzll(pieces(side_, PieceType::king));
+    return (attackers(king, ~side_, occupied) & ~captured) == 0;
+}
+
+void Position::add_castling(MoveList& moves) const {
+    uint8_t rights = side_ == Color::white ? castling_ & 3 : castling_ >> 2 & 3;
+    if (!rights) return;
+    
+    Move move;
+    if (parse_castling(true, move)) moves.push(move);
+    if (parse_castling(false, move)) moves.push(move);
+}
+
+bool Position::parse_castling(bool king_side, Move& move) const {
+    int base = side_ == Color::white ? 0 : 56;
+    uint8_t right = uint8_t((king_side ? 1 : 2) << (side_ == Color::white ? 0 : 2));
+    if (!(castling_ & right)) return false;
+    
+    int king = base + 4;
+    int rook = base + (king_side ? 7 : 0);
+    int target = base + (king_side ? 6 : 2);
+    int passed = base + (king_side ? 5 : 3);
+    if (!(pieces(side_, PieceType::king) & bit(king)) || !(pieces(side_, PieceType::rook) & bit(rook))) {
+        return false;
+    }
+    if (attacks::between(king, rook) & occupied()) return false;
+    if (attacked(king, ~side_) || attacked(passed, ~side_) || attacked(target, ~side_)) return false;
+    
+    move = Move{uint8_t(king), uint8_t(target), Move::castling, PieceType::none};
+    return true;
+}
+
+void Position::legal_moves(MoveList& moves) const {
+    moves.count = 0;
+    Color us = side_;
+    Bitboard own = colors_[int(us)];
+    Bitboard enemy = colors_[int(~us)];
+    Bitboard occupied = own | enemy;
+    
+    auto add = [&](int from, int to, Move::Kind kind) {
+        Move move{uint8_t(from), uint8_t(to), kind, PieceType::none};
+        if (leaves_king_safe(move)) moves.push(move);
+    };
+    auto add_promotions = [&](int from, int to) {
+        Move move{uint8_t(from), uint8_t(to), Move::promotion, PieceType::queen};
+        if (!leaves_king_safe(move)) return;
+        for (PieceType type : {PieceType::queen, PieceType::rook, PieceType::bishop, PieceType::knight}) {
+            move.promoted = type;
+            moves.push(move);
+        }
+    };
+    
+    // Pawns.
+    int forward = us == Color::white ? 8 : -8;
+    Bitboard last_rank = us == Color::white ? rank_1 << 56 : rank_1;
+    Bitboard double_rank = us == Color::white ? rank_1 << 16 : rank_1 << 40;
+    Bitboard pawns = pieces(us, PieceType::pawn);
+    while (pawns) {
+        int from = pop_lowest(pawns);
+        int to = from + forward;
+        if (!(occupied & bit(to))) {
+            if (bit(to) & last_rank) {
+                add_promotions(from, to);
+            } else {
+                add(from, to, Move::normal);
+                if ((bit(to) & double_rank) && !(occupied & bit(to + forward))) {
+                    add(from, to + forward, Move::double_push);
+                }
+            }
+        }
+        Bitboard captures = attacks::pawn(us, from) & enemy;
+        while (captures) {
+            int target = pop_lowest(captures);
+            if (bit(target) & last_rank) add_promotions(from, target);
+            else add(from, target, Move::normal);
+        }
+        if (ep_square_ >= 0 && (attacks::pawn(us, from) & bit(ep_square_))) {
+            add(from, ep_square_, Move::en_passant);
+        }
+    }
+    
+    // Pieces.
+    for (PieceType type : {PieceType::knight, PieceType::bishop, PieceType::rook,
+                           PieceType::queen, PieceType::king}) {
+        Bitboard from_set = pieces(us, type);
+        while (from_set) {
+            int from = pop_lowest(from_set);
+            Bitboard targets = piece_attacks(type, from, occupied) & ~own;
+            while (targets) add(from, pop_lowest(targets), Move::normal);
+        }
+    }
+    
+    add_castling(moves);
+}
+
+bool Position::is_legal(const Move& move) const {
+    MoveList moves;
+    legal_moves(moves);
+    for (const Move& candidate : moves) {
+        if (candidate == move) return true;
+    }
+    return false;
+}
+
+void Position::play(const Move& move) {
+    Color us = side_;
+    if (move.kind != Move::null_move) {
+        PieceType type = piece_on(move.from);
+        bool capture = board_[move.to] != no_piece;
+        halfmove_clock_ = (type == PieceType::pawn || capture) ? 0 : halfmove_clock_ + 1;
+        
+        if (capture) remove(move.to);
+        if (move.kind == Move::en_passant) remove(move.to + (us == Color::white ? -8 : 8));
+        remove(move.from);
+        put(move.to, us, move.kind == Move::promotion ? move.promoted : type);
+        
+        if (move.kind == Move::castling) {
+            bool king_side = move.to > move.from;
+            int rook_from = king_side ? move.to + 1 : move.to - 2;
+            int rook_to = king_side ? move.to - 1 : move.to + 1;
+            remove(rook_from);
+            put(rook_to, us, PieceType::rook);
+        }
+        castling_ &= castling_keep(move.from) & castling_keep(move.to);
+    } else {
+        halfmove_clock_++;
+    }
+    
+    ep_square_ = move.kind == Move::double_push ? static_cast<int8_t>((move.from + move.to) / 2) : -1;
+    if (us == Color::black) fullmove_++;
+    side_ = ~us;
+}
+
+bool Position::parse_san(std::string_view san, Move& move) const {
+    while (!san.empty() && (san.back() == '+' || san.back() == '#' || san.back() == '!' ||
+                            san.back() == '?')) {
+        san.remove_suffix(1);
+    }
+    if (san.size() < 2) return false;
+    
+    if (san == "O-O" || san == "0-0") return parse_castling(true, move);
+    if (san == "O-O-O" || san == "0-0-0") return parse_castling(false, move);
+    if (san == "--" || san == "Z0") {
+        if (in_check()) return false;
+        move = Move{0, 0, Move::null_move, PieceType::none};
+        return true;
+    }
+    
+    PieceType type = piece_from_letter(san[0]);
+    if (type != PieceType::none) san.remove_prefix(1);
+    else type = PieceType::pawn;
+    
+    PieceType promotion = PieceType::none;
+    if (type == PieceType::pawn && san.size() >= 3) {
+        PieceType promoted = piece_from_letter(san.back());
+        if (promoted != PieceType::none && promoted != PieceType::king) {
+            promotion = promoted;
+            san.remove_suffix(1);
+            if (san.back() == '=') san.remove_suffix(1);
+        }
+    }
+    
+    int to;
+    if (san.size() < 2 || !parse_square(san[san.size() - 2], san.back(), to)) return false;
+    san.remove_suffix(2);
+    bool capture_mark = false;
+    if (!san.empty() && (san.back() == 'x' || san.back() == ':' || san.back() == '-')) {
+        capture_mark = san.back() != '-';
+        san.remove_suffix(1);
+    }
+    
+    // Disambiguation: a file, a rank, or both.
+    Bitboard from_mask = ~Bitboard(0);
+    if (san.size() == 2) {
+        int from;
+        if (!parse_square(san[0], san[1], from)) return false;
+        from_mask = bit(from);
+    } else if (san.size() == 1) {
+        if (san[0] >= 'a' && san[0] <= 'h') from_mask = file_a << (san[0] - 'a');
+        else if (san[0] >= '1' && san[0] <= '8') from_mask = rank_1 << (8 * (san[0] - '1'));
+        else return false;
+    } else if (!san.empty()) {
+        return false;
+    }
+    
+    Color us = side_;
+    Bitboard own = colors_[int(us)];
+    if (own & bit(to)) return false;
+    bool target_occupied = board_[to] != no_piece;
+    
+    Move found{};
+    int matches = 0;
+    auto consider = [&](int from, Move::Kind kind) {
+        Move candidate{uint8_t(from), uint8_t(to), kind, promotion};
+        if (leaves_king_safe(candidate)) {
+            found = candidate;
+            matches++;
+        }
+    };
+    
+    if (type == PieceType::pawn) {
+        bool last_rank = rank_of(to) == (us == Color::white ? 7 : 0);
+        if (last_rank != (promotion != PieceType::none)) return false;
+        Move::Kind kind = last_rank ? Move::promotion : Move::normal;
+        int forward = us == Color::white ? 8 : -8;
+        Bitboard pawns = pieces(us, PieceType::pawn) & from_mask;
+        
+        if (from_mask != ~Bitboard(0) && (from_mask & file_a << file_of(to)) == 0) {
+            // A capture: the pawn comes from an adjacent file.
+            Bitboard from_set = attacks::pawn(~us, to) & pawns;
+            bool en_passant = to == ep_square_ && !target_occupied;
+            if (!target_occupied && !en_passant) return false;
+            while (from_set) consider(pop_lowest(from_set), en_passant ? Move::en_passant : kind);
+        } else {
+            if (target_occupied || capture_mark) return false;
+            int from = to - forward;
+            if (pawns & bit(from)) {
+                consider(from, kind);
+            } else if (board_[from] == no_piece && (pawns & bit(from - forward)) &&
+                       rank_of(to) == (us == Color::white ? 3 : 4)) {
+                consider(from - forward, Move::double_push);
+            }
+        }
+    } else {
+        if (promotion != PieceType::none) return false;
+        Bitboard from_set = piece_attacks(type, to, occupied()) & pieces(us, type) & from_mask;
+        while (from_set) consider(pop_lowest(from_set), Move::normal);
+    }
+    
+    if (matches != 1) return false;
+    move = found;
+    return true;
+}
+
+std::string Position::san(const Move& move) const {
+    std::string out;
+    if (move.kind == Move::null_move) return "--";
+    if (move.kind == Move::castling) {
+        out = move.to > move.from ? "O-O" : "O-O-O";
+    } else {
+        PieceType type = piece_on(move.from);
+        bool capture = board_[move.to] != no_piece || move.kind == Move::en_passant;
+        if (type == PieceType::pawn) {
+            if (capture) {
+                out += static_cast<char>('a' + file_of(move.from));
+                out += 'x';
+            }
+            append_square(out, move.to);
+            if (move.kind == Move::promotion) {
+                out += '=';
+                out += piece_letters[int(move.promoted)];
+            }
+        } else {
+            out += piece_letters[int(type)];
+            Bitboard others = piece_attacks(type, move.to, occupied()) & pieces(side_, type) & ~bit(move.from);
+            bool same_file = false, same_rank = false, ambiguous = false;
+            while (others) {
+                int other = pop_lowest(others);
+                if (!leaves_king_safe(Move{uint8_t(other), move.to, Move::normal, PieceType::none})) continue;
+                ambiguous = true;
+                same_file |= file_of(other) == file_of(move.from);
+                same_rank |= rank_of(other) == rank_of(move.from);
+            }
+            if (ambiguous) {
+                if (!same_file) {
+                    out += static_cast<char>('a' + file_of(move.from));
+                } else if (!same_rank) {
+                    out += static_cast<char>('1' + rank_of(move.from));
+                } else {
+                    append_square(out, move.from);
+                }
+            }
+            if (capture) out += 'x';
+            append_square(out, move.to);
+        }
+    }
+    
+    Position after = *this;
+    after.play(move);
+    if (after.in_check()) {
+        MoveList replies;
+        after.legal_moves(replies);
+        out += replies.size() ? '+' : '#';
+    }
+    return out;
+}
+
+uint64_t perft(const Position& position, int depth) {
+    if (depth <= 0) return 1;
+    MoveList moves;
+    position.legal_moves(moves);
+    if (depth == 1) return moves.size();
+    
+    uint64_t nodes = 0;
+    for (const Move& move : moves) {
+        Position next = position;
+        next.play(move);
+        nodes += perft(next, depth - 1);
+    }
+    return nodes;
+}
+
+} // namespace pgn
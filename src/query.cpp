@@ -0,0 +1,243 @@
+#include "pgn/query.hpp"
+#include <algorithm>
+#include <optional>
+#include <stdexcept>
+
+namespace pgn {
+
+namespace {
+
+constexpr uint16_t max_elo = raw_elo - 1;
+
+uint16_t clamp_elo(int value) {
+    return static_cast<uint16_t>(std::clamp(value, 1, int(max_elo)));
+}
+
+bool in_range(uint32_t value, uint32_t min, uint32_t max) {
+    return value >= min && value <= max;
+}
+
+uint32_t parse_date(std::string_view text) {
+    uint32_t date = encode_date(text);
+    if (!date_known(date)) throw std::invalid_argument("Invalid date: " + std::string(text));
+    return date;
+}
+
+uint16_t parse_eco(std::string_view text) {
+    uint16_t code = encode_eco(text);
+    if (code == 0 || code == raw_eco) throw std::invalid_argument("Invalid ECO code: " + std::string(text));
+    return code;
+}
+
+// Slices of `game`, for running where() predicates on a table row.
+GameView view_of(const Game& game, uint64_t offset) {
+    GameView view;
+    view.event = game.event.str();
+    view.site = game.site.str();
+    view.date = game.date;
+    view.round = game.round;
+    view.white = game.white.str();
+    view.black = game.black.str();
+    view.result = game.result;
+    view.white_elo = game.white_elo;
+    view.black_elo = game.black_elo;
+    view.eco = game.eco.str();
+    view.opening = game.opening.str();
+    view.move_count = game.move_count;
+    view.offset = offset;
+    return view;
+}
+
+} // namespace
+
+Query& Query::white_elo(int min, int max) {
+    white_elo_min_ = clamp_elo(min);
+    white_elo_max_ = clamp_elo(max);
+    checks_ |= white_elo_check;
+    return *this;
+}
+
+Query& Query::black_elo(int min, int max) {
+    black_elo_min_ = clamp_elo(min);
+    black_elo_max_ = clamp_elo(max);
+    checks_ |= black_elo_check;
+    return *this;
+}
+
+Query& Query::min_elo(int min) {
+    return white_elo(min, max_elo).black_elo(min, max_elo);
+}
+
+Query& Query::date(std::string_view from, std::string_view to) {
+    date_min_ = parse_date(from);
+    date_max_ = parse_date(to);
+    // Unknown parts of the upper bound extend it to the end of the period.
+    if (date_month(date_max_) == 0) date_max_ |= 12u << 5;
+    if (date_day(date_max_) == 0) date_max_ |= 31u;
+    checks_ |= date_check;
+    return *this;
+}
+
+Query& Query::year(int from, int to) {
+    if (from < 0 || to < 0 || from > 9999 || to > 9999) {
+        throw std::invalid_argument("Invalid year range");
+    }
+    date_min_ = 1u << 31 | uint32_t(from + 1) << 9;
+    date_max_ = 1u << 31 | uint32_t(to + 1) << 9 | 12u << 5 | 31u;
+    checks_ |= date_check;
+    return *this;
+}
+
+Query& Query::eco(std::string_view from, std::string_view to) {
+    eco_min_ = parse_eco(from);
+    eco_max_ = parse_eco(to);
+    checks_ |= eco_check;
+    return *this;
+}
+
+Query& Query::player(std::string_view name) {
+    players_.emplace_back(name);
+    checks_ |= player_check;
+    return *this;
+}
+
+Query& Query::white(std::string_view name) {
+    white_ = name;
+    checks_ |= white_check;
+    return *this;
+}
+
+Query& Query::black(std::string_view name) {
+    black_ = name;
+    checks_ |= black_check;
+    return *this;
+}
+
+Query& Query::event(std::string_view name) {
+    event_ = name;
+    checks_ |= event_check;
+    return *this;
+}
+
+Query& Query::result(GameResult result) {
+    results_ |= static_cast<uint8_t>(1u << static_cast<unsigned>(result));
+    checks_ |= result_check;
+    return *this;
+}
+
+Query& Query::moves(int min, int max) {
+    moves_min_ = min;
+    moves_max_ = max;
+    checks_ |= moves_check;
+    return *this;
+}
+
+Query& Query::where(Predicate predicate) {
+    predicates_.push_back(std::move(predicate));
+    checks_ |= predicate_check;
+    return *this;
+}
+
+// Cheapest checks first: byte compares, then small parses, then names.
+bool Query::matches_tags(const GameView& game) const {
+    if (checks_ & result_check) {
+        if (!(results_ >> static_cast<unsigned>(parse_result(game.result)) & 1)) return false;
+    }
+    if ((checks_ & white_elo_check) &&
+        !in_range(encode_elo(game.white_elo), white_elo_min_, white_elo_max_)) {
+        return false;
+    }
+    if ((checks_ & black_elo_check) &&
+        !in_range(encode_elo(game.black_elo), black_elo_min_, black_elo_max_)) {
+        return false;
+    }
+    if ((checks_ & eco_check) && !in_range(encode_eco(game.eco), eco_min_, eco_max_)) {
+        return false;
+    }
+    if ((checks_ & date_check) && !in_range(encode_date(game.date), date_min_, date_max_)) {
+        return false;
+    }
+    if ((checks_ & event_check) && game.event != event_) return false;
+    if ((checks_ & white_check) && game.white != white_) return false;
+    if ((checks_ & black_check) && game.black != black_) return false;
+    for (const std::string& name : players_) {
+        if (game.white != name && game.black != name) return false;
+    }
+    return true;
+}
+
+bool Query::matches_rest(const GameView& game) const {
+    if ((checks_ & moves_check) && (game.move_count < moves_min_ || game.move_count > moves_max_)) {
+        return false;
+    }
+    for (const Predicate& predicate : predicates_) {
+        if (!predicate(game)) return false;
+    }
+    return true;
+}
+
+std::vector<size_t> Query::select(const GameTable& table) const {
+    std::vector<size_t> rows;
+    
+    // Names are compared as symbols; a name that was never interned
+    // cannot occur in the table.
+    auto symbol_of = [](const std::string& name) {
+        return SymbolTable::global().find(name);
+    };
+    std::optional<Symbol> event, white, black;
+    std::vector<Symbol> players;
+    if (checks_ & event_check) {
+        if (!(event = symbol_of(event_))) return rows;
+    }
+    if (checks_ & white_check) {
+        if (!(white = symbol_of(white_))) return rows;
+    }
+    if (checks_ & black_check) {
+        if (!(black = symbol_of(black_))) return rows;
+    }
+    for (const std::string& name : players_) {
+        auto symbol = symbol_of(name);
+        if (!symbol) return rows;
+        players.push_back(*symbol);
+    }
+    
+    for (size_t i = 0; i < table.size(); ++i) {
+        if ((checks_ & result_check) && !(results_ >> static_cast<unsigned>(table.result(i)) & 1)) {
+            continue;
+        }
+        if ((checks_ & white_elo_check) &&
+            !in_range(table.white_elos()[i], white_elo_min_, white_elo_max_)) {
+            continue;
+        }
+        if ((checks_ & black_elo_check) &&
+            !in_range(table.black_elos()[i], black_elo_min_, black_elo_max_)) {
+            continue;
+        }
+        if ((checks_ & eco_check) && !in_range(table.eco_codes()[i], eco_min_, eco_max_)) continue;
+        if ((checks_ & date_check) && !in_range(table.dates()[i], date_min_, date_max_)) continue;
+        if (event && table.events()[i] != *event) continue;
+        if (white && table.whites()[i] != *white) continue;
+        if (black && table.blacks()[i] != *black) continue;
+        if (!std::all_of(players.begin(), players.end(), [&](Symbol player) {
+                return table.whites()[i] == player || table.blacks()[i] == player;
+            })) {
+            continue;
+        }
+        if ((checks_ & moves_check) &&
+            (table.move_counts()[i] < moves_min_ || table.move_counts()[i] > moves_max_)) {
+            continue;
+        }
+        if (!predicates_.empty()) {
+            Game game = table.row(i);
+            GameView view = view_of(game, table.offsets()[i]);
+            if (!std::all_of(predicates_.begin(), predicates_.end(),
+                             [&](const Predicate& predicate) { return predicate(view); })) {
+                continue;
+            }
+        }
+        rows.push_back(i);
+    }
+    return rows;
+}
+
+} // namespace pgn
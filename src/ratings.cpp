@@ -0,0 +1,172 @@
+#include "pgn/ratings.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace pgn {
+
+namespace {
+
+void put_varint(std::pmr::vector<uint8_t>& out, uint32_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+size_t varint_size(uint32_t value) {
+    size_t size = 1;
+    for (; value >= 0x80; value >>= 7) ++size;
+    return size;
+}
+
+uint32_t get_varint(const uint8_t*& in) {
+    uint32_t value = 0;
+    for (unsigned shift = 0;; shift += 7) {
+        uint8_t byte = *in++;
+        value |= uint32_t(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) return value;
+    }
+}
+
+uint32_t zigzag(int32_t value) {
+    return (static_cast<uint32_t>(value) << 1) ^ static_cast<uint32_t>(value >> 31);
+}
+
+int32_t unzigzag(uint32_t value) {
+    return static_cast<int32_t>(value >> 1) ^ -static_cast<int32_t>(value & 1);
+}
+
+} // namespace
+
+// Each point is the date's delta from the previous point, then the
+// rating's zigzagged delta; the first point is relative to zero.
+template <typename Visit>
+void RatingHistory::decode(Visit visit) const {
+    const uint8_t* in = encoded_.data();
+    RatingPoint point;
+    for (uint32_t i = 0; i < count_; ++i) {
+        point.date += get_varint(in);
+        point.elo = static_cast<uint16_t>(point.elo + unzigzag(get_varint(in)));
+        visit(point);
+    }
+}
+
+void RatingHistory::merge(RatingHistory&& later) {
+    later.decode([&](const RatingPoint& point) { pending_.push_back(uint64_t(point.date) << 16 | point.elo); });
+    pending_.insert(pending_.end(), later.pending_.begin(), later.pending_.end());
+    later = RatingHistory();
+    seal();
+}
+
+// Points that all follow the series, as they do when games arrive in date
+// order, are appended to it; otherwise the series is decoded, merged with
+// them and encoded again.
+void RatingHistory::fold() {
+    if (pending_.empty()) return;
+    std::sort(pending_.begin(), pending_.end());
+    pending_.erase(std::unique(pending_.begin(), pending_.end()), pending_.end());
+    
+    uint64_t last = uint64_t(latest_.date) << 16 | latest_.elo;
+    RatingPoint previous;
+    auto encode = [&](uint64_t key) {
+        RatingPoint point{static_cast<uint32_t>(key >> 16), static_cast<uint16_t>(key)};
+        put_varint(encoded_, point.date - previous.date);
+        put_varint(encoded_, zigzag(int32_t(point.elo) - int32_t(previous.elo)));
+        peak_ = std::max(peak_, point.elo);
+        previous = point;
+    };
+    
+    if (count_ == 0 || pending_.front() > last) {
+        if (encoded_.empty()) {
+            // Most histories fold once, when sealed, so size that exactly.
+            size_t size = 0;
+            uint64_t before = 0;
+            for (uint64_t key : pending_) {
+                size += varint_size(static_cast<uint32_t>((key >> 16) - (before >> 16)));
+                size += varint_size(zigzag(int32_t(uint16_t(key)) - int32_t(uint16_t(before))));
+                before = key;
+            }
+            encoded_.reserve(size);
+        }
+        previous = latest_;
+        for (uint64_t key : pending_) encode(key);
+        count_ += static_cast<uint32_t>(pending_.size());
+    } else {
+        std::vector<uint64_t> keys;
+        keys.reserve(count_ + pending_.size());
+        decode([&](const RatingPoint& point) { keys.push_back(uint64_t(point.date) << 16 | point.elo); });
+        size_t middle = keys.size();
+        keys.insert(keys.end(), pending_.begin(), pending_.end());
+        std::inplace_merge(keys.begin(), keys.begin() + middle, keys.end());
+        keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+        
+        encoded_.clear();
+        peak_ = 0;
+        for (uint64_t key : keys) encode(key);
+        count_ = static_cast<uint32_t>(keys.size());
+    }
+    latest_ = previous;
+    pending_.clear();
+}
+
+void RatingHistory::seal() {
+    fold();
+    encoded_.shrink_to_fit();
+    pending_.shrink_to_fit();
+}
+
+std::vector<RatingPoint> RatingHistory::points() const {
+    std::vector<RatingPoint> points;
+    points.reserve(count_);
+    decode([&](const RatingPoint& point) { points.push_back(point); });
+    return points;
+}
+
+int TournamentScore::performance() const {
+    if (rated_games == 0) return 0;
+    double score = rated_half_points / (2.0 * rated_games);
+    double difference = 800.0;
+    if (score <= 0.0) {
+        difference = -800.0;
+    } else if (score < 1.0) {
+        difference = std::clamp(400.0 * std::log10(score / (1.0 - score)), -800.0, 800.0);
+    }
+    return static_cast<int>(std::lround(average_opponent() + difference));
+}
+
+size_t EloHistogram::difference_bucket(int white_elo, int black_elo) {
+    int half = static_cast<int>(difference_buckets / 2) * bucket_width;
+    int shifted = std::clamp(white_elo - black_elo + half + bucket_width / 2, 0,
+                             static_cast<int>(difference_buckets) * bucket_width - 1);
+    return static_cast<size_t>(shifted / bucket_width);
+}
+
+size_t EloHistogram::rating_bucket(int white_elo, int black_elo) {
+    int mean = (white_elo + black_elo) / 2;
+    return std::min(static_cast<size_t>(mean / bucket_width), rating_buckets - 1);
+}
+
+void EloHistogram::add(int white_elo, int black_elo, int result) {
+    for (Bucket* bucket : {&by_difference[difference_bucket(white_elo, black_elo)],
+                           &by_rating[rating_bucket(white_elo, black_elo)]}) {
+        bucket->white_wins += result == 1;
+        bucket->black_wins += result == 2;
+        bucket->draws += result == 3;
+    }
+}
+
+void EloHistogram::merge(const EloHistogram& other) {
+    for (size_t i = 0; i < difference_buckets; ++i) {
+        by_difference[i].white_wins += other.by_difference[i].white_wins;
+        by_difference[i].black_wins += other.by_difference[i].black_wins;
+        by_difference[i].draws += other.by_difference[i].draws;
+    }
+    for (size_t i = 0; i < rating_buckets; ++i) {
+        by_rating[i].white_wins += other.by_rating[i].white_wins;
+        by_rating[i].black_wins += other.by_rating[i].black_wins;
+        by_rating[i].draws += other.by_rating[i].draws;
+    }
+}
+
+} // namespace pgn
@@ -0,0 +1,149 @@
+#include "pgn/reader.hpp"
+#include "async_io.hpp"
+#include "decompressor.hpp"
+#include "game_scanner.hpp"
+#include "mapped_file.hpp"
+#include "metrics_counters.hpp"
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+
+namespace pgn {
+
+namespace {
+
+constexpr size_t block_size = 4 << 20;
+constexpr size_t discard_window = 64 << 20;
+
+} // namespace
+
+struct GameReader::Impl {
+    MappedFile mapping;
+    bool mapped = false;
+    size_t discarded = 0;
+    
+    std::unique_ptr<ReadAhead> read_ahead;
+    std::ifstream stream;
+    std::unique_ptr<Decompressor> decompressor;
+    std::string block;
+    std::string buffer;
+    // The text being scanned, when reading ahead.
+    std::string_view window;
+    uint64_t buffer_offset = 0;
+    bool eof = false;
+    
+    GameScanner scanner;
+    Query query;
+    
+    bool next_mapped(GameView& game);
+    bool next_buffered(GameView& game);
+    void refill();
+};
+
+GameReader::GameReader(const std::string& filename, const ParserOptions& options)
+    : pimpl(std::make_unique<Impl>()) {
+    pimpl->scanner.set_replay(options.replay_moves);
+    Compression compression = detect_compression(filename);
+    if (compression != Compression::none) {
+        pimpl->decompressor = std::make_unique<Decompressor>(filename, compression);
+        pimpl->scanner.reset(std::string_view(), false);
+        return;
+    }
+    
+    if (options.use_mmap) {
+        try {
+            pimpl->mapping.open(filename);
+            pimpl->mapped = true;
+            pimpl->scanner.reset(pimpl->mapping.view());
+            return;
+        } catch (const std::exception&) {
+            // Fall back to buffered reads below.
+        }
+    }
+    
+    std::error_code error;
+    if (std::filesystem::is_regular_file(filename, error)) {
+        pimpl->read_ahead = std::make_unique<ReadAhead>(filename, options.use_io_uring, block_size);
+        pimpl->scanner.reset(std::string_view(), false);
+        return;
+    }
+    
+    pimpl->stream.open(filename, std::ios::binary);
+    if (!pimpl->stream.is_open()) {
+        throw std::runtime_error("Cannot open file: " + filename);
+    }
+    pimpl->scanner.reset(std::string_view(), false);
+}
+
+GameReader::~GameReader() = default;
+
+void GameReader::set_query(const Query& query) {
+    pimpl->query = query;
+    pimpl->scanner.set_filter(query.empty() ? nullptr : &pimpl->query);
+}
+
+bool GameReader::next(GameView& game) {
+    metrics::StageTimer timer(Stage::scan);
+    return pimpl->mapped ? pimpl->next_mapped(game) : pimpl->next_buffered(game);
+}
+
+bool GameReader::next(Game& game) {
+    GameView view;
+    if (!next(view)) return false;
+    game = view.to_game();
+    return true;
+}
+
+uint64_t GameReader::bytes_read() const {
+    return pimpl->buffer_offset + pimpl->scanner.position();
+}
+
+bool GameReader::Impl::next_mapped(GameView& game) {
+    size_t game_start = scanner.position();
+    if (!scanner.next(game)) return false;
+    
+    if (game_start - discarded >= discard_window) {
+        mapping.discard_before(game_start);
+        discarded = game_start;
+    }
+    return true;
+}
+
+bool GameReader::Impl::next_buffered(GameView& game) {
+    for (;;) {
+        if (scanner.next(game)) return true;
+        if (eof) return false;
+        refill();
+    }
+}
+
+void GameReader::Impl::refill() {
+    metrics::StageTimer timer(Stage::read);
+    size_t consumed = scanner.position();
+    if (read_ahead) {
+        std::string_view text;
+        eof = !read_ahead->next(window.substr(consumed), text) || read_ahead->finished();
+        window = text;
+        buffer_offset = read_ahead->offset();
+        scanner.reset(window, eof, buffer_offset);
+        return;
+    }
+    
+    buffer.erase(0, consumed);
+    buffer_offset += consumed;
+    
+    if (decompressor) {
+        if (decompressor->next_block(block)) buffer += block;
+        else eof = true;
+    } else {
+        size_t used = buffer.size();
+        buffer.resize(used + block_size);
+        stream.read(&buffer[used], block_size);
+        buffer.resize(used + static_cast<size_t>(stream.gcount()));
+        if (!stream) eof = true;
+    }
+    
+    scanner.reset(buffer, eof, buffer_offset);
+}
+
+} // namespace pgn
@@ -0,0 +1,705 @@
+#include "pgn/server.hpp"
+#include <algorithm>
+#include <atomic>
+#include <list>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <cstring>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+#endif
+
+namespace pgn {
+
+namespace {
+
+// Longest request a server accepts; two names and some framing.
+constexpr uint32_t max_request_size = 1 << 17;
+
+class Encoder {
+public:
+    explicit Encoder(std::string& out) : out_(out) {}
+    
+    void u8(uint8_t value) { out_.push_back(static_cast<char>(value)); }
+    void u16(uint16_t value) { put(value, 2); }
+    void u32(uint32_t value) { put(value, 4); }
+    void i32(int32_t value) { put(static_cast<uint32_t>(value), 4); }
+    void u64(uint64_t value) { put(value, 8); }
+    
+    void str(std::string_view text) {
+        text = text.substr(0, 0xFFFF);
+        u16(static_cast<uint16_t>(text.size()));
+        out_.append(text);
+    }
+    
+    // A frame is its length followed by the bytes written between
+    // begin_frame() and end_frame().
+    size_t begin_frame() {
+        size_t start = out_.size();
+        u32(0);
+        return start;
+    }
+    
+    void end_frame(size_t start) {
+        uint32_t length = static_cast<uint32_t>(out_.size() - start - 4);
+        for (int i = 0; i < 4; ++i) out_[start + i] = static_cast<char>(length >> (8 * i));
+    }
+    
+private:
+    void put(uint64_t value, int bytes) {
+        for (int i = 0; i < bytes; ++i) out_.push_back(static_cast<char>(value >> (8 * i)));
+    }
+    
+    std::string& out_;
+};
+
+// Reads fields in order; once anything is missing, ok() turns false and
+// every further field reads as zero or empty.
+class Decoder {
+public:
+    explicit Decoder(std::string_view data) : data_(data) {}
+    
+    uint8_t u8() { return static_cast<uint8_t>(get(1)); }
+    uint16_t u16() { return static_cast<uint16_t>(get(2)); }
+    uint32_t u32() { return static_cast<uint32_t>(get(4)); }
+    int32_t i32() { return static_cast<int32_t>(static_cast<uint32_t>(get(4))); }
+    uint64_t u64() { return get(8); }
+    
+    std::string_view str() {
+        size_t length = u16();
+        if (length > data_.size()) {
+            ok_ = false;
+            return {};
+        }
+        std::string_view text = data_.substr(0, length);
+        data_.remove_prefix(length);
+        return text;
+    }
+    
+    bool ok() const { return ok_; }
+    bool done() const { return ok_ && data_.empty(); }
+    
+private:
+    uint64_t get(size_t bytes) {
+        if (bytes > data_.size()) {
+            ok_ = false;
+            data_ = {};
+            return 0;
+        }
+        uint64_t value = 0;
+        for (size_t i = 0; i < bytes; ++i) value |= uint64_t(static_cast<unsigned char>(data_[i])) << (8 * i);
+        data_.remove_prefix(bytes);
+        return value;
+    }
+    
+    std::string_view data_;
+    bool ok_ = true;
+};
+
+// One load of the server's files, never modified once published.
+struct Snapshot {
+    explicit Snapshot(const ParserOptions& options) : parser(options) {}
+    
+    Parser parser;
+    uint64_t generation = 0;
+    // Most games first, then the alphabetically first name.
+    std::vector<const PlayerStats*> players_by_games;
+    std::vector<const Tournament*> tournaments_by_games;
+    // Rows of each player's games in the game table, by the player's slot
+    // (numbered densely in order of first appearance):
+    // game_rows[game_offsets[slot] .. game_offsets[slot + 1]).
+    std::unordered_map<Symbol, uint32_t> player_slots;
+    std::vector<uint32_t> game_offsets;
+    std::vector<uint32_t> game_rows;
+};
+
+template <typename Entry>
+std::vector<const Entry*> ranked(const std::pmr::unordered_map<Symbol, Entry>& entries) {
+    std::vector<const Entry*> order;
+    order.reserve(entries.size());
+    for (const auto& [name, entry] : entries) order.push_back(&entry);
+    std::sort(order.begin(), order.end(), [](const Entry* a, const Entry* b) {
+        if (a->total_games != b->total_games) return a->total_games > b->total_games;
+        return a->name.str() < b->name.str();
+    });
+    return order;
+}
+
+void index_games(Snapshot& snapshot) {
+    const GameTable& table = snapshot.parser.get_game_table();
+    // Slots rather than symbol ids, which count every string ever interned.
+    auto& slots = snapshot.player_slots;
+    slots.reserve(snapshot.players_by_games.size());
+    std::vector<uint32_t> white_slots(table.size());
+    std::vector<uint32_t> black_slots(table.size());
+    for (size_t i = 0; i < table.size(); ++i) {
+        white_slots[i] = slots.try_emplace(table.whites()[i], uint32_t(slots.size())).first->second;
+        black_slots[i] = slots.try_emplace(table.blacks()[i], uint32_t(slots.size())).first->second;
+    }
+    
+    std::vector<uint32_t>& offsets = snapshot.game_offsets;
+    offsets.assign(slots.size() + 1, 0);
+    for (size_t i = 0; i < table.size(); ++i) {
+        offsets[white_slots[i] + 1]++;
+        if (black_slots[i] != white_slots[i]) offsets[black_slots[i] + 1]++;
+    }
+    for (size_t slot = 1; slot < offsets.size(); ++slot) offsets[slot] += offsets[slot - 1];
+    
+    std::vector<uint32_t> next(offsets.begin(), offsets.end() - 1);
+    snapshot.game_rows.resize(offsets.back());
+    for (size_t i = 0; i < table.size(); ++i) {
+        snapshot.game_rows[next[white_slots[i]]++] = static_cast<uint32_t>(i);
+        if (black_slots[i] != white_slots[i]) {
+            snapshot.game_rows[next[black_slots[i]]++] = static_cast<uint32_t>(i);
+        }
+    }
+}
+
+HeadToHead head_to_head(const Snapshot& snapshot, Symbol first, Symbol second) {
+    HeadToHead result;
+    const GameTable& table = snapshot.parser.get_game_table();
+    auto first_slot = snapshot.player_slots.find(first);
+    auto second_slot = snapshot.player_slots.find(second);
+    if (first_slot == snapshot.player_slots.end() || second_slot == snapshot.player_slots.end()) {
+        return result;
+    }
+    auto games_of = [&](uint32_t slot) {
+        return snapshot.game_offsets[slot + 1] - snapshot.game_offsets[slot];
+    };
+    // Walk whichever player has fewer games.
+    uint32_t walked = games_of(first_slot->second) <= games_of(second_slot->second)
+                          ? first_slot->second : second_slot->second;
+    
+    for (uint32_t k = snapshot.game_offsets[walked]; k < snapshot.game_offsets[walked + 1]; ++k) {
+        uint32_t row = snapshot.game_rows[k];
+        Symbol white = table.whites()[row];
+        Symbol black = table.blacks()[row];
+        if (!((white == first && black == second) || (white == second && black == first))) continue;
+        
+        result.games++;
+        GameResult outcome = table.result(row);
+        if (outcome == GameResult::draw) {
+            result.draws++;
+        } else if (outcome == GameResult::white_win) {
+            (white == first ? result.first_wins : result.second_wins)++;
+        } else if (outcome == GameResult::black_win) {
+            (black == first ? result.first_wins : result.second_wins)++;
+        }
+    }
+    return result;
+}
+
+template <typename Entry>
+void write_ranked(const std::vector<const Entry*>& order, uint32_t count, Encoder& out) {
+    count = static_cast<uint32_t>(std::min<size_t>(count, order.size()));
+    out.u32(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        out.str(order[i]->name.str());
+        out.i32(order[i]->total_games);
+    }
+}
+
+// Answers one lookup from `snapshot`, writing the status and fields.
+void answer(const Snapshot& snapshot, StatsOp op, Decoder& in, Encoder& out) {
+    const DatabaseStats& stats = snapshot.parser.get_stats();
+    auto find = [](std::string_view name) { return SymbolTable::global().find(name); };
+    
+    switch (op) {
+        case StatsOp::summary: {
+            if (!in.done()) break;
+            out.u8(uint8_t(StatsStatus::ok));
+            for (int32_t value : {stats.total_games, stats.unique_players, stats.unique_tournaments,
+                                  stats.white_wins, stats.black_wins, stats.draws,
+                                  stats.unknown_results}) {
+                out.i32(value);
+            }
+            out.u64(snapshot.generation);
+            return;
+        }
+        case StatsOp::player: {
+            std::string_view name = in.str();
+            if (!in.done()) break;
+            const PlayerStats* player = stats.find_player(name);
+            if (!player) {
+                out.u8(uint8_t(StatsStatus::not_found));
+                return;
+            }
+            out.u8(uint8_t(StatsStatus::ok));
+            for (int32_t value : {player->total_games, player->games_as_white, player->games_as_black,
+                                  player->wins, player->losses, player->draws,
+                                  static_cast<int>(player->opponents.size())}) {
+                out.i32(value);
+            }
+            return;
+        }
+        case StatsOp::tournament: {
+            std::string_view name = in.str();
+            if (!in.done()) break;
+            const Tournament* tournament = stats.find_tournament(name);
+            if (!tournament) {
+                out.u8(uint8_t(StatsStatus::not_found));
+                return;
+            }
+            out.u8(uint8_t(StatsStatus::ok));
+            out.i32(tournament->total_games);
+            out.i32(tournament->unique_players);
+            return;
+        }
+        case StatsOp::top_players:
+        case StatsOp::top_tournaments: {
+            uint32_t count = in.u32();
+            if (!in.done()) break;
+            out.u8(uint8_t(StatsStatus::ok));
+            if (op == StatsOp::top_players) {
+                write_ranked(snapshot.players_by_games, count, out);
+            } else {
+                write_ranked(snapshot.tournaments_by_games, count, out);
+            }
+            return;
+        }
+        case StatsOp::head_to_head: {
+            std::string_view first_name = in.str();
+            std::string_view second_name = in.str();
+            if (!in.done()) break;
+            auto first = find(first_name);
+            auto second = find(second_name);
+            if (!first || !second || !stats.find_player(first_name) || !stats.find_player(second_name)) {
+                out.u8(uint8_t(StatsStatus::not_found));
+                return;
+            }
+            HeadToHead result = head_to_head(snapshot, *first, *second);
+            out.u8(uint8_t(StatsStatus::ok));
+            out.i32(result.games);
+            out.i32(result.first_wins);
+            out.i32(result.second_wins);
+            out.i32(result.draws);
+            return;
+        }
+        default:
+            break;
+    }
+    out.u8(uint8_t(StatsStatus::bad_request));
+}
+
+} // namespace
+
+struct StatsServer::Impl {
+    std::vector<std::string> filenames;
+    ParserOptions options;
+    // Read and replaced with std::atomic_load and std::atomic_store, so a
+    // request keeps the snapshot it started on alive until it is done.
+    std::shared_ptr<const Snapshot> current;
+    std::mutex reload_mutex;
+    std::atomic<uint64_t> generation{0};
+    
+    struct Connection {
+        int fd = -1;
+        std::thread thread;
+        std::atomic<bool> done{false};
+    };
+    std::string socket_path;
+    int listen_fd = -1;
+    int wake_pipe[2] = {-1, -1};
+    std::thread acceptor;
+    std::mutex connections_mutex;
+    std::list<Connection> connections;
+    
+    bool reload();
+    void respond(std::string_view request, std::string& out);
+    void accept_loop();
+    void serve(Connection& connection);
+    void reap(bool all);
+};
+
+bool StatsServer::Impl::reload() {
+    std::lock_guard<std::mutex> lock(reload_mutex);
+    auto snapshot = std::make_shared<Snapshot>(options);
+    bool loaded = filenames.size() == 1 ? snapshot->parser.load_file(filenames[0])
+                                        : snapshot->parser.load_files(filenames);
+    if (!loaded) return false;
+    
+    snapshot->players_by_games = ranked(snapshot->parser.get_player_stats());
+    snapshot->tournaments_by_games = ranked(snapshot->parser.get_tournaments());
+    index_games(*snapshot);
+    snapshot->generation = generation + 1;
+    std::atomic_store(&current, std::shared_ptr<const Snapshot>(std::move(snapshot)));
+    generation++;
+    return true;
+}
+
+void StatsServer::Impl::respond(std::string_view request, std::string& out) {
+    Encoder encoder(out);
+    size_t frame = encoder.begin_frame();
+    Decoder decoder(request);
+    StatsOp op = static_cast<StatsOp>(decoder.u8());
+    
+    if (op == StatsOp::reload) {
+        bool reloaded = decoder.done() && reload();
+        encoder.u8(uint8_t(reloaded ? StatsStatus::ok
+                                    : decoder.done() ? StatsStatus::failed : StatsStatus::bad_request));
+        if (reloaded) encoder.u64(generation);
+    } else if (auto snapshot = std::atomic_load(&current)) {
+        answer(*snapshot, op, decoder, encoder);
+    } else {
+        encoder.u8(uint8_t(StatsStatus::failed));
+    }
+    encoder.end_frame(frame);
+}
+
+StatsServer::StatsServer(std::vector<std::string> filenames, const ParserOptions& options)
+    : pimpl(std::make_unique<Impl>()) {
+    pimpl->filenames = std::move(filenames);
+    pimpl->options = options;
+}
+
+StatsServer::~StatsServer() {
+    stop();
+}
+
+bool StatsServer::reload() {
+    return pimpl->reload();
+}
+
+uint64_t StatsServer::generation() const {
+    return pimpl->generation;
+}
+
+struct StatsClient::Impl {
+    int fd = -1;
+    std::string request;
+    std::string response;
+    
+    // Sends `op` with the arguments `encode` writes and returns a decoder
+    // positioned after the response status, which is stored in `status`.
+    template <typename Encode>
+    Decoder call(StatsOp op, StatsStatus& status, Encode&& encode) {
+        request.clear();
+        Encoder encoder(request);
+        size_t frame = encoder.begin_frame();
+        encoder.u8(uint8_t(op));
+        encode(encoder);
+        encoder.end_frame(frame);
+        exchange();
+        
+        Decoder decoder(response);
+        status = static_cast<StatsStatus>(decoder.u8());
+        if (status == StatsStatus::bad_request || status == StatsStatus::failed) {
+            throw std::runtime_error(status == StatsStatus::failed ? "Server has no data loaded"
+                                                                   : "Server rejected request");
+        }
+        return decoder;
+    }
+    
+    // Sends `request` and reads one response frame into `response`.
+    void exchange();
+};
+
+namespace {
+
+void check_response(const Decoder& decoder) {
+    if (!decoder.done()) throw std::runtime_error("Malformed server response");
+}
+
+} // namespace
+
+StatsClient::~StatsClient() {
+#ifndef _WIN32
+    if (pimpl->fd >= 0) ::close(pimpl->fd);
+#endif
+}
+
+DatabaseSummary StatsClient::summary() {
+    StatsStatus status;
+    Decoder in = pimpl->call(StatsOp::summary, status, [](Encoder&) {});
+    DatabaseSummary summary;
+    summary.total_games = in.i32();
+    summary.unique_players = in.i32();
+    summary.unique_tournaments = in.i32();
+    summary.white_wins = in.i32();
+    summary.black_wins = in.i32();
+    summary.draws = in.i32();
+    summary.unknown_results = in.i32();
+    summary.generation = in.u64();
+    check_response(in);
+    return summary;
+}
+
+std::optional<PlayerSummary> StatsClient::player(std::string_view name) {
+    StatsStatus status;
+    Decoder in = pimpl->call(StatsOp::player, status, [&](Encoder& out) { out.str(name); });
+    if (status == StatsStatus::not_found) return std::nullopt;
+    PlayerSummary player;
+    player.name = std::string(name);
+    player.total_games = in.i32();
+    player.games_as_white = in.i32();
+    player.games_as_black = in.i32();
+    player.wins = in.i32();
+    player.losses = in.i32();
+    player.draws = in.i32();
+    player.unique_opponents = in.i32();
+    check_response(in);
+    return player;
+}
+
+std::optional<TournamentSummary> StatsClient::tournament(std::string_view name) {
+    StatsStatus status;
+    Decoder in = pimpl->call(StatsOp::tournament, status, [&](Encoder& out) { out.str(name); });
+    if (status == StatsStatus::not_found) return std::nullopt;
+    TournamentSummary tournament;
+    tournament.name = std::string(name);
+    tournament.total_games = in.i32();
+    tournament.unique_players = in.i32();
+    check_response(in);
+    return tournament;
+}
+
+namespace {
+
+std::vector<RankedName> read_ranked(Decoder& in) {
+    uint32_t count = in.u32();
+    std::vector<RankedName> names;
+    for (uint32_t i = 0; i < count && in.ok(); ++i) {
+        RankedName& entry = names.emplace_back();
+        entry.name = std::string(in.str());
+        entry.games = in.i32();
+    }
+    check_response(in);
+    return names;
+}
+
+} // namespace
+
+std::vector<RankedName> StatsClient::top_players(uint32_t count) {
+    StatsStatus status;
+    Decoder in = pimpl->call(StatsOp::top_players, status, [&](Encoder& out) { out.u32(count); });
+    return read_ranked(in);
+}
+
+std::vector<RankedName> StatsClient::top_tournaments(uint32_t count) {
+    StatsStatus status;
+    Decoder in = pimpl->call(StatsOp::top_tournaments, status, [&](Encoder& out) { out.u32(count); });
+    return read_ranked(in);
+}
+
+HeadToHead StatsClient::head_to_head(std::string_view first, std::string_view second) {
+    StatsStatus status;
+    Decoder in = pimpl->call(StatsOp::head_to_head, status, [&](Encoder& out) {
+        out.str(first);
+        out.str(second);
+    });
+    HeadToHead result;
+    if (status == StatsStatus::not_found) return result;
+    result.games = in.i32();
+    result.first_wins = in.i32();
+    result.second_wins = in.i32();
+    result.draws = in.i32();
+    check_response(in);
+    return result;
+}
+
+uint64_t StatsClient::reload() {
+    StatsStatus status;
+    Decoder in = pimpl->call(StatsOp::reload, status, [](Encoder&) {});
+    uint64_t generation = in.u64();
+    check_response(in);
+    return generation;
+}
+
+#ifndef _WIN32
+
+namespace {
+
+sockaddr_un socket_address(const std::string& path) {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path)) {
+        throw std::runtime_error("Socket path too long: " + path);
+    }
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+    return address;
+}
+
+bool send_all(int fd, const char* data, size_t size) {
+    while (size > 0) {
+        ssize_t sent = ::send(fd, data, size, MSG_NOSIGNAL);
+        if (sent < 0 && errno == EINTR) continue;
+        if (sent <= 0) return false;
+        data += sent;
+        size -= static_cast<size_t>(sent);
+    }
+    return true;
+}
+
+// Appends what the socket has to `buffer`; false at end of stream or on
+// error.
+bool receive_some(int fd, std::string& buffer) {
+    char chunk[16384];
+    for (;;) {
+        ssize_t received = ::recv(fd, chunk, sizeof(chunk), 0);
+        if (received < 0 && errno == EINTR) continue;
+        if (received <= 0) return false;
+        buffer.append(chunk, static_cast<size_t>(received));
+        return true;
+    }
+}
+
+uint32_t frame_length(std::string_view buffer) {
+    uint32_t length = 0;
+    for (int i = 0; i < 4; ++i) length |= uint32_t(static_cast<unsigned char>(buffer[i])) << (8 * i);
+    return length;
+}
+
+} // namespace
+
+void StatsServer::start(const std::string& socket_path) {
+    stop();
+    sockaddr_un address = socket_address(socket_path);
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) throw std::runtime_error("Cannot create socket: " + socket_path);
+    ::unlink(socket_path.c_str());
+    if (::bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+        ::listen(fd, SOMAXCONN) != 0) {
+        ::close(fd);
+        throw std::runtime_error("Cannot listen on socket: " + socket_path);
+    }
+    if (::pipe(pimpl->wake_pipe) != 0) {
+        ::close(fd);
+        ::unlink(socket_path.c_str());
+        throw std::runtime_error("Cannot create pipe for socket: " + socket_path);
+    }
+    
+    pimpl->socket_path = socket_path;
+    pimpl->listen_fd = fd;
+    pimpl->acceptor = std::thread([this] { pimpl->accept_loop(); });
+}
+
+void StatsServer::stop() {
+    if (pimpl->listen_fd < 0) return;
+    char wake = 0;
+    while (::write(pimpl->wake_pipe[1], &wake, 1) < 0 && errno == EINTR) {}
+    pimpl->acceptor.join();
+    pimpl->reap(true);
+    
+    ::close(pimpl->listen_fd);
+    ::close(pimpl->wake_pipe[0]);
+    ::close(pimpl->wake_pipe[1]);
+    ::unlink(pimpl->socket_path.c_str());
+    pimpl->listen_fd = -1;
+    pimpl->wake_pipe[0] = pimpl->wake_pipe[1] = -1;
+}
+
+void StatsServer::Impl::accept_loop() {
+    pollfd fds[2] = {{listen_fd, POLLIN, 0}, {wake_pipe[0], POLLIN, 0}};
+    for (;;) {
+        if (::poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) continue;
+            return;
+        }
+        if (fds[1].revents) return;
+        if (!(fds[0].revents & POLLIN)) continue;
+        
+        int fd = ::accept(listen_fd, nullptr, nullptr);
+        if (fd < 0) continue;
+        reap(false);
+        std::lock_guard<std::mutex> lock(connections_mutex);
+        Connection& connection = connections.emplace_back();
+        connection.fd = fd;
+        connection.thread = std::thread([this, &connection] { serve(connection); });
+    }
+}
+
+// Answers every complete request in what has arrived, then sends the
+// answers in one write, so pipelined requests cost one round trip.
+void StatsServer::Impl::serve(Connection& connection) {
+    std::string in;
+    std::string out;
+    while (receive_some(connection.fd, in)) {
+        size_t consumed = 0;
+        bool valid = true;
+        while (in.size() - consumed >= 4) {
+            uint32_t length = frame_length(std::string_view(in).substr(consumed));
+            if (length == 0 || length > max_request_size) {
+                valid = false;
+                break;
+            }
+            if (in.size() - consumed - 4 < length) break;
+            respond(std::string_view(in).substr(consumed + 4, length), out);
+            consumed += 4 + length;
+        }
+        in.erase(0, consumed);
+        if (!out.empty() && !send_all(connection.fd, out.data(), out.size())) break;
+        out.clear();
+        if (!valid) break;
+    }
+    connection.done = true;
+}
+
+// Joins and closes finished connections, or with `all` every connection,
+// after shutting each down so its thread sees the end of the stream.
+void StatsServer::Impl::reap(bool all) {
+    std::lock_guard<std::mutex> lock(connections_mutex);
+    for (auto it = connections.begin(); it != connections.end();) {
+        if (!all && !it->done) {
+            ++it;
+            continue;
+        }
+        if (all) ::shutdown(it->fd, SHUT_RDWR);
+        it->thread.join();
+        ::close(it->fd);
+        it = connections.erase(it);
+    }
+}
+
+StatsClient::StatsClient(const std::string& socket_path) : pimpl(std::make_unique<Impl>()) {
+    sockaddr_un address = socket_address(socket_path);
+    pimpl->fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (pimpl->fd < 0 ||
+        ::connect(pimpl->fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        if (pimpl->fd >= 0) ::close(pimpl->fd);
+        pimpl->fd = -1;
+        throw std::runtime_error("Cannot connect to socket: " + socket_path);
+    }
+}
+
+void StatsClient::Impl::exchange() {
+    if (!send_all(fd, request.data(), request.size())) {
+        throw std::runtime_error("Cannot send request to server");
+    }
+    response.clear();
+    while (response.size() < 4 || response.size() - 4 < frame_length(response)) {
+        if (!receive_some(fd, response)) throw std::runtime_error("Server closed the connection");
+    }
+    response.erase(0, 4);
+}
+
+#else
+
+void StatsServer::start(const std::string&) {
+    throw std::runtime_error("StatsServer needs Unix-domain sockets");
+}
+
+void StatsServer::stop() {}
+
+void StatsServer::Impl::accept_loop() {}
+void StatsServer::Impl::serve(Connection&) {}
+void StatsServer::Impl::reap(bool) {}
+
+StatsClient::StatsClient(const std::string&) : pimpl(std::make_unique<Impl>()) {
+    throw std::runtime_error("StatsClient needs Unix-domain sockets");
+}
+
+void StatsClient::Impl::exchange() {}
+
+#endif
+
+} // namespace pgn
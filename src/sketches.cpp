@@ -0,0 +1,407 @@
+#include "pgn/sketches.hpp"
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+
+namespace pgn {
+
+namespace {
+
+uint64_t mix(uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ull;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebull;
+    return x ^ (x >> 31);
+}
+
+// Most first, then the alphabetically first name.
+bool ranks_before(const SpaceSaving::Item& a, const SpaceSaving::Item& b) {
+    if (a.count != b.count) return a.count > b.count;
+    return a.name < b.name;
+}
+
+} // namespace
+
+uint64_t hash_name(std::string_view name) {
+    // FNV-1a, finalized so that every bit depends on the whole name; the
+    // sketches take their register and row indices from different bits.
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (unsigned char c : name) {
+        hash ^= c;
+        hash *= 0x100000001b3ull;
+    }
+    return mix(hash);
+}
+
+HyperLogLog::HyperLogLog(int precision) : precision_(precision) {
+    if (precision < 4 || precision > 18) throw std::invalid_argument("HyperLogLog precision must be 4..18");
+    registers_.assign(size_t(1) << precision, 0);
+}
+
+void HyperLogLog::add(uint64_t hash) {
+    size_t index = hash >> (64 - precision_);
+    uint64_t rest = hash << precision_;
+    // Position of the first set bit in the remaining bits, 1-based.
+    uint8_t rank = rest ? uint8_t(__builtin_clzll(rest) + 1) : uint8_t(64 - precision_ + 1);
+    if (rank > registers_[index]) registers_[index] = rank;
+}
+
+void HyperLogLog::merge(const HyperLogLog& other) {
+    if (other.precision_ != precision_) throw std::invalid_argument("HyperLogLog precisions differ");
+    for (size_t i = 0; i < registers_.size(); ++i) {
+        registers_[i] = std::max(registers_[i], other.registers_[i]);
+    }
+}
+
+double HyperLogLog::estimate() const {
+    double m = static_cast<double>(registers_.size());
+    double sum = 0.0;
+    size_t zeros = 0;
+    for (uint8_t r : registers_) {
+        sum += std::ldexp(1.0, -int(r));
+        if (r == 0) ++zeros;
+    }
+    double alpha = 0.7213 / (1.0 + 1.079 / m);
+    double raw = alpha * m * m / sum;
+    // Small cardinalities: count the empty registers instead.
+    if (raw <= 2.5 * m && zeros > 0) return m * std::log(m / static_cast<double>(zeros));
+    return raw;
+}
+
+void HyperLogLog::clear() {
+    std::fill(registers_.begin(), registers_.end(), 0);
+}
+
+CountMinSketch::CountMinSketch(size_t width, size_t depth) : width_(width), depth_(depth) {
+    if (width == 0 || depth == 0) throw std::invalid_argument("CountMinSketch dimensions must be positive");
+    counters_.assign(width * depth, 0);
+}
+
+void CountMinSketch::add(uint64_t hash, uint32_t count) {
+    // Row i uses h1 + i * h2, which is as good as independent hashes.
+    uint64_t h1 = hash & 0xFFFFFFFF;
+    uint64_t h2 = (hash >> 32) | 1;
+    for (size_t row = 0; row < depth_; ++row) {
+        uint32_t& counter = counters_[row * width_ + (h1 + row * h2) % width_];
+        // Saturate rather than wrap, so estimates stay upper bounds.
+        counter = counter > std::numeric_limits<uint32_t>::max() - count
+                      ? std::numeric_limits<uint32_t>::max() : counter + count;
+    }
+    total_ += count;
+}
+
+uint32_t CountMinSketch::estimate(uint64_t hash) const {
+    uint64_t h1 = hash & 0xFFFFFFFF;
+    uint64_t h2 = (hash >> 32) | 1;
+    uint32_t estimate = std::numeric_limits<uint32_t>::max();
+    for (size_t row = 0; row < depth_; ++row) {
+        estimate = std::min(estimate, counters_[row * width_ + (h1 + row * h2) % width_]);
+    }
+    return estimate;
+}
+
+void CountMinSketch::merge(const CountMinSketch& other) {
+    if (other.width_ != width_ || other.depth_ != depth_) {
+        throw std::invalid_argument("CountMinSketch dimensions differ");
+    }
+    for (size_t i = 0; i < counters_.size(); ++i) {
+        uint32_t add = other.counters_[i];
+        counters_[i] = counters_[i] > std::numeric_limits<uint32_t>::max() - add
+                           ? std::numeric_limits<uint32_t>::max() : counters_[i] + add;
+    }
+    total_ += other.total_;
+}
+
+void CountMinSketch::clear() {
+    std::fill(counters_.begin(), counters_.end(), 0);
+    total_ = 0;
+}
+
+SpaceSaving::SpaceSaving(size_t capacity) : capacity_(capacity) {
+    if (capacity == 0) throw std::invalid_argument("SpaceSaving capacity must be positive");
+    entries_.reserve(capacity);
+    heap_.reserve(capacity);
+    heap_position_.reserve(capacity);
+    size_t slots = 1;
+    while (slots < capacity * 2) slots <<= 1;
+    slots_.assign(slots, 0);
+}
+
+void SpaceSaving::add(std::string_view name, uint64_t hash, uint64_t count) {
+    total_ += count;
+    size_t found = find(hash);
+    if (found != size_t(-1)) {
+        entries_[found].item.count += count;
+        sift_down(heap_position_[found]);
+        return;
+    }
+    
+    if (entries_.size() < capacity_) {
+        uint32_t entry = static_cast<uint32_t>(entries_.size());
+        entries_.push_back({hash, Item{std::string(name), count, 0}});
+        heap_.push_back(entry);
+        heap_position_.push_back(entry);
+        insert_slot(hash, entry);
+        sift_up(heap_.size() - 1);
+        return;
+    }
+    
+    // Full: the newcomer takes over the smallest counter, whose count
+    // becomes its possible overestimate. The name's buffer is reused.
+    uint32_t entry = heap_[0];
+    Entry& smallest = entries_[entry];
+    erase_slot(smallest.hash);
+    smallest.hash = hash;
+    smallest.item.name.assign(name.data(), name.size());
+    smallest.item.error = smallest.item.count;
+    smallest.item.count += count;
+    insert_slot(hash, entry);
+    sift_down(0);
+}
+
+void SpaceSaving::merge(const SpaceSaving& other) {
+    uint64_t own_floor = entries_.size() == capacity_ ? min_count() : 0;
+    uint64_t other_floor = other.entries_.size() == other.capacity_ ? other.min_count() : 0;
+    
+    // Every key of either summary, each charged the other summary's
+    // floor where that summary does not hold it.
+    std::vector<Entry> combined = entries_;
+    for (Entry& entry : combined) {
+        entry.item.count += other_floor;
+        entry.item.error += other_floor;
+    }
+    for (const Entry& from : other.entries_) {
+        size_t found = find(from.hash);
+        if (found != size_t(-1)) {
+            combined[found].item.count += from.item.count - other_floor;
+            combined[found].item.error += from.item.error - other_floor;
+        } else {
+            combined.push_back({from.hash, Item{from.item.name, from.item.count + own_floor,
+                                                from.item.error + own_floor}});
+        }
+    }
+    
+    if (combined.size() > capacity_) {
+        std::nth_element(combined.begin(), combined.begin() + capacity_, combined.end(),
+                         [](const Entry& a, const Entry& b) { return ranks_before(a.item, b.item); });
+        combined.resize(capacity_);
+    }
+    
+    uint64_t total = total_ + other.total_;
+    clear();
+    total_ = total;
+    for (Entry& entry : combined) {
+        uint32_t index = static_cast<uint32_t>(entries_.size());
+        insert_slot(entry.hash, index);
+        entries_.push_back(std::move(entry));
+        heap_.push_back(index);
+        heap_position_.push_back(index);
+        sift_up(heap_.size() - 1);
+    }
+}
+
+void SpaceSaving::clear() {
+    total_ = 0;
+    entries_.clear();
+    heap_.clear();
+    heap_position_.clear();
+    std::fill(slots_.begin(), slots_.end(), 0);
+}
+
+std::vector<SpaceSaving::Item> SpaceSaving::top(size_t count) const {
+    std::vector<Item> items;
+    items.reserve(entries_.size());
+    for (const Entry& entry : entries_) items.push_back(entry.item);
+    count = std::min(count, items.size());
+    std::partial_sort(items.begin(), items.begin() + count, items.end(), ranks_before);
+    items.resize(count);
+    return items;
+}
+
+size_t SpaceSaving::memory_usage() const {
+    size_t bytes = entries_.capacity() * sizeof(Entry) +
+                   (heap_.capacity() + heap_position_.capacity() + slots_.size()) * sizeof(uint32_t);
+    for (const Entry& entry : entries_) {
+        if (entry.item.name.capacity() > 15) bytes += entry.item.name.capacity() + 1;
+    }
+    return bytes;
+}
+
+uint64_t SpaceSaving::min_count() const {
+    return heap_.empty() ? 0 : entries_[heap_[0]].item.count;
+}
+
+void SpaceSaving::sift_down(size_t position) {
+    for (;;) {
+        size_t smallest = position;
+        for (size_t child = position * 2 + 1; child <= position * 2 + 2 && child < heap_.size(); ++child) {
+            if (entries_[heap_[child]].item.count < entries_[heap_[smallest]].item.count) smallest = child;
+        }
+        if (smallest == position) return;
+        swap_heap(position, smallest);
+        position = smallest;
+    }
+}
+
+void SpaceSaving::sift_up(size_t position) {
+    while (position > 0) {
+        size_t parent = (position - 1) / 2;
+        if (entries_[heap_[parent]].item.count <= entries_[heap_[position]].item.count) return;
+        swap_heap(position, parent);
+        position = parent;
+    }
+}
+
+void SpaceSaving::swap_heap(size_t a, size_t b) {
+    std::swap(heap_[a], heap_[b]);
+    heap_position_[heap_[a]] = static_cast<uint32_t>(a);
+    heap_position_[heap_[b]] = static_cast<uint32_t>(b);
+}
+
+size_t SpaceSaving::find(uint64_t hash) const {
+    size_t mask = slots_.size() - 1;
+    for (size_t slot = hash & mask;; slot = (slot + 1) & mask) {
+        uint32_t value = slots_[slot];
+        if (value == 0) return size_t(-1);
+        if (entries_[value - 1].hash == hash) return value - 1;
+    }
+}
+
+void SpaceSaving::insert_slot(uint64_t hash, uint32_t entry) {
+    size_t mask = slots_.size() - 1;
+    size_t slot = hash & mask;
+    while (slots_[slot] != 0) slot = (slot + 1) & mask;
+    slots_[slot] = entry + 1;
+}
+
+void SpaceSaving::erase_slot(uint64_t hash) {
+    size_t mask = slots_.size() - 1;
+    size_t slot = hash & mask;
+    while (entries_[slots_[slot] - 1].hash != hash) slot = (slot + 1) & mask;
+    
+    // Backward-shift deletion: pull later entries of the probe run into
+    // the gap, so lookups never need tombstones.
+    for (size_t next = (slot + 1) & mask; slots_[next] != 0; next = (next + 1) & mask) {
+        size_t home = entries_[slots_[next] - 1].hash & mask;
+        if (((next - home) & mask) >= ((next - slot) & mask)) {
+            slots_[slot] = slots_[next];
+            slot = next;
+        }
+    }
+    slots_[slot] = 0;
+}
+
+ApproximateStats::ApproximateStats() = default;
+
+void ApproximateStats::add(const GameView& game) {
+    add(game.event, game.white, game.black, parse_result(game.result));
+}
+
+void ApproximateStats::add(std::string_view event, std::string_view white, std::string_view black,
+                           GameResult result) {
+    ++games_;
+    ++results_[size_t(result)];
+    
+    // Like the exact statistics, empty names count towards the leaders
+    // but not towards the distinct counts.
+    for (std::string_view player : {white, black}) {
+        uint64_t hash = hash_name(player);
+        if (!player.empty()) players_.add(hash);
+        player_counts_.add(hash);
+        top_players_.add(player, hash);
+    }
+    uint64_t hash = hash_name(event);
+    if (!event.empty()) tournaments_.add(hash);
+    tournament_counts_.add(hash);
+    top_tournaments_.add(event, hash);
+}
+
+void ApproximateStats::merge(const ApproximateStats& other) {
+    games_ += other.games_;
+    for (size_t i = 0; i < 4; ++i) results_[i] += other.results_[i];
+    players_.merge(other.players_);
+    tournaments_.merge(other.tournaments_);
+    player_counts_.merge(other.player_counts_);
+    tournament_counts_.merge(other.tournament_counts_);
+    top_players_.merge(other.top_players_);
+    top_tournaments_.merge(other.top_tournaments_);
+}
+
+void ApproximateStats::clear() {
+    games_ = 0;
+    std::fill(std::begin(results_), std::end(results_), 0);
+    players_.clear();
+    tournaments_.clear();
+    player_counts_.clear();
+    tournament_counts_.clear();
+    top_players_.clear();
+    top_tournaments_.clear();
+}
+
+std::vector<SpaceSaving::Item> ApproximateStats::top_players(size_t count) const {
+    return tightened(top_players_, player_counts_, count);
+}
+
+std::vector<SpaceSaving::Item> ApproximateStats::top_tournaments(size_t count) const {
+    return tightened(top_tournaments_, tournament_counts_, count);
+}
+
+uint64_t ApproximateStats::player_games(std::string_view name) const {
+    return player_counts_.estimate(hash_name(name));
+}
+
+uint64_t ApproximateStats::tournament_games(std::string_view name) const {
+    return tournament_counts_.estimate(hash_name(name));
+}
+
+std::vector<SpaceSaving::Item> ApproximateStats::tightened(const SpaceSaving& top,
+                                                           const CountMinSketch& counts,
+                                                           size_t count) const {
+    // Both counts are upper bounds, so the smaller one is too; re-rank
+    // after tightening, since it can reorder the leaders.
+    std::vector<SpaceSaving::Item> items = top.top(top.size());
+    for (auto& item : items) {
+        uint64_t estimate = counts.estimate(hash_name(item.name));
+        if (estimate < item.count) {
+            item.error -= std::min(item.error, item.count - estimate);
+            item.count = estimate;
+        }
+    }
+    count = std::min(count, items.size());
+    std::partial_sort(items.begin(), items.begin() + count, items.end(), ranks_before);
+    items.resize(count);
+    return items;
+}
+
+void ApproximateStats::fill(DatabaseStats& stats) const {
+    stats.total_games = static_cast<int>(games_);
+    stats.white_wins = static_cast<int>(results_[size_t(GameResult::white_win)]);
+    stats.black_wins = static_cast<int>(results_[size_t(GameResult::black_win)]);
+    stats.draws = static_cast<int>(results_[size_t(GameResult::draw)]);
+    stats.unknown_results = static_cast<int>(results_[size_t(GameResult::unknown)]);
+    stats.unique_players = static_cast<int>(std::llround(players_.estimate()));
+    stats.unique_tournaments = static_cast<int>(std::llround(tournaments_.estimate()));
+    
+    auto player = top_players(1);
+    stats.most_active_player = player.empty() ? Symbol() : intern(player[0].name);
+    stats.max_games_by_player = player.empty() ? 0 : static_cast<int>(player[0].count);
+    auto tournament = top_tournaments(1);
+    stats.largest_tournament = tournament.empty() ? Symbol() : intern(tournament[0].name);
+    stats.max_games_in_tournament = tournament.empty() ? 0 : static_cast<int>(tournament[0].count);
+    
+    stats.player_stats.clear();
+    stats.tournaments.clear();
+    stats.player_names.clear();
+    stats.tournament_names.clear();
+}
+
+size_t ApproximateStats::memory_usage() const {
+    return sizeof(*this) + players_.memory_usage() + tournaments_.memory_usage() +
+           player_counts_.memory_usage() + tournament_counts_.memory_usage() +
+           top_players_.memory_usage() + top_tournaments_.memory_usage();
+}
+
+} // namespace pgn
@@ -0,0 +1,325 @@
+#include "stats_builder.hpp"
+#include "metrics_counters.hpp"
+#include "parallel.hpp"
+#include <algorithm>
+
+namespace pgn {
+
+void StatsBuilder::reset() {
+    players_.clear();
+    tournaments_.clear();
+    stats_.player_stats.clear();
+    stats_.tournaments.clear();
+    stats_.white_wins = 0;
+    stats_.black_wins = 0;
+    stats_.draws = 0;
+    stats_.unknown_results = 0;
+    stats_.most_active_player = Symbol();
+    stats_.max_games_by_player = 0;
+    stats_.largest_tournament = Symbol();
+    stats_.max_games_in_tournament = 0;
+    stats_.elo_histogram = EloHistogram();
+}
+
+void StatsBuilder::add(const GameView& game) {
+    GameResult result = parse_result(game.result);
+    Symbol event = intern(game.event);
+    Symbol white = intern(game.white);
+    Symbol black = intern(game.black);
+    add_game(event, white, black, intern(game.eco), result);
+    if (ratings_) {
+        add_ratings(event, white, black, encode_elo(game.white_elo), encode_elo(game.black_elo),
+                    encode_date(game.date), result);
+    }
+    
+    switch (result) {
+        case GameResult::white_win: stats_.white_wins++; break;
+        case GameResult::black_win: stats_.black_wins++; break;
+        case GameResult::draw: stats_.draws++; break;
+        default: stats_.unknown_results++; break;
+    }
+}
+
+void StatsBuilder::add(const GameTable& table, size_t begin, size_t end) {
+    const Symbol* events = table.events().data();
+    const Symbol* whites = table.whites().data();
+    const Symbol* blacks = table.blacks().data();
+    const uint16_t* ecos = table.eco_codes().data();
+    
+    for (size_t i = begin; i < end; ++i) {
+        Symbol eco = ecos[i] == raw_eco ? table.eco(i) : eco_symbol(ecos[i]);
+        add_game(events[i], whites[i], blacks[i], eco, table.result(i));
+    }
+    if (ratings_) {
+        const uint16_t* white_elos = table.white_elos().data();
+        const uint16_t* black_elos = table.black_elos().data();
+        const uint32_t* dates = table.dates().data();
+        for (size_t i = begin; i < end; ++i) {
+            add_ratings(events[i], whites[i], blacks[i], white_elos[i], black_elos[i], dates[i],
+                        table.result(i));
+        }
+    }
+    
+    GameTable::ResultCounts counts = table.count_results(begin, end);
+    stats_.white_wins += counts.white_wins;
+    stats_.black_wins += counts.black_wins;
+    stats_.draws += counts.draws;
+    stats_.unknown_results += counts.unknown;
+}
+
+void StatsBuilder::add_game(Symbol event, Symbol white, Symbol black, Symbol eco, GameResult result) {
+    update_player_stats(white, black, eco, result);
+    update_tournament_stats(event, white, black);
+}
+
+// Ratings and dates arrive encoded; an unknown or unreadable one leaves
+// the game out of whatever needs it.
+void StatsBuilder::add_ratings(Symbol event, Symbol white, Symbol black, uint16_t white_elo,
+                               uint16_t black_elo, uint32_t date, GameResult result) {
+    bool white_rated = elo_known(white_elo);
+    bool black_rated = elo_known(black_elo);
+    if (date_known(date)) {
+        if (white_rated) player(white).ratings.add(date, white_elo);
+        if (black_rated) player(black).ratings.add(date, black_elo);
+    }
+    
+    bool decided = result != GameResult::unknown;
+    int white_half_points = result == GameResult::white_win ? 2 : result == GameResult::draw ? 1 : 0;
+    Tournament& tournament = this->tournament(event);
+    auto score = [&](Symbol name, uint16_t opponent_elo, int half_points) {
+        TournamentScore& entry = tournament.scores[name];
+        entry.games++;
+        entry.half_points += half_points;
+        if (decided && elo_known(opponent_elo)) {
+            entry.rated_games++;
+            entry.rated_half_points += half_points;
+            entry.opponent_elo_sum += opponent_elo;
+        }
+    };
+    score(white, black_elo, white_half_points);
+    score(black, white_elo, decided ? 2 - white_half_points : 0);
+    
+    if (decided && white_rated && black_rated) {
+        stats_.elo_histogram.add(white_elo, black_elo, static_cast<int>(result));
+    }
+}
+
+void StatsBuilder::track_names(const GameView& game) {
+    tracking_names_ = true;
+    if (!game.event.empty()) tournament_names_.insert(intern(game.event));
+    if (!game.white.empty()) player_names_.insert(intern(game.white));
+    if (!game.black.empty()) player_names_.insert(intern(game.black));
+}
+
+void StatsBuilder::merge(DatabaseStats&& later) {
+    stats_.white_wins += later.white_wins;
+    stats_.black_wins += later.black_wins;
+    stats_.draws += later.draws;
+    stats_.unknown_results += later.unknown_results;
+    stats_.elo_histogram.merge(later.elo_histogram);
+    
+    for (auto& [name, from] : later.player_stats) {
+        PlayerStats* into = cached_player(name);
+        if (!into) {
+            // First seen in the later games: take the entry as it is.
+            players_.insert(name, &stats_.player_stats.emplace(name, std::move(from)).first->second);
+            continue;
+        }
+        
+        into->total_games += from.total_games;
+        into->games_as_white += from.games_as_white;
+        into->games_as_black += from.games_as_black;
+        into->wins += from.wins;
+        into->losses += from.losses;
+        into->draws += from.draws;
+        for (Symbol opponent : from.opponents) into->opponents.insert(opponent);
+        for (const auto& [eco, count] : from.opening_frequency) into->opening_frequency[eco] += count;
+        into->ratings.merge(std::move(from.ratings));
+    }
+    
+    for (auto& [name, from] : later.tournaments) {
+        Tournament* into = cached_tournament(name);
+        if (!into) {
+            tournaments_.insert(name, &stats_.tournaments.emplace(name, std::move(from)).first->second);
+            continue;
+        }
+        
+        into->total_games += from.total_games;
+        for (Symbol player : from.players) into->players.insert(player);
+        into->unique_players = into->players.size();
+        for (const auto& [player, count] : from.player_game_count) into->player_game_count[player] += count;
+        for (const auto& [player, score] : from.scores) into->scores[player].merge(score);
+    }
+    
+    later.player_stats.clear();
+    later.tournaments.clear();
+}
+
+namespace {
+
+struct Leader {
+    Symbol name;
+    int games = 0;
+    
+    // Most games first, then the alphabetically first name. This is a
+    // total order, so the leader does not depend on how entries are split.
+    void consider(Symbol candidate, int candidate_games) {
+        if (candidate_games > games || (candidate_games == games && candidate < name)) {
+            name = candidate;
+            games = candidate_games;
+        }
+    }
+    
+    void consider(const Leader& other) { consider(other.name, other.games); }
+};
+
+// Visits every entry of `map` (which may modify its value) on up to
+// `workers` threads, split by hash bucket, and returns the entry with the
+// most games.
+template <typename Map, typename Visit>
+Leader find_leader(Map& map, unsigned workers, Visit visit) {
+    constexpr size_t min_entries_per_worker = 16384;
+    size_t slices = std::max<size_t>(1, std::min<size_t>(workers, map.size() / min_entries_per_worker));
+    size_t buckets = map.bucket_count();
+    
+    std::vector<Leader> leaders(slices);
+    run_parallel(slices, [&](size_t slice) {
+        for (size_t b = buckets * slice / slices; b < buckets * (slice + 1) / slices; ++b) {
+            for (auto it = map.begin(b); it != map.end(b); ++it) {
+                leaders[slice].consider(it->first, visit(it->second));
+            }
+        }
+    });
+    
+    Leader leader;
+    for (const auto& slice_leader : leaders) leader.consider(slice_leader);
+    return leader;
+}
+
+} // namespace
+
+void StatsBuilder::finish(unsigned workers) {
+    Leader most_active = find_leader(stats_.player_stats, workers, [](PlayerStats& player) {
+        player.calculate_percentages();
+        player.ratings.seal();
+        return player.total_games;
+    });
+    most_active.consider(stats_.most_active_player, stats_.max_games_by_player);
+    stats_.most_active_player = most_active.name;
+    stats_.max_games_by_player = most_active.games;
+    
+    Leader largest = find_leader(stats_.tournaments, workers, [](const Tournament& tournament) {
+        return tournament.total_games;
+    });
+    largest.consider(stats_.largest_tournament, stats_.max_games_in_tournament);
+    stats_.largest_tournament = largest.name;
+    stats_.max_games_in_tournament = largest.games;
+    
+    if (tracking_names_) {
+        stats_.tournament_names.assign(tournament_names_.begin(), tournament_names_.end());
+        stats_.player_names.assign(player_names_.begin(), player_names_.end());
+        stats_.unique_tournaments = tournament_names_.size();
+        stats_.unique_players = player_names_.size();
+    }
+}
+
+void StatsBuilder::finish_added(const GameTable& table, size_t begin, size_t end) {
+    // Counts only grow, so the old leaders need to be compared with just
+    // the entries the new games touched.
+    Leader most_active{stats_.most_active_player, stats_.max_games_by_player};
+    Leader largest{stats_.largest_tournament, stats_.max_games_in_tournament};
+    
+    for (size_t i = begin; i < end; ++i) {
+        for (Symbol name : {table.whites()[i], table.blacks()[i]}) {
+            PlayerStats& entry = player(name);
+            entry.calculate_percentages();
+            entry.ratings.seal();
+            most_active.consider(name, entry.total_games);
+        }
+        Symbol event = table.events()[i];
+        largest.consider(event, tournament(event).total_games);
+    }
+    
+    stats_.most_active_player = most_active.name;
+    stats_.max_games_by_player = most_active.games;
+    stats_.largest_tournament = largest.name;
+    stats_.max_games_in_tournament = largest.games;
+}
+
+PlayerStats* StatsBuilder::cached_player(Symbol name) const {
+    return players_.find(name);
+}
+
+Tournament* StatsBuilder::cached_tournament(Symbol name) const {
+    return tournaments_.find(name);
+}
+
+PlayerStats& StatsBuilder::player(Symbol name) {
+    if (PlayerStats* cached = players_.find(name)) return *cached;
+    
+    // Entries allocate from the same resource as the map that holds them.
+    std::pmr::memory_resource* resource = stats_.player_stats.get_allocator().resource();
+    size_t buckets = stats_.player_stats.bucket_count();
+    PlayerStats& player = stats_.player_stats.try_emplace(name, resource).first->second;
+    metrics::note_buckets(stats_.player_stats, buckets, HashTable::statistics);
+    player.name = name;
+    players_.insert(name, &player);
+    return player;
+}
+
+Tournament& StatsBuilder::tournament(Symbol name) {
+    if (Tournament* cached = tournaments_.find(name)) return *cached;
+    
+    std::pmr::memory_resource* resource = stats_.tournaments.get_allocator().resource();
+    size_t buckets = stats_.tournaments.bucket_count();
+    Tournament& tournament = stats_.tournaments.try_emplace(name, resource).first->second;
+    metrics::note_buckets(stats_.tournaments, buckets, HashTable::statistics);
+    tournament.name = name;
+    tournaments_.insert(name, &tournament);
+    return tournament;
+}
+
+void StatsBuilder::update_player_stats(Symbol white_name, Symbol black_name, Symbol eco,
+                                       GameResult result) {
+    PlayerStats& white = player(white_name);
+    white.total_games++;
+    white.games_as_white++;
+    
+    white.wins += result == GameResult::white_win;
+    white.losses += result == GameResult::black_win;
+    white.draws += result == GameResult::draw;
+    
+    white.opponents.insert(black_name);
+    
+    if (!eco.empty()) {
+        white.opening_frequency[eco]++;
+    }
+    
+    PlayerStats& black = player(black_name);
+    black.total_games++;
+    black.games_as_black++;
+    
+    black.wins += result == GameResult::black_win;
+    black.losses += result == GameResult::white_win;
+    black.draws += result == GameResult::draw;
+    
+    black.opponents.insert(white_name);
+    
+    if (!eco.empty()) {
+        black.opening_frequency[eco]++;
+    }
+}
+
+void StatsBuilder::update_tournament_stats(Symbol event, Symbol white, Symbol black) {
+    Tournament& tournament = this->tournament(event);
+    tournament.total_games++;
+    
+    tournament.players.insert(white);
+    tournament.players.insert(black);
+    
+    tournament.unique_players = tournament.players.size();
+    tournament.player_game_count[white]++;
+    tournament.player_game_count[black]++;
+}
+
+} // namespace pgn
@@ -0,0 +1,124 @@
+#pragma once
+#include "pgn/game_table.hpp"
+#include "pgn/metrics.hpp"
+#include "pgn/types.hpp"
+#include <vector>
+
+namespace pgn {
+
+// Entries of a DatabaseStats by name, for the builder's repeated lookups.
+// An open-addressing table like IdSet's, so it grows with the names one
+// builder has seen rather than with the range of global symbol ids.
+template <typename Entry>
+class EntryCache {
+public:
+    Entry* find(Symbol name) const {
+        if (slots_.empty()) return nullptr;
+        return slots_[find_slot(name.id())].entry;
+    }
+    
+    void insert(Symbol name, Entry* entry) {
+        if ((size_ + 1) * 4 > slots_.size() * 3) grow();
+        Slot& slot = slots_[find_slot(name.id())];
+        size_ += slot.entry == nullptr;
+        slot = Slot{name.id(), entry};
+    }
+    
+    void clear() {
+        slots_.clear();
+        size_ = 0;
+    }
+    
+private:
+    // A null entry marks an empty slot.
+    struct Slot {
+        uint32_t id = 0;
+        Entry* entry = nullptr;
+    };
+    
+    size_t find_slot(uint32_t id) const {
+        size_t mask = slots_.size() - 1;
+        size_t slot = (id * 0x9E3779B1u) & mask;
+        while (slots_[slot].entry && slots_[slot].id != id) slot = (slot + 1) & mask;
+        return slot;
+    }
+    
+    void grow() {
+        if (!slots_.empty()) detail::count_rehash(HashTable::statistics);
+        std::vector<Slot> old(slots_.empty() ? 16 : slots_.size() * 2);
+        old.swap(slots_);
+        for (const Slot& slot : old) {
+            if (slot.entry) slots_[find_slot(slot.id)] = slot;
+        }
+    }
+    
+    std::vector<Slot> slots_;
+    size_t size_ = 0;
+};
+
+// Folds games into a DatabaseStats one at a time, so statistics can be
+// built from a stream without keeping the games around. With `ratings`,
+// rating histories, tournament scores and the Elo histogram are filled
+// in as well.
+class StatsBuilder {
+public:
+    explicit StatsBuilder(DatabaseStats& stats, bool ratings = false)
+        : stats_(stats), ratings_(ratings) {}
+    
+    // Clears the per-player, per-tournament and result aggregates.
+    void reset();
+    
+    void add(const GameView& game);
+    
+    // Folds rows [begin, end) of a columnar table; same result as adding
+    // the corresponding views one by one.
+    void add(const GameTable& table, size_t begin, size_t end);
+    
+    // Records the game's tournament and player names for the name lists.
+    // Only needed when the names were not already collected while parsing.
+    void track_names(const GameView& game);
+    
+    // Folds in `later`, the aggregates another StatsBuilder built from the
+    // games that follow this one's. Counts are summed and first-appearance
+    // orders are kept, so merging partials left to right gives the same
+    // result as one serial pass. `later` is left empty. Entries taken over
+    // whole keep allocating from the memory resource of `later`, which
+    // must outlive the merged statistics.
+    void merge(DatabaseStats&& later);
+    
+    // Derives percentages, the most active player, the largest tournament
+    // and, if names were tracked, the name lists and unique counts. Ties
+    // go to the alphabetically first name so the result does not depend
+    // on hash order. The per-player pass is split across up to `workers`
+    // threads.
+    void finish(unsigned workers = 1);
+    
+    // Like finish() after rows [begin, end) of `table` were added to
+    // statistics that were already finished: only the players and
+    // tournaments of those rows are revisited, so the cost follows the
+    // number of new games. Name lists are left to the caller.
+    void finish_added(const GameTable& table, size_t begin, size_t end);
+    
+private:
+    PlayerStats& player(Symbol name);
+    PlayerStats* cached_player(Symbol name) const;
+    Tournament* cached_tournament(Symbol name) const;
+    Tournament& tournament(Symbol name);
+    void add_game(Symbol event, Symbol white, Symbol black, Symbol eco, GameResult result);
+    void add_ratings(Symbol event, Symbol white, Symbol black, uint16_t white_elo,
+                     uint16_t black_elo, uint32_t date, GameResult result);
+    void update_player_stats(Symbol white, Symbol black, Symbol eco, GameResult result);
+    void update_tournament_stats(Symbol event, Symbol white, Symbol black);
+    
+    DatabaseStats& stats_;
+    bool ratings_;
+    // Entries by name, so repeated names skip the std::unordered_map lookup.
+    EntryCache<PlayerStats> players_;
+    EntryCache<Tournament> tournaments_;
+    
+    bool tracking_names_ = false;
+    SymbolSet tournament_names_;
+    SymbolSet player_names_;
+};
+
+} // namespace pgn
@@ -0,0 +1,299 @@
+#include "stats_export.hpp"
+#include "parallel.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace pgn {
+
+namespace {
+
+constexpr size_t chunk_rows = 16384;
+constexpr size_t write_buffer_size = 1 << 20;
+
+// Growable character buffer with unchecked appends; reserve() room for a
+// row before writing it.
+class TextBuffer {
+public:
+    void reserve(size_t extra) {
+        if (size_ + extra > data_.size()) data_.resize(std::max(data_.size() * 2, size_ + extra));
+    }
+    
+    void put(char c) { data_[size_++] = c; }
+    
+    void append(std::string_view text) {
+        std::memcpy(&data_[size_], text.data(), text.size());
+        size_ += text.size();
+    }
+    
+    void append_uint(uint64_t value) {
+        static const char digit_pairs[] =
+            "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+            "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+            "8081828384858687888990919293949596979899";
+        char digits[20];
+        char* end = digits + sizeof(digits);
+        char* p = end;
+        while (value >= 100) {
+            p -= 2;
+            std::memcpy(p, digit_pairs + (value % 100) * 2, 2);
+            value /= 100;
+        }
+        if (value >= 10) {
+            p -= 2;
+            std::memcpy(p, digit_pairs + value * 2, 2);
+        } else {
+            *--p = static_cast<char>('0' + value);
+        }
+        append(std::string_view(p, static_cast<size_t>(end - p)));
+    }
+    
+    void append_int(int64_t value) {
+        if (value < 0) {
+            put('-');
+            append_uint(static_cast<uint64_t>(-(value + 1)) + 1);
+        } else {
+            append_uint(static_cast<uint64_t>(value));
+        }
+    }
+    
+    // Fixed two decimals, rounded half away from zero.
+    void append_fixed2(double value) {
+        if (!std::isfinite(value)) {
+            append("0.00");
+            return;
+        }
+        if (value < 0) {
+            put('-');
+            value = -value;
+        }
+        uint64_t hundredths = static_cast<uint64_t>(std::llround(value * 100.0));
+        append_uint(hundredths / 100);
+        put('.');
+        put(static_cast<char>('0' + hundredths % 100 / 10));
+        put(static_cast<char>('0' + hundredths % 10));
+    }
+    
+    // RFC 4180 field: quoted only when it contains a separator, quote or
+    // line break.
+    void append_field(std::string_view text) {
+        if (text.find_first_of(",\"\r\n") == std::string_view::npos) {
+            append(text);
+            return;
+        }
+        put('"');
+        for (char c : text) {
+            if (c == '"') put('"');
+            put(c);
+        }
+        put('"');
+    }
+    
+    std::string_view view() const { return std::string_view(data_.data(), size_); }
+    size_t size() const { return size_; }
+    void clear() { size_ = 0; }
+    
+private:
+    std::vector<char> data_;
+    size_t size_ = 0;
+};
+
+// Worst-case bytes for a field holding `text`, once quoted.
+size_t field_capacity(std::string_view text) {
+    return text.size() * 2 + 2;
+}
+
+class OutputFile {
+public:
+    explicit OutputFile(const std::string& filename) : filename_(filename) {
+        buffer_.resize(write_buffer_size);
+        file_.rdbuf()->pubsetbuf(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+        file_.open(filename, std::ios::binary | std::ios::trunc);
+        if (!file_.is_open()) throw std::runtime_error("Cannot open file: " + filename);
+    }
+    
+    void write(std::string_view data) {
+        file_.write(data.data(), static_cast<std::streamsize>(data.size()));
+    }
+    
+    void write_raw(const void* data, size_t size) {
+        file_.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+    }
+    
+    void pad_to(size_t alignment, size_t written) {
+        static const char zeros[8] = {};
+        write_raw(zeros, (alignment - written % alignment) % alignment);
+    }
+    
+    void close() {
+        file_.close();
+        if (!file_) throw std::runtime_error("Cannot write file: " + filename_);
+    }
+    
+private:
+    std::string filename_;
+    std::vector<char> buffer_;
+    std::ofstream file_;
+};
+
+// Entries of `map` in the order of `names`, followed by any entries the
+// name lists leave out (such as games with an empty player tag).
+template <typename Entry>
+std::vector<const Entry*> ordered_entries(const std::pmr::unordered_map<Symbol, Entry>& map,
+                                          const std::vector<Symbol>& names) {
+    std::vector<const Entry*> entries;
+    entries.reserve(map.size());
+    SymbolSet listed;
+    for (Symbol name : names) {
+        auto it = map.find(name);
+        if (it != map.end() && listed.insert(name)) entries.push_back(&it->second);
+    }
+    if (entries.size() < map.size()) {
+        std::vector<const Entry*> rest;
+        for (const auto& [name, entry] : map) {
+            if (!listed.contains(name)) rest.push_back(&entry);
+        }
+        std::sort(rest.begin(), rest.end(), [](const Entry* a, const Entry* b) { return a->name < b->name; });
+        entries.insert(entries.end(), rest.begin(), rest.end());
+    }
+    return entries;
+}
+
+// Formats rows in chunks of chunk_rows, up to `threads` chunks at a time,
+// and writes the chunks in row order.
+template <typename Row, typename Format>
+void write_csv(const std::string& filename, std::string_view header,
+               const std::vector<const Row*>& rows, unsigned threads, Format format) {
+    OutputFile out(filename);
+    out.write(header);
+    
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    size_t chunks = (rows.size() + chunk_rows - 1) / chunk_rows;
+    size_t batch = threads;
+    std::vector<TextBuffer> buffers(std::min(batch, std::max<size_t>(chunks, 1)));
+    
+    for (size_t first = 0; first < chunks; first += buffers.size()) {
+        size_t count = std::min(buffers.size(), chunks - first);
+        run_parallel(count, [&](size_t slot) {
+            TextBuffer& buffer = buffers[slot];
+            buffer.clear();
+            size_t begin = (first + slot) * chunk_rows;
+            size_t end = std::min(begin + chunk_rows, rows.size());
+            for (size_t i = begin; i < end; ++i) format(*rows[i], buffer);
+        });
+        for (size_t slot = 0; slot < count; ++slot) out.write(buffers[slot].view());
+    }
+    out.close();
+}
+
+} // namespace
+
+void write_player_stats_csv(const DatabaseStats& stats, const std::string& filename,
+                            unsigned threads) {
+    auto rows = ordered_entries(stats.player_stats, stats.player_names);
+    write_csv(filename,
+              "name,total_games,games_as_white,games_as_black,wins,losses,draws,"
+              "win_percentage,draw_percentage,unique_opponents\n",
+              rows, threads, [](const PlayerStats& player, TextBuffer& out) {
+        std::string_view name = player.name;
+        out.reserve(field_capacity(name) + 8 * 21 + 2 * 24);
+        out.append_field(name);
+        for (int value : {player.total_games, player.games_as_white, player.games_as_black,
+                          player.wins, player.losses, player.draws}) {
+            out.put(',');
+            out.append_int(value);
+        }
+        out.put(',');
+        out.append_fixed2(player.win_percentage);
+        out.put(',');
+        out.append_fixed2(player.draw_percentage);
+        out.put(',');
+        out.append_uint(player.opponents.size());
+        out.put('\n');
+    });
+}
+
+void write_tournaments_csv(const DatabaseStats& stats, const std::string& filename,
+                           unsigned threads) {
+    auto rows = ordered_entries(stats.tournaments, stats.tournament_names);
+    write_csv(filename, "name,total_games,unique_players\n", rows, threads,
+              [](const Tournament& tournament, TextBuffer& out) {
+        std::string_view name = tournament.name;
+        out.reserve(field_capacity(name) + 2 * 21 + 1);
+        out.append_field(name);
+        out.put(',');
+        out.append_int(tournament.total_games);
+        out.put(',');
+        out.append_int(tournament.unique_players);
+        out.put('\n');
+    });
+}
+
+void write_stats_binary(const DatabaseStats& stats, const std::string& filename) {
+    auto players = ordered_entries(stats.player_stats, stats.player_names);
+    auto tournaments = ordered_entries(stats.tournaments, stats.tournament_names);
+    
+    std::vector<uint64_t> string_offsets{0};
+    string_offsets.reserve(players.size() + tournaments.size() + 1);
+    for (const PlayerStats* player : players) {
+        string_offsets.push_back(string_offsets.back() + player->name.str().size());
+    }
+    for (const Tournament* tournament : tournaments) {
+        string_offsets.push_back(string_offsets.back() + tournament->name.str().size());
+    }
+    
+    auto player_column = [&](auto field) {
+        std::vector<decltype(field(*players[0]))> column;
+        column.reserve(players.size());
+        for (const PlayerStats* player : players) column.push_back(field(*player));
+        return column;
+    };
+    auto tournament_column = [&](auto field) {
+        std::vector<int32_t> column;
+        column.reserve(tournaments.size());
+        for (const Tournament* tournament : tournaments) column.push_back(field(*tournament));
+        return column;
+    };
+    
+    OutputFile out(filename);
+    auto write_column = [&](const auto& column) {
+        out.write_raw(column.data(), column.size() * sizeof(column[0]));
+    };
+    
+    const char magic[8] = {'P', 'G', 'N', 'S', 'T', 'A', 'T', '1'};
+    uint32_t version = 1;
+    uint32_t byte_order = 0x01020304;
+    uint64_t counts[3] = {players.size(), tournaments.size(), string_offsets.back()};
+    out.write_raw(magic, sizeof(magic));
+    out.write_raw(&version, sizeof(version));
+    out.write_raw(&byte_order, sizeof(byte_order));
+    out.write_raw(counts, sizeof(counts));
+    write_column(string_offsets);
+    for (const PlayerStats* player : players) out.write(player->name.str());
+    for (const Tournament* tournament : tournaments) out.write(tournament->name.str());
+    out.pad_to(8, string_offsets.back());
+    
+    if (!players.empty()) {
+        write_column(player_column([](const PlayerStats& p) { return int32_t(p.total_games); }));
+        write_column(player_column([](const PlayerStats& p) { return int32_t(p.games_as_white); }));
+        write_column(player_column([](const PlayerStats& p) { return int32_t(p.games_as_black); }));
+        write_column(player_column([](const PlayerStats& p) { return int32_t(p.wins); }));
+        write_column(player_column([](const PlayerStats& p) { return int32_t(p.losses); }));
+        write_column(player_column([](const PlayerStats& p) { return int32_t(p.draws); }));
+        write_column(player_column([](const PlayerStats& p) { return int32_t(p.opponents.size()); }));
+        out.pad_to(8, players.size() * 7 * sizeof(int32_t));
+        write_column(player_column([](const PlayerStats& p) { return p.win_percentage; }));
+        write_column(player_column([](const PlayerStats& p) { return p.draw_percentage; }));
+    }
+    write_column(tournament_column([](const Tournament& t) { return t.total_games; }));
+    write_column(tournament_column([](const Tournament& t) { return t.unique_players; }));
+    out.close();
+}
+
+} // namespace pgn
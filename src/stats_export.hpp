@@ -0,0 +1,37 @@
+#pragma once
+#include "pgn/types.hpp"
+#include <string>
+
+namespace pgn {
+
+// Writers behind Parser's export functions. Rows follow the order in which
+// players and tournaments first appeared. Rows are formatted in chunks,
+// `threads` at a time, and written in order through a large buffer; all
+// throw std::runtime_error when the file cannot be written.
+
+// name,total_games,games_as_white,games_as_black,wins,losses,draws,
+// win_percentage,draw_percentage,unique_opponents
+void write_player_stats_csv(const DatabaseStats& stats, const std::string& filename,
+                            unsigned threads);
+
+// name,total_games,unique_players
+void write_tournaments_csv(const DatabaseStats& stats, const std::string& filename,
+                           unsigned threads);
+
+// Little-endian columnar dump of both tables:
+//
+//     char   magic[8] = "PGNSTAT1"
+//     uint32 version, byte_order (0x01020304)
+//     uint64 player_count, tournament_count, string_bytes
+//     uint64 string_offsets[player_count + tournament_count + 1]
+//     char   string_data[string_bytes], zero-padded to 8 bytes
+//     int32  total_games, games_as_white, games_as_black, wins, losses,
+//            draws, unique_opponents            [player_count] each
+//     zero-padded to 8 bytes
+//     double win_percentage, draw_percentage    [player_count] each
+//     int32  total_games, unique_players        [tournament_count] each
+//
+// Names are the strings in order: players first, then tournaments.
+void write_stats_binary(const DatabaseStats& stats, const std::string& filename);
+
+} // namespace pgn
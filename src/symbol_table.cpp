@@ -0,0 +1,171 @@
+#include "pgn/symbol_table.hpp"
+#include "metrics_counters.hpp"
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <mutex>
+#include <ostream>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+namespace pgn {
+
+namespace {
+
+constexpr unsigned segment_bits = 16;
+constexpr size_t segment_size = size_t(1) << segment_bits;
+constexpr size_t max_segments = size_t(1) << (32 - segment_bits);
+constexpr size_t shard_count = 64;
+constexpr size_t block_size = 16 * 1024;
+
+// Interned characters and index for the strings hashing to one shard.
+struct Shard {
+    mutable std::mutex mutex;
+    std::unordered_map<std::string_view, uint32_t> ids;
+    std::vector<std::unique_ptr<char[]>> blocks;
+    char* block = nullptr;
+    size_t block_used = block_size;
+    size_t allocated = 0;
+    
+    const char* store(std::string_view text) {
+        char* out;
+        if (text.size() > block_size / 4) {
+            blocks.push_back(std::make_unique<char[]>(text.size()));
+            allocated += text.size();
+            out = blocks.back().get();
+        } else {
+            if (block_used + text.size() > block_size) {
+                blocks.push_back(std::make_unique<char[]>(block_size));
+                allocated += block_size;
+                block = blocks.back().get();
+                block_used = 0;
+            }
+            out = block + block_used;
+            block_used += text.size();
+        }
+        std::memcpy(out, text.data(), text.size());
+        return out;
+    }
+};
+
+} // namespace
+
+struct SymbolTable::Impl {
+    std::array<Shard, shard_count> shards;
+    std::unique_ptr<std::atomic<std::string_view*>[]> segments;
+    std::mutex segment_mutex;
+    std::atomic<uint32_t> next_id{1};
+    std::atomic<size_t> segments_allocated{0};
+    
+    Impl() : segments(new std::atomic<std::string_view*>[max_segments]()) {}
+    
+    ~Impl() {
+        for (size_t i = 0; i < max_segments; ++i) {
+            delete[] segments[i].load(std::memory_order_relaxed);
+        }
+    }
+    
+    std::string_view* segment(uint32_t id) {
+        auto& slot = segments[id >> segment_bits];
+        std::string_view* seg = slot.load(std::memory_order_acquire);
+        if (seg) return seg;
+        
+        std::lock_guard<std::mutex> lock(segment_mutex);
+        seg = slot.load(std::memory_order_relaxed);
+        if (!seg) {
+            seg = new std::string_view[segment_size];
+            slot.store(seg, std::memory_order_release);
+            segments_allocated++;
+        }
+        return seg;
+    }
+    
+    Shard& shard_for(std::string_view text) {
+        return shards[std::hash<std::string_view>{}(text) % shard_count];
+    }
+};
+
+SymbolTable& SymbolTable::global() {
+    static SymbolTable table;
+    return table;
+}
+
+SymbolTable::SymbolTable() : pimpl(std::make_unique<Impl>()) {
+    pimpl->segment(0)[0] = std::string_view();
+}
+
+SymbolTable::~SymbolTable() = default;
+
+Symbol SymbolTable::intern(std::string_view text) {
+    if (text.empty()) return Symbol();
+    
+    Shard& shard = pimpl->shard_for(text);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    
+    auto it = shard.ids.find(text);
+    if (it != shard.ids.end()) return Symbol(it->second);
+    
+    uint32_t id = pimpl->next_id.fetch_add(1, std::memory_order_relaxed);
+    if (id == 0) {
+        throw std::length_error("Symbol table exhausted");
+    }
+    
+    std::string_view stored(shard.store(text), text.size());
+    pimpl->segment(id)[id & (segment_size - 1)] = stored;
+    size_t buckets = shard.ids.bucket_count();
+    shard.ids.emplace(stored, id);
+    metrics::note_buckets(shard.ids, buckets, HashTable::symbols);
+    return Symbol(id);
+}
+
+std::optional<Symbol> SymbolTable::find(std::string_view text) const {
+    if (text.empty()) return Symbol();
+    
+    Shard& shard = pimpl->shard_for(text);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    
+    auto it = shard.ids.find(text);
+    if (it == shard.ids.end()) return std::nullopt;
+    return Symbol(it->second);
+}
+
+std::string_view SymbolTable::str(Symbol symbol) const {
+    uint32_t id = symbol.id();
+    std::string_view* seg = pimpl->segments[id >> segment_bits].load(std::memory_order_acquire);
+    return seg ? seg[id & (segment_size - 1)] : std::string_view();
+}
+
+size_t SymbolTable::size() const {
+    return pimpl->next_id.load(std::memory_order_relaxed);
+}
+
+size_t SymbolTable::memory_usage() const {
+    size_t total = max_segments * sizeof(std::atomic<std::string_view*>)
+                 + pimpl->segments_allocated.load() * segment_size * sizeof(std::string_view);
+    
+    for (const auto& shard : pimpl->shards) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        total += shard.allocated;
+        total += shard.ids.bucket_count() * sizeof(void*);
+        total += shard.ids.size() * (sizeof(std::string_view) + sizeof(uint32_t) + 2 * sizeof(void*));
+    }
+    return total;
+}
+
+double SymbolTable::load_factor() const {
+    size_t strings = 0;
+    size_t buckets = 0;
+    for (const auto& shard : pimpl->shards) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        strings += shard.ids.size();
+        buckets += shard.ids.bucket_count();
+    }
+    return buckets ? double(strings) / buckets : 0.0;
+}
+
+std::ostream& operator<<(std::ostream& os, Symbol symbol) {
+    return os << symbol.str();
+}
+
+} // namespace pgn